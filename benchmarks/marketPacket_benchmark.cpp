@@ -0,0 +1,234 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+
+#include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketProcessor/marketPacketProcessor.h"
+
+namespace benchmarks
+{
+    using memoryGenerator_t = marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t>;
+    using memoryProcessor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+
+    /**
+     * @brief Builds a capture in memory with exactly numUpdates updates per packet
+     *
+     * @param tradePercent Roughly what percent of the updates are trades, the rest are quotes
+     */
+    std::vector<std::byte> buildCapture(size_t numPackets, size_t numUpdates, size_t tradePercent)
+    {
+        marketPacket::trade_t trade{
+            .updateHeader = {marketPacket::UPDATE_SIZE, marketPacket::updateType_e::TRADE},
+            .tradeSize = static_cast<uint16_t>(marketPacket::rand()),
+            .tradePrice = static_cast<uint64_t>(marketPacket::rand())};
+        std::memcpy(trade.symbol, marketPacket::generateRandomSymbol().c_str(), marketPacket::SYMBOL_LENGTH);
+
+        marketPacket::quote_t quote{
+            .updateHeader = {marketPacket::UPDATE_SIZE, marketPacket::updateType_e::QUOTE}};
+        std::memcpy(quote.symbol, marketPacket::generateRandomSymbol().c_str(), marketPacket::SYMBOL_LENGTH);
+
+        const marketPacket::packetHeader_t ph{
+            static_cast<uint16_t>(marketPacket::PACKET_HEADER_SIZE + numUpdates * marketPacket::UPDATE_SIZE),
+            static_cast<uint16_t>(numUpdates)};
+
+        std::vector<std::byte> capture;
+        capture.reserve(numPackets * ph.packetLength);
+
+        for (size_t i = 0; i < numPackets; i++)
+        {
+            const std::byte *headerBytes = reinterpret_cast<const std::byte *>(&ph);
+            capture.insert(capture.end(), headerBytes, headerBytes + sizeof(ph));
+
+            for (size_t j = 0; j < numUpdates; j++)
+            {
+                const bool isTrade = (marketPacket::rand() % 100) < tradePercent;
+                const std::byte *updateBytes = isTrade ? reinterpret_cast<const std::byte *>(&trade) : reinterpret_cast<const std::byte *>(&quote);
+                capture.insert(capture.end(), updateBytes, updateBytes + marketPacket::UPDATE_SIZE);
+            }
+        }
+
+        return capture;
+    }
+
+    /**
+     * @brief Reports updates/sec, on top of the bytes/sec google benchmark already knows how to do
+     */
+    void setRates(benchmark::State &state, size_t totalUpdates, size_t totalBytes)
+    {
+        state.counters["updates/s"] = benchmark::Counter(static_cast<double>(totalUpdates), benchmark::Counter::kIsRate);
+        state.SetBytesProcessed(totalBytes);
+    }
+
+    /**
+     * Args: packets per call, max updates per packet
+     */
+    void BM_generatePackets(benchmark::State &state)
+    {
+        const size_t numPackets = state.range(0);
+        const size_t numMaxUpdates = state.range(1);
+
+        memoryGenerator_t mpg{marketPacket::memorySink_t{}};
+        mpg.initialize();
+
+        size_t totalUpdates = 0;
+        size_t totalBytes = 0;
+        for (auto _ : state)
+        {
+            mpg.sink().clear();
+            if (mpg.generatePackets(numPackets, numMaxUpdates).has_value())
+            {
+                state.SkipWithError("Generator failed");
+                break;
+            }
+
+            // Packets have a random number of updates in them, so work out how many we actually wrote
+            const size_t bytesWritten = mpg.sink().bytes().size();
+            totalUpdates += (bytesWritten - numPackets * marketPacket::PACKET_HEADER_SIZE) / marketPacket::UPDATE_SIZE;
+            totalBytes += bytesWritten;
+        }
+
+        setRates(state, totalUpdates, totalBytes);
+    }
+
+    /**
+     * Args: packets per call, max updates per packet, number of symbols to draw from
+     */
+    void BM_generatePacketsPooled(benchmark::State &state)
+    {
+        const size_t numPackets = state.range(0);
+        const size_t numMaxUpdates = state.range(1);
+
+        memoryGenerator_t mpg{marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.poolSize = marketPacket::DEFAULT_POOL_SIZE, .numSymbols = static_cast<size_t>(state.range(2))}};
+        mpg.initialize();
+
+        size_t totalUpdates = 0;
+        size_t totalBytes = 0;
+        for (auto _ : state)
+        {
+            mpg.sink().clear();
+            if (mpg.generatePackets(numPackets, numMaxUpdates).has_value())
+            {
+                state.SkipWithError("Generator failed");
+                break;
+            }
+
+            const size_t bytesWritten = mpg.sink().bytes().size();
+            totalUpdates += (bytesWritten - numPackets * marketPacket::PACKET_HEADER_SIZE) / marketPacket::UPDATE_SIZE;
+            totalBytes += bytesWritten;
+        }
+
+        setRates(state, totalUpdates, totalBytes);
+    }
+
+    /**
+     * Args: packets per call, updates per packet, percent of updates that are trades
+     */
+    void BM_processNextPacket(benchmark::State &state)
+    {
+        const size_t numPackets = state.range(0);
+        const size_t numUpdates = state.range(1);
+        const std::vector<std::byte> capture = buildCapture(numPackets, numUpdates, state.range(2));
+
+        for (auto _ : state)
+        {
+            memoryProcessor_t mpp(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{});
+            mpp.initialize();
+
+            if (mpp.processNextPacket(numPackets).has_value())
+            {
+                state.SkipWithError("Processor failed");
+                break;
+            }
+
+            benchmark::DoNotOptimize(mpp.sink().bytes().data());
+        }
+
+        setRates(state, state.iterations() * numPackets * numUpdates, state.iterations() * capture.size());
+    }
+
+    void BM_generateTradeString(benchmark::State &state)
+    {
+        marketPacket::trade_t trade{
+            .tradeSize = static_cast<uint16_t>(marketPacket::rand()),
+            .tradePrice = static_cast<uint64_t>(marketPacket::rand())};
+        std::memcpy(trade.symbol, marketPacket::generateRandomSymbol().c_str(), marketPacket::SYMBOL_LENGTH);
+
+        size_t totalBytes = 0;
+        for (auto _ : state)
+        {
+            std::string tradeStr = marketPacket::generateTradeString(&trade);
+            totalBytes += tradeStr.size();
+            benchmark::DoNotOptimize(tradeStr.data());
+        }
+
+        setRates(state, state.iterations(), totalBytes);
+    }
+
+    /**
+     * What the processor actually uses, for comparison against generateTradeString()
+     */
+    void BM_formatTrade(benchmark::State &state)
+    {
+        marketPacket::trade_t trade{
+            .tradeSize = static_cast<uint16_t>(marketPacket::rand()),
+            .tradePrice = static_cast<uint64_t>(marketPacket::rand())};
+        std::memcpy(trade.symbol, marketPacket::generateRandomSymbol().c_str(), marketPacket::SYMBOL_LENGTH);
+
+        char tradeStr[marketPacket::MAX_TRADE_STRING_LENGTH];
+        size_t totalBytes = 0;
+        for (auto _ : state)
+        {
+            totalBytes += marketPacket::formatTrade(tradeStr, &trade) - tradeStr;
+            benchmark::DoNotOptimize(tradeStr);
+        }
+
+        setRates(state, state.iterations(), totalBytes);
+    }
+
+    void BM_rand(benchmark::State &state)
+    {
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(marketPacket::rand());
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /**
+     * Arg: how many 64 bit words per fill
+     */
+    void BM_rngFill(benchmark::State &state)
+    {
+        marketPacket::xoshiro256ss_t rng(0);
+        std::vector<uint64_t> bits(state.range(0));
+
+        for (auto _ : state)
+        {
+            rng.fill(bits);
+            benchmark::DoNotOptimize(bits.data());
+        }
+
+        state.SetBytesProcessed(state.iterations() * bits.size() * sizeof(uint64_t));
+    }
+
+    void BM_generateRandomSymbol(benchmark::State &state)
+    {
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(marketPacket::generateRandomSymbol());
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    BENCHMARK(BM_generatePackets)->ArgsProduct({{1, 64, 1024}, {1, 16, 512}});
+    BENCHMARK(BM_generatePacketsPooled)->ArgsProduct({{64, 1024}, {16, 512}, {10, 1000}});
+    BENCHMARK(BM_processNextPacket)->ArgsProduct({{1, 64, 1024}, {1, 16, 512}, {0, 50, 100}});
+    BENCHMARK(BM_generateTradeString);
+    BENCHMARK(BM_formatTrade);
+    BENCHMARK(BM_rand);
+    BENCHMARK(BM_rngFill)->Arg(8)->Arg(1024);
+    BENCHMARK(BM_generateRandomSymbol);
+}
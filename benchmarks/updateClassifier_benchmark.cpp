@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketClassify.h"
+#include "marketPacketHelpers/marketPacketHelpers.h"
+
+namespace benchmarks
+{
+    /**
+     * @brief A read buffer's worth of random trades / quotes
+     */
+    std::vector<marketPacket::update_t> randomUpdates(size_t numUpdates)
+    {
+        std::vector<marketPacket::update_t> updates(numUpdates);
+        for (marketPacket::update_t &update : updates)
+        {
+            update.updateHeader = {marketPacket::UPDATE_SIZE, (marketPacket::rand() % 2) ? marketPacket::updateType_e::TRADE : marketPacket::updateType_e::QUOTE};
+        }
+
+        return updates;
+    }
+
+    /**
+     * What readPartBody() used to do: validate, then switch, one update at a time
+     */
+    void BM_classifyPerUpdate(benchmark::State &state)
+    {
+        const size_t numUpdates = state.range(0);
+        std::vector<marketPacket::update_t> updates = randomUpdates(numUpdates);
+        std::vector<const std::byte *> tradeLocs;
+        tradeLocs.reserve(numUpdates);
+
+        for (auto _ : state)
+        {
+            tradeLocs.clear();
+
+            const std::byte *buffer = reinterpret_cast<const std::byte *>(updates.data());
+            size_t bufferOffset = 0;
+            while (bufferOffset < numUpdates * marketPacket::UPDATE_SIZE)
+            {
+                const std::byte *currBufferPos = buffer + bufferOffset;
+                const marketPacket::updateHeader_t *uh = reinterpret_cast<const marketPacket::updateHeader_t *>(currBufferPos);
+                if (!marketPacket::isUpdateValid(uh))
+                {
+                    state.SkipWithError("Invalid update");
+                    break;
+                }
+
+                bufferOffset += uh->length;
+                if (uh->type == marketPacket::updateType_e::TRADE)
+                {
+                    tradeLocs.emplace_back(currBufferPos);
+                }
+            }
+
+            benchmark::DoNotOptimize(tradeLocs.data());
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * numUpdates);
+    }
+
+    template <bool (*classifier_t)(const std::byte *, size_t, uint64_t *)>
+    void BM_classify(benchmark::State &state)
+    {
+        if (classifier_t == marketPacket::classifyUpdatesAvx2 && !marketPacket::cpuSupportsAvx2())
+        {
+            state.SkipWithError("No AVX2 on this machine");
+            return;
+        }
+
+        const size_t numUpdates = state.range(0);
+        std::vector<marketPacket::update_t> updates = randomUpdates(numUpdates);
+        std::vector<uint64_t> tradeMask(marketPacket::tradeMaskWords(numUpdates));
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classifier_t(reinterpret_cast<const std::byte *>(updates.data()), numUpdates, tradeMask.data()));
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * numUpdates);
+    }
+
+    // One full read buffer is what the processor hands over at a time
+    constexpr const int64_t UPDATES_IN_READ_BUF = marketPacket::READ_BUFFER_SIZE / marketPacket::UPDATE_SIZE;
+
+    BENCHMARK(BM_classifyPerUpdate)->Arg(64)->Arg(UPDATES_IN_READ_BUF);
+    BENCHMARK(BM_classify<marketPacket::classifyUpdatesScalar>)->Arg(64)->Arg(UPDATES_IN_READ_BUF);
+    BENCHMARK(BM_classify<marketPacket::classifyUpdatesAvx2>)->Arg(64)->Arg(UPDATES_IN_READ_BUF);
+}
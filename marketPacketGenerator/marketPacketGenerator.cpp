@@ -1,16 +1,17 @@
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <cstring>
-#include <fstream>
-#include <memory>
-#include <vector>
+#include <span>
+#include <string>
 
 #include "marketPacketGenerator.h"
 
 namespace marketPacket
 {
 
-    void marketPacketGenerator_t::initialize()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::initialize()
     {
         // Make sure this only gets called once
         if (m_state != state_t::UNINITIALIZED)
@@ -20,28 +21,39 @@ namespace marketPacket
             return;
         }
 
+        // Generators with the same shared seed all draw from the same updates, whatever their own seeds
+        xoshiro256ss_t sharedRng(m_config.sharedSeed.value_or(0));
+        xoshiro256ss_t &rng = m_config.sharedSeed.has_value() ? sharedRng : m_rng;
+
         // Ideally, these are random every time but we don't *need* it to be
         // And that'd slow down performance by a lot making a random one everytime
         // There are solutions to that, just none of them are simple
         m_trade = trade_t{
             .updateHeader = {sizeof(trade_t), updateType_e::TRADE},
-            .tradeSize = static_cast<uint16_t>(rand()),
-            .tradePrice = static_cast<uint64_t>(rand()),
+            .tradeSize = static_cast<uint16_t>(rng()),
+            .tradePrice = static_cast<uint64_t>(rng()),
         };
 
         m_quote = quote_t{
             .updateHeader = {sizeof(quote_t), updateType_e::QUOTE},
-            .priceLevel = static_cast<uint16_t>(rand()),
-            .priceLevelSize = static_cast<uint64_t>(rand()),
-            .timeOfDay = static_cast<uint64_t>(rand())};
+            .priceLevel = static_cast<uint16_t>(rng()),
+            .priceLevelSize = static_cast<uint64_t>(rng()),
+            .timeOfDay = static_cast<uint64_t>(rng())};
 
-        std::memcpy(m_trade.symbol, generateRandomSymbol().c_str(), SYMBOL_LENGTH);
-        std::memcpy(m_quote.symbol, generateRandomSymbol().c_str(), SYMBOL_LENGTH);
+        std::memcpy(m_trade.symbol, generateRandomSymbol(rng).c_str(), SYMBOL_LENGTH);
+        std::memcpy(m_quote.symbol, generateRandomSymbol(rng).c_str(), SYMBOL_LENGTH);
+
+        // If we want variety, pay for it all up front instead
+        if (m_config.poolSize > 0)
+        {
+            buildPool(rng);
+        }
 
         m_state = state_t::WRITE_HEADER;
     };
 
-    const std::optional<failReason_t> &marketPacketGenerator_t::generatePackets(size_t numPackets, size_t numMaxUpdates)
+    template <byteSink_c sink_t>
+    const std::optional<failReason_t> &basicMarketPacketGenerator_t<sink_t>::generatePackets(size_t numPackets, size_t numMaxUpdates)
     {
         resetPerRunVariables(numPackets, numMaxUpdates);
 
@@ -50,7 +62,21 @@ namespace marketPacket
         return m_failReason;
     };
 
-    void marketPacketGenerator_t::runStateMachine()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::reseed(uint64_t seed, uint64_t sizeSeed)
+    {
+        m_rng = xoshiro256ss_t(seed);
+        m_sizeRng.emplace(sizeSeed);
+
+        // Otherwise every reseed would stream the same stretch of the pool
+        if (!m_pool.empty())
+        {
+            m_poolOffset = m_rng.below(m_pool.size());
+        }
+    }
+
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::runStateMachine()
     {
         while (!m_failReason.has_value())
         {
@@ -78,6 +104,12 @@ namespace marketPacket
                 // Have we written the right number of updates for this packet
                 if (m_numUpdatesWritten == m_numUpdates)
                 {
+                    // Compact packets can only be encoded once every update is in
+                    if (m_config.wireFormat == wireFormat_e::COMPACT)
+                    {
+                        writeCompactPacket();
+                    }
+
                     m_state = state_t::WRITE_HEADER;
                     m_numPacketsWritten++;
 
@@ -102,24 +134,25 @@ namespace marketPacket
         }
     };
 
-    void marketPacketGenerator_t::uninitialized()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::uninitialized()
     {
         m_failReason.emplace(UNINITIALIZED);
         return;
     };
 
-    void marketPacketGenerator_t::writeHeader()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::writeHeader()
     {
         // Figure out how many updates we're going to do this packet
-        // Gives us [1, n_numMaxUpdates]
-        m_numUpdates = rand() % m_numMaxUpdates;
-        m_numUpdates++;
+        m_numUpdates = drawNumUpdates(m_sizeRng.has_value() ? m_sizeRng.value() : m_rng, m_numMaxUpdates);
 
         // This is kind of an annoying write you can't easily pack into the other writes
         m_ph.numMarketUpdates = m_numUpdates;
-        m_ph.packetLength = sizeof(packetHeader_t) + m_numUpdates * sizeof(trade_t);
+        m_ph.packetLength = rawPacketLength(m_numUpdates);
 
-        if (!(m_oStream.write(reinterpret_cast<char *>(&m_ph), sizeof(m_ph))))
+        // Compact headers depend on the body, they go out with it
+        if (m_config.wireFormat == wireFormat_e::RAW && !m_sink.write(reinterpret_cast<const std::byte *>(&m_ph), sizeof(m_ph)))
         {
             m_failReason.emplace(HEADER_WRITE_FAILED);
             return;
@@ -128,22 +161,33 @@ namespace marketPacket
         resetPerPacketVariables();
     };
 
-    void marketPacketGenerator_t::generateUpdates()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::generateUpdates()
     {
+        if (!m_pool.empty())
+        {
+            writePooledUpdates();
+            return;
+        }
+
         size_t numUpdatesToGenerate = UPDATES_IN_WRITE_BUF;
         if (m_numUpdates - m_numUpdatesWritten <= UPDATES_IN_WRITE_BUF)
         {
             numUpdatesToGenerate = m_numUpdates - m_numUpdatesWritten;
         }
 
+        // One draw covers 64 updates, instead of a draw per update
+        m_rng.fill(std::span<uint64_t>(m_updateBits.data(), (numUpdatesToGenerate + 63) / 64));
+
         for (size_t i = 0; i < numUpdatesToGenerate; i++)
         {
             // Pick randomly betweern a trade or quote and write it to buffer
-            const void *srcPtr = (rand() % 2) ? reinterpret_cast<void *>(&m_trade) : reinterpret_cast<void *>(&m_quote);
+            const bool isTrade = (m_updateBits[i / 64] >> (i % 64)) & 1;
+            const void *srcPtr = isTrade ? reinterpret_cast<void *>(&m_trade) : reinterpret_cast<void *>(&m_quote);
             memcpy(&m_updates[i], srcPtr, UPDATE_SIZE);
         }
 
-        if (!(m_oStream.write(reinterpret_cast<char *>(m_updates.data()), numUpdatesToGenerate * sizeof(update_t))))
+        if (!writeUpdates(reinterpret_cast<const std::byte *>(m_updates.data()), numUpdatesToGenerate * sizeof(update_t)))
         {
             m_failReason.emplace(UPDATE_WRITE_FAILED);
             return;
@@ -152,7 +196,120 @@ namespace marketPacket
         m_numUpdatesWritten += numUpdatesToGenerate;
     };
 
-    void marketPacketGenerator_t::resetPerRunVariables(size_t numPackets, size_t numMaxUpdates)
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::buildPool(xoshiro256ss_t &rng)
+    {
+        // Fixed universe of symbols, ranked by how popular they are
+        std::vector<std::string> symbols(std::max<size_t>(m_config.numSymbols, 1));
+        for (std::string &symbol : symbols)
+        {
+            symbol = generateRandomSymbol(rng);
+        }
+
+        // Zipf: the k-th most popular symbol shows up proportionally to 1 / k^s
+        std::vector<double> popularityCdf(symbols.size());
+        double totalWeight = 0;
+        for (size_t rank = 0; rank < symbols.size(); rank++)
+        {
+            totalWeight += 1.0 / std::pow(static_cast<double>(rank + 1), m_config.zipfExponent);
+            popularityCdf[rank] = totalWeight;
+        }
+
+        // Nanoseconds since midnight, start the day at 9:30
+        uint64_t timeOfDay = 34200ull * 1000 * 1000 * 1000;
+
+        m_pool.resize(m_config.poolSize);
+        for (update_t &update : m_pool)
+        {
+            // Uniform in [0, totalWeight), then find which symbol that lands on
+            const double popularity = rng.uniform() * totalWeight;
+            const size_t rank = std::min<size_t>(std::upper_bound(popularityCdf.begin(), popularityCdf.end(), popularity) - popularityCdf.begin(), symbols.size() - 1);
+            const std::string &symbol = symbols[rank];
+
+            timeOfDay += 1 + rng.below(1000);
+
+            if (rng.below(100) < m_config.tradePercent)
+            {
+                trade_t trade{
+                    .updateHeader = {sizeof(trade_t), updateType_e::TRADE},
+                    .tradeSize = static_cast<uint16_t>(1 + rng.below(1000)),
+                    .tradePrice = 1 + rng.below(100000),
+                };
+                std::memcpy(trade.symbol, symbol.c_str(), SYMBOL_LENGTH);
+                std::memcpy(&update, &trade, UPDATE_SIZE);
+            }
+            else
+            {
+                quote_t quote{
+                    .updateHeader = {sizeof(quote_t), updateType_e::QUOTE},
+                    .priceLevel = static_cast<uint16_t>(rng.below(std::max<uint16_t>(m_config.maxPriceLevel, 1))),
+                    .priceLevelSize = rng.below(10000),
+                    .timeOfDay = timeOfDay};
+                std::memcpy(quote.symbol, symbol.c_str(), SYMBOL_LENGTH);
+                std::memcpy(&update, &quote, UPDATE_SIZE);
+            }
+        }
+
+        m_poolOffset = 0;
+    }
+
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::writePooledUpdates()
+    {
+        // No copying, the pool already looks exactly like what goes on the wire
+        // Wraps around the end of the pool as often as it takes. That's at most two writes when the pool holds at least
+        // as many updates as the packet, a small pool just means more of them
+        while (m_numUpdatesWritten < m_numUpdates)
+        {
+            const size_t numUpdatesToWrite = std::min<size_t>(m_numUpdates - m_numUpdatesWritten, m_pool.size() - m_poolOffset);
+
+            if (!writeUpdates(reinterpret_cast<const std::byte *>(&m_pool[m_poolOffset]), numUpdatesToWrite * sizeof(update_t)))
+            {
+                m_failReason.emplace(UPDATE_WRITE_FAILED);
+                return;
+            }
+
+            m_poolOffset = (m_poolOffset + numUpdatesToWrite) % m_pool.size();
+            m_numUpdatesWritten += numUpdatesToWrite;
+        }
+    }
+
+    template <byteSink_c sink_t>
+    bool basicMarketPacketGenerator_t<sink_t>::writeUpdates(const std::byte *updates, size_t numBytes)
+    {
+        if (m_config.wireFormat == wireFormat_e::RAW)
+        {
+            return m_sink.write(updates, numBytes);
+        }
+
+        std::memcpy(m_compactUpdates + m_compactUpdatesUsed, updates, numBytes);
+        m_compactUpdatesUsed += numBytes;
+        return true;
+    }
+
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::writeCompactPacket()
+    {
+        std::byte *packet = m_arena.allocate<std::byte>(PACKET_HEADER_SIZE + maxCompactBodySize(m_numUpdates));
+        std::optional<size_t> bodySize = m_encoder.encode(m_compactUpdates, m_numUpdates, packet + PACKET_HEADER_SIZE);
+        if (!bodySize.has_value())
+        {
+            m_failReason.emplace(UPDATE_WRITE_FAILED);
+            return;
+        }
+
+        m_ph.numMarketUpdates = m_numUpdates | COMPACT_PACKET_FLAG;
+        m_ph.packetLength = PACKET_HEADER_SIZE + bodySize.value();
+        std::memcpy(packet, &m_ph, PACKET_HEADER_SIZE);
+
+        if (!m_sink.write(packet, m_ph.packetLength))
+        {
+            m_failReason.emplace(UPDATE_WRITE_FAILED);
+        }
+    }
+
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::resetPerRunVariables(size_t numPackets, size_t numMaxUpdates)
     {
         // Due to the way the struct is constructed, this number needs to stay in a certain range or we can't interpret it
         if (numMaxUpdates > MAX_UPDATES_ALLOWED_IN_PACKET)
@@ -167,8 +324,22 @@ namespace marketPacket
         m_numPacketsWritten = 0;
     }
 
-    void marketPacketGenerator_t::resetPerPacketVariables()
+    template <byteSink_c sink_t>
+    void basicMarketPacketGenerator_t<sink_t>::resetPerPacketVariables()
     {
         m_numUpdatesWritten = 0;
+
+        // Nothing from the last packet is needed anymore
+        m_arena.reset();
+        if (m_config.wireFormat == wireFormat_e::COMPACT)
+        {
+            m_compactUpdates = m_arena.allocate<std::byte>(m_numUpdates * UPDATE_SIZE);
+            m_compactUpdatesUsed = 0;
+        }
     }
+
+    template class basicMarketPacketGenerator_t<streamSink_t>;
+    template class basicMarketPacketGenerator_t<memorySink_t>;
+    template class basicMarketPacketGenerator_t<uringSink_t>;
+    template class basicMarketPacketGenerator_t<compressedSink_t>;
 };
\ No newline at end of file
@@ -1,28 +1,59 @@
 #pragma once
 
 #include <array>
-#include <iostream>
-#include <fstream>
 #include <optional>
 #include <vector>
 
+#include "marketPacketHelpers/marketPacketArena.h"
+#include "marketPacketHelpers/marketPacketCompact.h"
 #include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketIO/marketPacketCompressed.h"
+#include "marketPacketIO/marketPacketIO.h"
 
 namespace marketPacket
 {
+    constexpr const size_t DEFAULT_POOL_SIZE = 65536;
+    constexpr const size_t DEFAULT_NUM_SYMBOLS = 1000;
+    constexpr const size_t DEFAULT_MAX_PRICE_LEVEL = 64;
+
     /**
-     * Generates packets to an output stream
+     * @brief How the generator should make its updates
+     *
+     * With poolSize == 0 the generator repeats one trade and one quote, which is the cheapest thing it can do.
+     * Otherwise it precomputes poolSize random trades / quotes up front and streams straight out of that pool
      */
-    class marketPacketGenerator_t
+    struct generatorConfig_t
+    {
+        size_t poolSize = 0;                              // Number of precomputed updates, 0 to repeat a single trade / quote
+        size_t numSymbols = DEFAULT_NUM_SYMBOLS;          // How many distinct symbols updates in the pool are spread across
+        double zipfExponent = 1.0;                        // How skewed symbol popularity is. 0 is uniform, ~1 is realistic
+        size_t tradePercent = 50;                         // Roughly what percent of the pool is trades, the rest are quotes
+        uint16_t maxPriceLevel = DEFAULT_MAX_PRICE_LEVEL; // Quotes get price levels in [0, maxPriceLevel)
+        std::optional<uint64_t> seed;                     // Same seed and calls, same bytes out. Random if not set
+        wireFormat_e wireFormat = wireFormat_e::RAW;      // COMPACT packets carry the same updates, see marketPacketCompact.h
+        std::optional<uint64_t> sharedSeed;               // If set, the pool (or single trade / quote) comes from this instead of seed
+    };
+
+    /**
+     * Generates packets to an output sink
+     *
+     * Explicit instantiations live at the bottom of marketPacketGenerator.cpp, add new sinks there
+     */
+    template <byteSink_c sink_t>
+    class basicMarketPacketGenerator_t
     {
     public:
         /**
-         * @brief Construct a new marketPacketGenerator object
+         * @brief Construct a new basicMarketPacketGenerator_t object
          *
-         * @param oStream Where market packets get written to
+         * @param oSink  Where market packets get written to
+         * @param config How updates get made
          */
-        marketPacketGenerator_t(std::ofstream&& oStream)
-            : m_state(state_t::UNINITIALIZED),
+        basicMarketPacketGenerator_t(sink_t&& oSink, const generatorConfig_t &config = generatorConfig_t{})
+            : m_config(config),
+              m_rng(config.seed.value_or(randomSeed())),
+              m_sizeRng(),
+              m_state(state_t::UNINITIALIZED),
               m_failReason(),
               m_numPackets(),
               m_numPacketsWritten(),
@@ -31,7 +62,14 @@ namespace marketPacket
               m_numUpdatesWritten(),
               m_ph(),
               m_updates(),
-              m_oStream(std::move(oStream)){};
+              m_updateBits(),
+              m_pool(),
+              m_poolOffset(),
+              m_encoder(),
+              m_arena(),
+              m_compactUpdates(),
+              m_compactUpdatesUsed(),
+              m_sink(std::move(oSink)){};
 
         /**
          * @brief Sets up class to do work
@@ -49,6 +87,30 @@ namespace marketPacket
          */
         const std::optional<failReason_t> &generatePackets(size_t numPackets, size_t numMaxUpdates);
 
+        /**
+         * @brief Carries on as if we'd just been seeded with seed, keeping the pool (or single trade / quote)
+         *
+         * Packet sizes come from their own generator seeded with sizeSeed, so they can be worked out ahead of time with
+         * drawNumUpdates(). Only makes sense with config.sharedSeed set, otherwise what's kept still came from the old seed
+         */
+        void reseed(uint64_t seed, uint64_t sizeSeed);
+
+        /**
+         * @brief How many updates the next packet gets, [1, numMaxUpdates]
+         */
+        static uint16_t drawNumUpdates(xoshiro256ss_t &rng, size_t numMaxUpdates) { return static_cast<uint16_t>(rng.below(numMaxUpdates) + 1); }
+
+        /**
+         * @brief Bytes a raw packet with numUpdates updates takes up, header and all
+         */
+        static size_t rawPacketLength(uint16_t numUpdates) { return sizeof(packetHeader_t) + numUpdates * sizeof(trade_t); }
+
+        /**
+         * @brief Where we've been writing to. Mostly useful for in memory sinks
+         */
+        const sink_t &sink() const { return m_sink; }
+        sink_t &sink() { return m_sink; }
+
     private:
         /**
          * @brief Possible states for a generator to be in
@@ -67,8 +129,28 @@ namespace marketPacket
          */
         void runStateMachine();
         void uninitialized();   // Tells user generator hasn't been initialized yet
-        void writeHeader();     // Generates some metadata about the packet and writes the header to the stream
-        void generateUpdates(); // Buffered generates and writes updates to stream
+        void writeHeader();     // Generates some metadata about the packet and writes the header to the sink
+        void generateUpdates(); // Buffered generates and writes updates to sink
+
+        /**
+         * @brief Fills m_pool with random updates from rng, according to m_config
+         */
+        void buildPool(xoshiro256ss_t &rng);
+
+        /**
+         * @brief Pool mode version of generateUpdates(). Writes the rest of the packet straight out of the pool
+         */
+        void writePooledUpdates();
+
+        /**
+         * @brief Sends updates to the sink, or holds onto them until the packet is done if it's going out compact
+         */
+        bool writeUpdates(const std::byte *updates, size_t numBytes);
+
+        /**
+         * @brief Encodes every update held onto for this packet and writes the packet, header and all
+         */
+        void writeCompactPacket();
 
         /**
          * @brief Certain variables need to be reset per run and/or per packet
@@ -76,11 +158,15 @@ namespace marketPacket
         void resetPerRunVariables(size_t numPackets, size_t numMaxUpdates);
         void resetPerPacketVariables();
 
+        generatorConfig_t m_config;              // How updates get made
+        xoshiro256ss_t m_rng;                    // Everything random about what we generate comes from here
+        std::optional<xoshiro256ss_t> m_sizeRng; // Except packet sizes, if we've been reseed()ed
+
         state_t m_state;                          // Current state of the generator
         std::optional<failReason_t> m_failReason; // If populated, why we stopped generating
 
         size_t m_numPackets;        // Number of packets we should generate in this run
-        size_t m_numPacketsWritten; // Number of packets we have written to the stream so far in this
+        size_t m_numPacketsWritten; // Number of packets we have written to the sink so far in this
 
         uint16_t m_numMaxUpdates;     // Per packet, what is the max number of updates in said packet
         uint16_t m_numUpdates;        // How many updates we expect to generate in a packet
@@ -89,9 +175,24 @@ namespace marketPacket
         trade_t m_trade; // Trade to write
         quote_t m_quote; // Quote to write
 
-        packetHeader_t m_ph;                                  // Header we write to the stream
+        packetHeader_t m_ph;                                  // Header we write to the sink
         std::array<update_t, UPDATES_IN_WRITE_BUF> m_updates; // Where we store the updates before we write
 
-        std::ofstream m_oStream; // Output stream
+        // One random bit per update in m_updates, picking trade or quote
+        std::array<uint64_t, (UPDATES_IN_WRITE_BUF + 63) / 64> m_updateBits;
+
+        std::vector<update_t> m_pool; // Precomputed updates, empty if we're not in pool mode
+        size_t m_poolOffset;          // Where in the pool the next update comes from
+
+        compactEncoder_t m_encoder;  // Turns a packet's updates into a compact body
+        packetArena_t m_arena;       // Scratch that only lives as long as a packet comes out of here
+        std::byte *m_compactUpdates; // This packet's updates so far, if it's going out compact. Room for all of them
+        size_t m_compactUpdatesUsed; // How many bytes of them we have
+
+        sink_t m_sink; // Output sink
     };
+
+    using marketPacketGenerator_t = basicMarketPacketGenerator_t<streamSink_t>;
+    using uringMarketPacketGenerator_t = basicMarketPacketGenerator_t<uringSink_t>;
+    using compressedMarketPacketGenerator_t = basicMarketPacketGenerator_t<compressedSink_t>;
 };
\ No newline at end of file
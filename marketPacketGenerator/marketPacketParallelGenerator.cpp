@@ -0,0 +1,169 @@
+#include "marketPacketParallelGenerator.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+namespace marketPacket
+{
+    namespace
+    {
+        // What each worker generates its segments with
+        using segmentGenerator_t = basicMarketPacketGenerator_t<memorySink_t>;
+    }
+
+    marketPacketParallelGenerator_t::marketPacketParallelGenerator_t(const std::string &path, const generatorConfig_t &config, size_t numThreads, size_t packetsPerSegment)
+        : m_path(path),
+          m_config(config),
+          m_numThreads(numThreads),
+          m_packetsPerSegment(std::max<size_t>(packetsPerSegment, 1)),
+          m_failReason(),
+          m_fd(-1),
+          m_segments(),
+          m_nextSegment(),
+          m_failed(false),
+          m_failMutex()
+    {
+        if (m_numThreads == 0)
+        {
+            m_numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+    }
+
+    const std::optional<failReason_t> &marketPacketParallelGenerator_t::generatePackets(size_t numPackets, size_t numMaxUpdates)
+    {
+        m_failReason.reset();
+        m_failed = false;
+
+        if (numMaxUpdates > MAX_UPDATES_ALLOWED_IN_PACKET)
+        {
+            m_failReason.emplace(TOO_MANY_UPDATES);
+            return m_failReason;
+        }
+
+        if (m_config.wireFormat != wireFormat_e::RAW)
+        {
+            m_failReason.emplace(COMPACT_NOT_PARALLEL);
+            return m_failReason;
+        }
+
+        // Every seed comes out of this one, in file order, so none of them depend on the number of threads
+        xoshiro256ss_t seeder(m_config.seed.value_or(randomSeed()));
+
+        generatorConfig_t workerConfig = m_config;
+        const uint64_t sharedSeed = seeder();
+        workerConfig.sharedSeed = m_config.sharedSeed.value_or(sharedSeed);
+
+        // Packet sizes are all we need to lay out the file, and they're a draw each
+        m_segments.clear();
+        uint64_t fileSize = 0;
+        for (size_t firstPacket = 0; firstPacket < numPackets; firstPacket += m_packetsPerSegment)
+        {
+            segment_t segment{std::min(m_packetsPerSegment, numPackets - firstPacket), seeder(), seeder(), fileSize, 0};
+
+            xoshiro256ss_t sizeRng(segment.sizeSeed);
+            for (size_t packet = 0; packet < segment.numPackets; packet++)
+            {
+                segment.numBytes += segmentGenerator_t::rawPacketLength(segmentGenerator_t::drawNumUpdates(sizeRng, numMaxUpdates));
+            }
+
+            fileSize += segment.numBytes;
+            m_segments.push_back(segment);
+        }
+
+        m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0)
+        {
+            m_failReason.emplace(OUTPUT_FILE_FAILED);
+            return m_failReason;
+        }
+
+        // Preallocated, so workers can write their segments in any order without the file growing under them
+        // Not every filesystem can fallocate, a sparse file does the job too
+        if (fileSize > 0 && ::posix_fallocate(m_fd, 0, fileSize) != 0 && ::ftruncate(m_fd, fileSize) != 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+            m_failReason.emplace(OUTPUT_FILE_FAILED);
+            return m_failReason;
+        }
+
+        m_nextSegment = 0;
+
+        // No point in more workers than segments
+        const size_t numWorkers = std::min(m_numThreads, m_segments.size());
+        std::vector<std::thread> workers;
+        workers.reserve(numWorkers);
+        for (size_t i = 0; i < numWorkers; i++)
+        {
+            workers.emplace_back(&marketPacketParallelGenerator_t::workerLoop, this, std::cref(workerConfig), numMaxUpdates);
+        }
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        if (::close(m_fd) != 0 && !m_failReason.has_value())
+        {
+            m_failReason.emplace(UPDATE_WRITE_FAILED);
+        }
+
+        m_fd = -1;
+        return m_failReason;
+    }
+
+    void marketPacketParallelGenerator_t::workerLoop(const generatorConfig_t &workerConfig, size_t numMaxUpdates)
+    {
+        // One generator per worker, reseeded per segment. The pool is only built once, and it's the same for everyone
+        segmentGenerator_t generator(memorySink_t{}, workerConfig);
+        generator.initialize();
+
+        for (size_t index = m_nextSegment++; index < m_segments.size() && !m_failed; index = m_nextSegment++)
+        {
+            const segment_t &segment = m_segments[index];
+
+            generator.sink().clear();
+            generator.reseed(segment.seed, segment.sizeSeed);
+
+            const std::optional<failReason_t> &failReason = generator.generatePackets(segment.numPackets, numMaxUpdates);
+            if (failReason.has_value())
+            {
+                fail(failReason.value());
+                return;
+            }
+
+            // The layout was worked out from the same size draws, this can only go wrong if they stop matching
+            const std::vector<std::byte> &bytes = generator.sink().bytes();
+            if (bytes.size() != segment.numBytes)
+            {
+                fail(UPDATE_WRITE_FAILED);
+                return;
+            }
+
+            for (size_t written = 0; written < bytes.size();)
+            {
+                const ssize_t numWritten = ::pwrite(m_fd, bytes.data() + written, bytes.size() - written, segment.fileOffset + written);
+                if (numWritten <= 0)
+                {
+                    fail(UPDATE_WRITE_FAILED);
+                    return;
+                }
+
+                written += numWritten;
+            }
+        }
+    }
+
+    void marketPacketParallelGenerator_t::fail(failReason_t failReason)
+    {
+        std::lock_guard<std::mutex> lock(m_failMutex);
+        if (!m_failReason.has_value())
+        {
+            m_failReason.emplace(failReason);
+        }
+
+        m_failed = true;
+    }
+};
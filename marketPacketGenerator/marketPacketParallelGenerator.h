@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "marketPacketGenerator.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_PACKETS_PER_SEGMENT = 1024;
+
+    /**
+     * Generates one capture file across a pool of threads
+     *
+     * The run is cut into segments of packetsPerSegment packets, and every segment gets its own seeds, drawn from config.seed.
+     * Packet sizes come from a generator of their own, so where every segment lands in the file is known before anything is
+     * generated. The file is preallocated and workers pwrite each segment straight into place, in whatever order they get to them.
+     * Nothing depends on which thread did what, so the same seed and packetsPerSegment give the same bytes with any number of threads.
+     * It's not the same bytes a single basicMarketPacketGenerator_t would make with that seed
+     *
+     * Raw packets only, a compact packet's size isn't known until it's been encoded
+     */
+    class marketPacketParallelGenerator_t
+    {
+    public:
+        /**
+         * @brief Construct a new marketPacketParallelGenerator_t object
+         *
+         * @param path              File to generate into. Replaced, not appended to
+         * @param config            How updates get made. Random if seed isn't set, like everywhere else
+         * @param numThreads        How many workers to generate with. 0 means one per core
+         * @param packetsPerSegment How many packets a worker generates at a time. Part of what decides the bytes that come out
+         */
+        marketPacketParallelGenerator_t(const std::string &path, const generatorConfig_t &config = generatorConfig_t{},
+                                        size_t numThreads = 0, size_t packetsPerSegment = DEFAULT_PACKETS_PER_SEGMENT);
+
+        marketPacketParallelGenerator_t(const marketPacketParallelGenerator_t &) = delete;
+        marketPacketParallelGenerator_t &operator=(const marketPacketParallelGenerator_t &) = delete;
+
+        /**
+         * @brief Writes a file of numPackets packets, each with [1, numMaxUpdates] updates
+         *
+         * @return If we couldn't, why
+         */
+        const std::optional<failReason_t> &generatePackets(size_t numPackets, size_t numMaxUpdates);
+
+    private:
+        /**
+         * @brief A run of packets one worker generates in one go, and where they go in the file
+         */
+        struct segment_t
+        {
+            size_t numPackets;   // Packets in this segment
+            uint64_t seed;       // What the updates come from
+            uint64_t sizeSeed;   // What the packet sizes come from
+            uint64_t fileOffset; // Where the segment starts in the file
+            uint64_t numBytes;   // How much of the file it takes up
+        };
+
+        /**
+         * @brief What every worker runs, until there are no segments left or something fails
+         */
+        void workerLoop(const generatorConfig_t &workerConfig, size_t numMaxUpdates);
+
+        /**
+         * @brief Keeps hold of the first failure, so workers stop picking up segments
+         */
+        void fail(failReason_t failReason);
+
+        std::string m_path;                       // Where the capture goes
+        generatorConfig_t m_config;               // How updates get made
+        size_t m_numThreads;                      // How many workers to generate with
+        size_t m_packetsPerSegment;               // Packets per segment, the last one gets whatever's left
+        std::optional<failReason_t> m_failReason; // Why we stopped generating
+
+        int m_fd;                          // Output file, only open during generatePackets()
+        std::vector<segment_t> m_segments; // This run's segments, in file order
+        std::atomic<size_t> m_nextSegment; // Next segment for a worker to pick up
+        std::atomic<bool> m_failed;        // Set along with m_failReason, so workers don't need the lock to check
+        std::mutex m_failMutex;            // Guards m_failReason while workers are running
+    };
+};
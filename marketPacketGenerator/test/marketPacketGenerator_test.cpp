@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
 
 #include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketGenerator/marketPacketParallelGenerator.h"
 #include "marketPacketProcessor/marketPacketProcessor.h"
 
 namespace test
@@ -8,6 +13,7 @@ namespace test
     // Ideally, this goes into a config file
     const std::string GENERATE_PATH = "./generate_test.dat";
     const std::string OUTPUT_PATH = "./output_test.dat";
+    const std::string PARALLEL_PATH = "./parallel_generate_test.dat";
     constexpr const size_t MANY_PACKETS = 1000;
 
     marketPacket::marketPacketGenerator_t createDefaultGenerator()
@@ -166,4 +172,144 @@ namespace test
         EXPECT_FALSE(mpp.processNextPacket(NUM_PACKETS).has_value());
         EXPECT_EQ(mpp.processNextPacket(1).value(), marketPacket::END_OF_FILE);
     }
-}
\ No newline at end of file
+
+    using memoryGenerator_t = marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t>;
+    using memoryProcessor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+
+    TEST(marketPacketGeneratorTest, pooledManyPacketManyUpdate)
+    {
+        const marketPacket::generatorConfig_t config{.poolSize = 4096, .numSymbols = 100};
+
+        memoryGenerator_t mpg(marketPacket::memorySink_t{}, config);
+        mpg.initialize();
+
+        // Sized so we wrap around the pool a few times
+        EXPECT_FALSE(mpg.generatePackets(MANY_PACKETS, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+
+        memoryProcessor_t mpp(marketPacket::memorySource_t{mpg.sink().bytes()}, marketPacket::memorySink_t{});
+        mpp.initialize();
+
+        EXPECT_FALSE(mpp.processNextPacket(MANY_PACKETS).has_value());
+        EXPECT_EQ(mpp.processNextPacket(1).value(), marketPacket::END_OF_FILE);
+
+        // Only ever pulls from the configured universe of symbols
+        EXPECT_GT(mpp.symbolTable().size(), 1);
+        EXPECT_LE(mpp.symbolTable().size(), config.numSymbols);
+    }
+
+    TEST(marketPacketGeneratorTest, pooledZipfSkew)
+    {
+        // With an exponent of 2, the most popular symbol should be about 60% of everything
+        const marketPacket::generatorConfig_t config{.poolSize = 10000, .numSymbols = 100, .zipfExponent = 2.0};
+
+        memoryGenerator_t mpg(marketPacket::memorySink_t{}, config);
+        mpg.initialize();
+
+        EXPECT_FALSE(mpg.generatePackets(MANY_PACKETS, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+
+        // Walk the packets ourselves, updates all start with the symbol right after their header
+        const std::vector<std::byte> &bytes = mpg.sink().bytes();
+        std::map<std::string, size_t> symbolCounts;
+        size_t numUpdates = 0;
+        for (size_t offset = 0; offset < bytes.size();)
+        {
+            marketPacket::packetHeader_t ph;
+            std::memcpy(&ph, bytes.data() + offset, marketPacket::PACKET_HEADER_SIZE);
+
+            for (size_t i = 0; i < ph.numMarketUpdates; i++)
+            {
+                const std::byte *update = bytes.data() + offset + marketPacket::PACKET_HEADER_SIZE + i * marketPacket::UPDATE_SIZE;
+                symbolCounts[std::string(reinterpret_cast<const char *>(update + sizeof(marketPacket::updateHeader_t)), marketPacket::SYMBOL_LENGTH)]++;
+            }
+
+            numUpdates += ph.numMarketUpdates;
+            offset += ph.packetLength;
+        }
+
+        size_t mostPopular = 0;
+        for (const auto &[symbol, count] : symbolCounts)
+        {
+            mostPopular = std::max(mostPopular, count);
+        }
+
+        EXPECT_GT(mostPopular * 2, numUpdates);
+    }
+
+    TEST(marketPacketGeneratorTest, seededIsReproducible)
+    {
+        for (size_t poolSize : {size_t{0}, size_t{4096}})
+        {
+            const marketPacket::generatorConfig_t config{.poolSize = poolSize, .seed = 1234};
+
+            memoryGenerator_t first(marketPacket::memorySink_t{}, config);
+            memoryGenerator_t second(marketPacket::memorySink_t{}, config);
+            first.initialize();
+            second.initialize();
+
+            EXPECT_FALSE(first.generatePackets(MANY_PACKETS, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+            EXPECT_FALSE(second.generatePackets(MANY_PACKETS, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+
+            EXPECT_EQ(first.sink().bytes(), second.sink().bytes());
+        }
+    }
+
+    /**
+     * @brief Everything in the file at path
+     */
+    std::vector<std::byte> readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> chars{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return std::vector<std::byte>(reinterpret_cast<const std::byte *>(chars.data()), reinterpret_cast<const std::byte *>(chars.data()) + chars.size());
+    }
+
+    TEST(marketPacketGeneratorTest, parallelSameBytesAnyThreadCount)
+    {
+        constexpr const size_t NUM_PACKETS = 1000;
+        constexpr const size_t PACKETS_PER_SEGMENT = 64;
+
+        std::vector<std::byte> pooled;
+        for (size_t poolSize : {size_t{0}, size_t{4096}})
+        {
+            const marketPacket::generatorConfig_t config{.poolSize = poolSize, .numSymbols = 100, .seed = 77};
+
+            std::vector<std::byte> expected;
+            for (size_t numThreads : {1, 2, 3, 8})
+            {
+                marketPacket::marketPacketParallelGenerator_t mpg(PARALLEL_PATH, config, numThreads, PACKETS_PER_SEGMENT);
+                ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS, 100).has_value());
+
+                const std::vector<std::byte> bytes = readFile(PARALLEL_PATH);
+                if (expected.empty())
+                {
+                    expected = bytes;
+                }
+
+                EXPECT_EQ(bytes, expected);
+            }
+
+            // Every packet is whole, and the symbols all come out of one universe
+            memoryProcessor_t mpp(marketPacket::memorySource_t{expected}, marketPacket::memorySink_t{});
+            mpp.initialize();
+
+            EXPECT_FALSE(mpp.processNextPacket(NUM_PACKETS).has_value());
+            EXPECT_EQ(mpp.processNextPacket(1).value(), marketPacket::END_OF_FILE);
+            if (poolSize > 0)
+            {
+                EXPECT_LE(mpp.symbolTable().size(), config.numSymbols);
+            }
+
+            // Segments don't just repeat each other
+            const size_t segmentBytes = std::min<size_t>(1024, expected.size() / 2);
+            EXPECT_NE(std::memcmp(expected.data(), expected.data() + expected.size() - segmentBytes, segmentBytes), 0);
+            pooled = expected;
+        }
+
+        marketPacket::marketPacketParallelGenerator_t otherSeed(PARALLEL_PATH, marketPacket::generatorConfig_t{.poolSize = 4096, .numSymbols = 100, .seed = 78}, 2, PACKETS_PER_SEGMENT);
+        ASSERT_FALSE(otherSeed.generatePackets(NUM_PACKETS, 100).has_value());
+        EXPECT_NE(readFile(PARALLEL_PATH), pooled);
+
+        marketPacket::marketPacketParallelGenerator_t compact(PARALLEL_PATH, marketPacket::generatorConfig_t{.wireFormat = marketPacket::wireFormat_e::COMPACT});
+        EXPECT_EQ(compact.generatePackets(NUM_PACKETS, 100).value(), marketPacket::COMPACT_NOT_PARALLEL);
+    }
+}
@@ -0,0 +1,55 @@
+#include "marketPacketArena.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace marketPacket
+{
+    packetArena_t::packetArena_t(size_t capacity)
+        : m_block(std::make_unique_for_overwrite<std::byte[]>(std::max<size_t>(capacity, 1))),
+          m_capacity(std::max<size_t>(capacity, 1)),
+          m_used(),
+          m_overflow(),
+          m_overflowUsed(),
+          m_numHeapAllocations(1)
+    {
+    }
+
+    void packetArena_t::reset()
+    {
+        // Next time, everything we handed out fits in the one block
+        if (!m_overflow.empty())
+        {
+            m_capacity = std::bit_ceil(std::max(m_capacity, m_used + m_overflowUsed));
+            m_block = std::make_unique_for_overwrite<std::byte[]>(m_capacity);
+            m_numHeapAllocations++;
+
+            m_overflow.clear();
+            m_overflowUsed = 0;
+        }
+
+        m_used = 0;
+    }
+
+    std::byte *packetArena_t::allocateBytes(size_t numBytes, size_t alignment)
+    {
+        // m_block is aligned for anything, so aligning the offset aligns the ptr
+        const size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+        if (offset + numBytes > m_capacity)
+        {
+            return allocateOverflow(numBytes);
+        }
+
+        m_used = offset + numBytes;
+        return m_block.get() + offset;
+    }
+
+    std::byte *packetArena_t::allocateOverflow(size_t numBytes)
+    {
+        // Overflow blocks are only ever used once, so they're exactly as big as they need to be
+        m_overflow.push_back(std::make_unique_for_overwrite<std::byte[]>(std::max<size_t>(numBytes, 1)));
+        m_overflowUsed += numBytes;
+        m_numHeapAllocations++;
+        return m_overflow.back().get();
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_PACKET_ARENA_SIZE = 128 * 1024;
+
+    /**
+     * Monotonic allocator for scratch space that only has to live until the end of a packet
+     *
+     * Allocating is a bump of an offset, and nothing is ever freed on its own. reset() hands everything back at once.
+     * If a packet needs more than the block, the extra comes from overflow blocks, and the next reset() swaps them all
+     * for one block big enough to have held everything. So once the biggest packet has been seen, nothing allocates
+     */
+    class packetArena_t
+    {
+    public:
+        /**
+         * @brief Construct a new packetArena_t object
+         *
+         * @param capacity Bytes to start with. The arena grows past this, it just allocates the first time it does
+         */
+        explicit packetArena_t(size_t capacity = DEFAULT_PACKET_ARENA_SIZE);
+
+        /**
+         * @brief Space for count T's, uninitialized. Good until the next reset()
+         *
+         * Only for types that don't need destructing, nothing gets destructed
+         */
+        template <typename T>
+            requires std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>
+        T *allocate(size_t count)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t));
+            return reinterpret_cast<T *>(allocateBytes(count * sizeof(T), alignof(T)));
+        }
+
+        /**
+         * @brief Forgets everything handed out since the last reset(). Only allocates if we had to overflow since then
+         */
+        void reset();
+
+        /**
+         * @brief Bytes handed out since the last reset(), counting alignment padding
+         */
+        size_t used() const { return m_used + m_overflowUsed; }
+
+        /**
+         * @brief Bytes we can hand out before we have to overflow
+         */
+        size_t capacity() const { return m_capacity; }
+
+        /**
+         * @brief How many times we've gone to the heap, including for the first block. Stops moving once we're warmed up
+         */
+        size_t numHeapAllocations() const { return m_numHeapAllocations; }
+
+    private:
+        std::byte *allocateBytes(size_t numBytes, size_t alignment);
+        std::byte *allocateOverflow(size_t numBytes);
+
+        std::unique_ptr<std::byte[]> m_block; // Where allocations come from
+        size_t m_capacity;                    // Size of m_block
+        size_t m_used;                        // How much of m_block is handed out
+
+        std::vector<std::unique_ptr<std::byte[]>> m_overflow; // Allocations that didn't fit in m_block, since the last reset()
+        size_t m_overflowUsed;                                // Bytes in m_overflow
+
+        size_t m_numHeapAllocations; // See numHeapAllocations()
+    };
+
+    /**
+     * A list of T's with its storage in a packetArena_t, for per packet scratch that would otherwise be a std::vector
+     *
+     * Doesn't grow. reset() it with enough capacity for the packet, after the arena has been reset
+     */
+    template <typename T>
+    class arenaList_t
+    {
+    public:
+        arenaList_t()
+            : m_data(),
+              m_size(),
+              m_capacity(){};
+
+        /**
+         * @brief Empties the list and gives it room for capacity T's out of arena
+         */
+        void reset(packetArena_t &arena, size_t capacity)
+        {
+            m_data = arena.allocate<T>(capacity);
+            m_size = 0;
+            m_capacity = capacity;
+        }
+
+        void emplace_back(const T &value)
+        {
+            assert(m_size < m_capacity);
+            m_data[m_size++] = value;
+        }
+
+        void clear() { m_size = 0; }
+
+        size_t size() const { return m_size; }
+        size_t capacity() const { return m_capacity; }
+        bool full() const { return m_size == m_capacity; }
+
+        const T *begin() const { return m_data; }
+        const T *end() const { return m_data + m_size; }
+
+    private:
+        T *m_data;         // Start of our storage in the arena
+        size_t m_size;     // How many T's are in the list
+        size_t m_capacity; // How many T's fit
+    };
+}
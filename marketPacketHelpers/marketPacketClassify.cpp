@@ -0,0 +1,131 @@
+#include "marketPacketClassify.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MARKET_PACKET_HAS_AVX2_KERNEL 1
+#endif
+
+namespace marketPacket
+{
+    namespace
+    {
+        using classifyFunc_t = bool (*)(const std::byte *, size_t, uint64_t *);
+
+        classifyFunc_t pickClassifier()
+        {
+            return cpuSupportsAvx2() ? classifyUpdatesAvx2 : classifyUpdatesScalar;
+        }
+
+        /**
+         * @brief Scalar classification of updates [first, last), shared by every implementation for leftovers
+         */
+        bool classifyRange(const std::byte *updates, size_t first, size_t last, uint64_t *tradeMask)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                updateHeader_t uh;
+                std::memcpy(&uh, updates + i * UPDATE_SIZE, sizeof(uh));
+
+                if (!isUpdateValid(&uh))
+                {
+                    return false;
+                }
+
+                if (uh.type == updateType_e::TRADE)
+                {
+                    tradeMask[i / UPDATES_PER_MASK_WORD] |= uint64_t{1} << (i % UPDATES_PER_MASK_WORD);
+                }
+            }
+
+            return true;
+        }
+    }
+
+    bool classifyUpdates(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask)
+    {
+        // Only ask the CPU once
+        static const classifyFunc_t classifier = pickClassifier();
+        return classifier(updates, numUpdates, tradeMask);
+    }
+
+    bool classifyUpdatesScalar(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask)
+    {
+        // Nothing to classify, and tradeMask may well be null
+        if (numUpdates == 0)
+        {
+            return true;
+        }
+
+        std::memset(tradeMask, 0, tradeMaskWords(numUpdates) * sizeof(uint64_t));
+        return classifyRange(updates, 0, numUpdates, tradeMask);
+    }
+
+#ifdef MARKET_PACKET_HAS_AVX2_KERNEL
+    bool cpuSupportsAvx2()
+    {
+        return __builtin_cpu_supports("avx2");
+    }
+
+    /**
+     * Gathers the first 4 bytes (length + type + a symbol byte we ignore) of 8 updates at a time,
+     * then checks all 8 lengths and types at once
+     */
+    __attribute__((target("avx2"))) bool classifyUpdatesAvx2(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask)
+    {
+        constexpr const size_t UPDATES_PER_ITERATION = 8;
+        static_assert(UPDATES_PER_MASK_WORD % UPDATES_PER_ITERATION == 0);
+        static_assert(offsetof(updateHeader_t, type) == TYPE_OFFSET);
+
+        if (numUpdates == 0)
+        {
+            return true;
+        }
+
+        std::memset(tradeMask, 0, tradeMaskWords(numUpdates) * sizeof(uint64_t));
+
+        const __m256i offsets = _mm256_setr_epi32(0 * UPDATE_SIZE, 1 * UPDATE_SIZE, 2 * UPDATE_SIZE, 3 * UPDATE_SIZE,
+                                                  4 * UPDATE_SIZE, 5 * UPDATE_SIZE, 6 * UPDATE_SIZE, 7 * UPDATE_SIZE);
+        const __m256i lengthMask = _mm256_set1_epi32(0xFFFF);
+        const __m256i typeMask = _mm256_set1_epi32(0xFF);
+        const __m256i expectedLength = _mm256_set1_epi32(UPDATE_SIZE);
+        const __m256i tradeType = _mm256_set1_epi32(static_cast<uint8_t>(updateType_e::TRADE));
+        const __m256i quoteType = _mm256_set1_epi32(static_cast<uint8_t>(updateType_e::QUOTE));
+
+        const size_t numVectorUpdates = numUpdates - (numUpdates % UPDATES_PER_ITERATION);
+        for (size_t i = 0; i < numVectorUpdates; i += UPDATES_PER_ITERATION)
+        {
+            const __m256i headers = _mm256_i32gather_epi32(reinterpret_cast<const int *>(updates + i * UPDATE_SIZE), offsets, 1);
+
+            const __m256i lengths = _mm256_and_si256(headers, lengthMask);
+            const __m256i types = _mm256_and_si256(_mm256_srli_epi32(headers, 8 * TYPE_OFFSET), typeMask);
+
+            const __m256i lengthOk = _mm256_cmpeq_epi32(lengths, expectedLength);
+            const __m256i isTrade = _mm256_cmpeq_epi32(types, tradeType);
+            const __m256i isQuote = _mm256_cmpeq_epi32(types, quoteType);
+            const __m256i valid = _mm256_and_si256(lengthOk, _mm256_or_si256(isTrade, isQuote));
+
+            if (_mm256_movemask_ps(_mm256_castsi256_ps(valid)) != 0xFF)
+            {
+                return false;
+            }
+
+            const uint64_t tradeBits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(isTrade)));
+            tradeMask[i / UPDATES_PER_MASK_WORD] |= tradeBits << (i % UPDATES_PER_MASK_WORD);
+        }
+
+        return classifyRange(updates, numVectorUpdates, numUpdates, tradeMask);
+    }
+#else
+    bool cpuSupportsAvx2()
+    {
+        return false;
+    }
+
+    bool classifyUpdatesAvx2(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask)
+    {
+        return classifyUpdatesScalar(updates, numUpdates, tradeMask);
+    }
+#endif
+}
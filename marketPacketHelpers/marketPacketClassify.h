@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "marketPacketHelpers.h"
+#include "marketPacketSchema.h"
+
+namespace marketPacket
+{
+    constexpr const size_t UPDATES_PER_MASK_WORD = 64;
+
+    /**
+     * @brief How many mask words it takes to cover numUpdates updates
+     */
+    constexpr size_t tradeMaskWords(size_t numUpdates)
+    {
+        return (numUpdates + UPDATES_PER_MASK_WORD - 1) / UPDATES_PER_MASK_WORD;
+    }
+
+    /**
+     * @brief Checks if uh points to something we'd consider a valid, fixed size, update
+     *
+     * @param uh Ptr to what we assume is the start to an update
+     * @return If both the length and type are something we'd expect
+     */
+    inline bool isUpdateValid(const updateHeader_t *uh)
+    {
+        return defaultSchemaSet_t::isValid(*uh);
+    }
+
+    /**
+     * @brief Validates a run of back to back UPDATE_SIZE updates and marks which of them are trades
+     *
+     * Picks the fastest implementation the CPU we're running on supports, the first time it's called
+     *
+     * @param updates    Start of the first update
+     * @param numUpdates How many updates there are
+     * @param tradeMask  Gets bit i set if update i is a trade. Must have tradeMaskWords(numUpdates) words
+     * @return If every update was valid. tradeMask is meaningless otherwise
+     */
+    bool classifyUpdates(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask);
+
+    /**
+     * @brief Specific implementations of classifyUpdates(). Only exposed for testing and benchmarking
+     *
+     * classifyUpdatesAvx2() must only be called if cpuSupportsAvx2() is true
+     */
+    bool classifyUpdatesScalar(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask);
+    bool classifyUpdatesAvx2(const std::byte *updates, size_t numUpdates, uint64_t *tradeMask);
+    bool cpuSupportsAvx2();
+}
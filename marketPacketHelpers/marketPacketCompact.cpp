@@ -0,0 +1,239 @@
+#include "marketPacketCompact.h"
+
+#include <cstring>
+
+#include "marketPacketClassify.h"
+#include "marketPacketSchema.h"
+
+namespace marketPacket
+{
+    namespace
+    {
+        // Trades and quotes keep their symbol in the same place, so the fixed width pass doesn't care which it's on
+        constexpr const size_t SYMBOL_OFFSET = tradeSymbolField_t::offset;
+        static_assert(SYMBOL_OFFSET == quoteSymbolField_t::offset);
+
+        // Past this many symbols, indexes take 2 bytes
+        constexpr const size_t MAX_NARROW_SYMBOLS = 256;
+
+        std::byte *writeVarint(std::byte *out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                *out++ = static_cast<std::byte>(value | 0x80);
+                value >>= 7;
+            }
+
+            *out++ = static_cast<std::byte>(value);
+            return out;
+        }
+
+        bool readVarint(const std::byte *&pos, const std::byte *end, uint64_t &value)
+        {
+            // Most fields fit in a byte, don't loop for them
+            if (pos < end && static_cast<uint8_t>(*pos) < 0x80)
+            {
+                value = static_cast<uint8_t>(*pos++);
+                return true;
+            }
+
+            value = 0;
+            for (size_t shift = 0; shift < 64 && pos < end; shift += 7)
+            {
+                const uint8_t byte = static_cast<uint8_t>(*pos++);
+                value |= uint64_t{byte & 0x7fu} << shift;
+
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Signed deltas as unsigned, small either way. Wraps, so any two uint64_t's round trip
+         */
+        uint64_t zigzag(uint64_t value, uint64_t last)
+        {
+            const uint64_t delta = value - last;
+            return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+        }
+
+        uint64_t unzigzag(uint64_t encoded, uint64_t last)
+        {
+            return last + ((encoded >> 1) ^ (~(encoded & 1) + 1));
+        }
+    }
+
+    std::optional<size_t> compactEncoder_t::encode(const std::byte *updates, size_t numUpdates, std::byte *out)
+    {
+        m_dictionary.clear();
+        m_symbolIndexes.resize(numUpdates);
+
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            updateHeader_t uh;
+            std::memcpy(&uh, updates + i * UPDATE_SIZE, sizeof(uh));
+            if (!isUpdateValid(&uh))
+            {
+                return std::nullopt;
+            }
+
+            m_symbolIndexes[i] = static_cast<uint16_t>(m_dictionary.intern(reinterpret_cast<const char *>(updates + i * UPDATE_SIZE + SYMBOL_OFFSET)));
+        }
+
+        std::byte *pos = writeVarint(out, m_dictionary.size());
+        for (symbolId_t index = 0; index < m_dictionary.size(); index++)
+        {
+            std::memcpy(pos, m_dictionary.symbol(index).data(), SYMBOL_LENGTH);
+            pos += SYMBOL_LENGTH;
+        }
+
+        const size_t maskBytes = (numUpdates + 7) / 8;
+        std::memset(pos, 0, maskBytes);
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            if (static_cast<updateType_e>(updates[i * UPDATE_SIZE + TYPE_OFFSET]) == updateType_e::TRADE)
+            {
+                pos[i / 8] |= static_cast<std::byte>(1 << (i % 8));
+            }
+        }
+        pos += maskBytes;
+
+        const bool wideIndexes = m_dictionary.size() > MAX_NARROW_SYMBOLS;
+        for (uint16_t index : m_symbolIndexes)
+        {
+            if (wideIndexes)
+            {
+                std::memcpy(pos, &index, sizeof(index));
+                pos += sizeof(index);
+            }
+            else
+            {
+                *pos++ = static_cast<std::byte>(index);
+            }
+        }
+
+        uint64_t lastPrice = 0;
+        uint64_t lastTimeOfDay = 0;
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            const std::byte *update = updates + i * UPDATE_SIZE;
+            if (static_cast<updateType_e>(update[TYPE_OFFSET]) == updateType_e::TRADE)
+            {
+                const uint64_t price = tradePriceField_t::get(update);
+                pos = writeVarint(pos, tradeSizeField_t::get(update));
+                pos = writeVarint(pos, zigzag(price, lastPrice));
+                lastPrice = price;
+            }
+            else
+            {
+                const uint64_t timeOfDay = quoteTimeOfDayField_t::get(update);
+                pos = writeVarint(pos, quotePriceLevelField_t::get(update));
+                pos = writeVarint(pos, quotePriceLevelSizeField_t::get(update));
+                pos = writeVarint(pos, zigzag(timeOfDay, lastTimeOfDay));
+                lastTimeOfDay = timeOfDay;
+            }
+        }
+
+        return pos - out;
+    }
+
+    bool decodeCompactBody(const std::byte *body, size_t bodySize, size_t numUpdates, std::byte *updates, uint64_t *tradeMask)
+    {
+        const std::byte *pos = body;
+        const std::byte *end = body + bodySize;
+
+        uint64_t numSymbols;
+        if (!readVarint(pos, end, numSymbols) || numSymbols > numUpdates || (numSymbols == 0 && numUpdates > 0))
+        {
+            return false;
+        }
+
+        const size_t maskBytes = (numUpdates + 7) / 8;
+        const size_t indexWidth = (numSymbols > MAX_NARROW_SYMBOLS) ? sizeof(uint16_t) : 1;
+        if (static_cast<size_t>(end - pos) < numSymbols * SYMBOL_LENGTH + maskBytes + numUpdates * indexWidth)
+        {
+            return false;
+        }
+
+        const std::byte *dictionary = pos;
+        pos += numSymbols * SYMBOL_LENGTH;
+
+        // The bitmap is already a trade mask, as long as nothing's set past the last update
+        const size_t maskWords = tradeMaskWords(numUpdates);
+        std::memset(tradeMask, 0, maskWords * sizeof(uint64_t));
+        std::memcpy(tradeMask, pos, maskBytes);
+        pos += maskBytes;
+
+        if (numUpdates % UPDATES_PER_MASK_WORD != 0 && (tradeMask[maskWords - 1] >> (numUpdates % UPDATES_PER_MASK_WORD)) != 0)
+        {
+            return false;
+        }
+
+        // Everything fixed width first. No update depends on another here
+        const std::byte *indexes = pos;
+        pos += numUpdates * indexWidth;
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            uint16_t index = static_cast<uint8_t>(indexes[i * indexWidth]);
+            if (indexWidth != 1)
+            {
+                std::memcpy(&index, indexes + i * indexWidth, sizeof(index));
+            }
+
+            if (index >= numSymbols)
+            {
+                return false;
+            }
+
+            const bool isTrade = (tradeMask[i / UPDATES_PER_MASK_WORD] >> (i % UPDATES_PER_MASK_WORD)) & 1;
+            const updateHeader_t uh{static_cast<uint16_t>(UPDATE_SIZE), isTrade ? updateType_e::TRADE : updateType_e::QUOTE};
+
+            std::byte *update = updates + i * UPDATE_SIZE;
+            std::memset(update, 0, UPDATE_SIZE);
+            std::memcpy(update, &uh, sizeof(uh));
+            std::memcpy(update + SYMBOL_OFFSET, dictionary + index * SYMBOL_LENGTH, SYMBOL_LENGTH);
+        }
+
+        // Then the varints, which have to be walked in order
+        uint64_t lastPrice = 0;
+        uint64_t lastTimeOfDay = 0;
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            std::byte *update = updates + i * UPDATE_SIZE;
+            if ((tradeMask[i / UPDATES_PER_MASK_WORD] >> (i % UPDATES_PER_MASK_WORD)) & 1)
+            {
+                uint64_t tradeSize;
+                uint64_t price;
+                if (!readVarint(pos, end, tradeSize) || !readVarint(pos, end, price) || tradeSize > UINT16_MAX)
+                {
+                    return false;
+                }
+
+                lastPrice = unzigzag(price, lastPrice);
+                tradeSizeField_t::set(update, static_cast<uint16_t>(tradeSize));
+                tradePriceField_t::set(update, lastPrice);
+            }
+            else
+            {
+                uint64_t priceLevel;
+                uint64_t priceLevelSize;
+                uint64_t timeOfDay;
+                if (!readVarint(pos, end, priceLevel) || !readVarint(pos, end, priceLevelSize) || !readVarint(pos, end, timeOfDay) || priceLevel > UINT16_MAX)
+                {
+                    return false;
+                }
+
+                lastTimeOfDay = unzigzag(timeOfDay, lastTimeOfDay);
+                quotePriceLevelField_t::set(update, static_cast<uint16_t>(priceLevel));
+                quotePriceLevelSizeField_t::set(update, priceLevelSize);
+                quoteTimeOfDayField_t::set(update, lastTimeOfDay);
+            }
+        }
+
+        return pos == end;
+    }
+}
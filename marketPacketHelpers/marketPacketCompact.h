@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "marketPacketHelpers.h"
+#include "marketPacketSymbolTable.h"
+
+namespace marketPacket
+{
+    /**
+     * Compact packet encoding
+     *
+     * Same packetHeader_t, with COMPACT_PACKET_FLAG set in numMarketUpdates (a raw packet can never have that many updates).
+     * The body is the packet's trades / quotes, laid out for decoding rather than as UPDATE_SIZE structs:
+     *
+     *   varint numSymbols                 Symbols in the packet's dictionary
+     *   numSymbols * SYMBOL_LENGTH        The dictionary, in order of first use
+     *   (numUpdates + 7) / 8 bytes        Bit i set if update i is a trade, same bit order as a trade mask
+     *   numUpdates symbol indexes         Into the dictionary. 1 byte each, 2 if there are more than 256 symbols
+     *   per update, in order:
+     *     trade: varint tradeSize, zigzag varint tradePrice - last tradePrice
+     *     quote: varint priceLevel, varint priceLevelSize, zigzag varint timeOfDay - last timeOfDay
+     *
+     * Deltas start from 0 in every packet, so each packet decodes on its own. Decoding gives back today's layout exactly,
+     * apart from dynamicData, which isn't sent and always comes back zeroed
+     */
+    constexpr const uint16_t COMPACT_PACKET_FLAG = 0x8000;
+
+    /**
+     * @brief How packets are laid out on the wire
+     */
+    enum class wireFormat_e : uint8_t
+    {
+        RAW = 0, // Every update is an UPDATE_SIZE struct
+        COMPACT  // See above
+    };
+
+    constexpr const size_t MAX_VARINT_LENGTH = 10;
+
+    /**
+     * @brief Biggest a compact body for numUpdates updates can possibly be
+     */
+    constexpr size_t maxCompactBodySize(size_t numUpdates)
+    {
+        // Worst case update is a quote with both 64 bit fields at full width
+        constexpr size_t MAX_FIELDS_LENGTH = 3 + 2 * MAX_VARINT_LENGTH;
+        return MAX_VARINT_LENGTH + (numUpdates + 7) / 8 + numUpdates * (SYMBOL_LENGTH + sizeof(uint16_t) + MAX_FIELDS_LENGTH);
+    }
+
+    // The flag has to be free in every raw header, and the biggest compact packet still has to fit in packetLength
+    static_assert(MAX_UPDATES_ALLOWED_IN_PACKET < COMPACT_PACKET_FLAG);
+    static_assert(PACKET_HEADER_SIZE + maxCompactBodySize(MAX_UPDATES_ALLOWED_IN_PACKET) <= std::numeric_limits<decltype(packetHeader_t::packetLength)>::max());
+
+    /**
+     * Encodes packets' worth of UPDATE_SIZE updates into compact bodies
+     *
+     * Holds onto its dictionary between packets so encoding doesn't allocate once it's warmed up
+     */
+    class compactEncoder_t
+    {
+    public:
+        compactEncoder_t()
+            : m_dictionary(),
+              m_symbolIndexes(){};
+
+        /**
+         * @brief Encodes numUpdates back to back UPDATE_SIZE updates
+         *
+         * @param updates    Start of the first update
+         * @param numUpdates How many there are, at most MAX_UPDATES_ALLOWED_IN_PACKET
+         * @param out        Where the body goes. Must have maxCompactBodySize(numUpdates) bytes
+         * @return Bytes of body written, nothing if an update isn't a valid trade / quote
+         */
+        std::optional<size_t> encode(const std::byte *updates, size_t numUpdates, std::byte *out);
+
+    private:
+        symbolTable_t m_dictionary;            // This packet's symbols, IDs are dictionary indexes
+        std::vector<uint16_t> m_symbolIndexes; // Dictionary index of every update in this packet
+    };
+
+    /**
+     * @brief Decodes a compact body back into numUpdates UPDATE_SIZE updates
+     *
+     * The fixed width parts (headers, symbols, the trade mask) go in one pass with no dependencies between updates,
+     * only the varint fields are walked one after another
+     *
+     * @param body       Start of the body
+     * @param bodySize   Bytes in the body. All of them have to be used
+     * @param numUpdates How many updates the header says there are
+     * @param updates    Where the updates go. Must have numUpdates * UPDATE_SIZE bytes
+     * @param tradeMask  Gets bit i set if update i is a trade. Must have tradeMaskWords(numUpdates) words
+     * @return If the body was well formed. updates and tradeMask are meaningless otherwise
+     */
+    bool decodeCompactBody(const std::byte *body, size_t bodySize, size_t numUpdates, std::byte *updates, uint64_t *tradeMask);
+}
@@ -1,28 +1,37 @@
 #include "marketPacketHelpers.h"
 
+#include <charconv>
+#include <cstring>
+
 namespace marketPacket
 {
     size_t rand()
     {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_int_distribution<size_t> dist(0, std::numeric_limits<size_t>::max());
-
-        return dist(gen);
+        return threadRng()();
     }
 
     std::string generateRandomSymbol()
+    {
+        return generateRandomSymbol(threadRng());
+    }
+
+    std::string generateRandomSymbol(xoshiro256ss_t &rng)
     {
         static constexpr const std::string_view alphanum = "0123456789"
                                                            "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                                                            "abcdefghijklmnopqrstuvwxyz";
 
+        // 62^SYMBOL_LENGTH fits comfortably in 64 bits, so one draw covers every character
+        static_assert(SYMBOL_LENGTH <= 10);
+        uint64_t bits = rng();
+
         std::string tmp_s;
         tmp_s.reserve(SYMBOL_LENGTH);
 
-        for (int i = 0; i < SYMBOL_LENGTH; i++)
+        for (size_t i = 0; i < SYMBOL_LENGTH; i++)
         {
-            tmp_s += alphanum[rand() % (sizeof(alphanum) - 1)];
+            tmp_s += alphanum[bits % alphanum.size()];
+            bits /= alphanum.size();
         }
 
         return tmp_s;
@@ -31,23 +40,45 @@ namespace marketPacket
     std::string generateTradeString(const trade_t *t)
     {
         assert(t != nullptr);
-        std::string tradeStr;
-
-        // We *could* make this a compile time computation... but c'mon
-        // sizeof("Trade: ") + SYMBOL_LENGTH +
-        // sizeof(" Size: ") + numDigits(decltype(t->tradeSize)::max())) + 
-        // sizeof(" Price: ") + numDigits(decltype(t->tradePrice)::max())) = 47
-        // Just call it 64
-        tradeStr.reserve(64);
-
-        tradeStr.append("Trade: ");
-        tradeStr.append(t->symbol, SYMBOL_LENGTH); // This one is finicky since the symbol isn't guaranteed to be null-terminated
-        tradeStr.append(" Size: ");
-        tradeStr.append(std::to_string(t->tradeSize));
-        tradeStr.append(" Price: ");
-        tradeStr.append(std::to_string(t->tradePrice));
-        
-
-        return tradeStr;
+
+        char tradeStr[MAX_TRADE_STRING_LENGTH];
+        char *tradeStrEnd = formatTrade(tradeStr, t);
+
+        // Everything except the new line
+        return std::string(tradeStr, tradeStrEnd - 1);
+    }
+
+    char *formatTrade(char *out, const trade_t *t)
+    {
+        assert(t != nullptr);
+
+        static constexpr const std::string_view tradePrefix = "Trade: ";
+        static constexpr const std::string_view sizePrefix = " Size: ";
+        static constexpr const std::string_view pricePrefix = " Price: ";
+
+        char *outEnd = out + MAX_TRADE_STRING_LENGTH;
+
+        std::memcpy(out, tradePrefix.data(), tradePrefix.size());
+        out += tradePrefix.size();
+
+        // This one is finicky since the symbol isn't guaranteed to be null-terminated
+        std::memcpy(out, t->symbol, SYMBOL_LENGTH);
+        out += SYMBOL_LENGTH;
+
+        std::memcpy(out, sizePrefix.data(), sizePrefix.size());
+        out += sizePrefix.size();
+
+        // Can't take a reference to a packed field, copy them out first
+        const uint16_t tradeSize = t->tradeSize;
+        out = std::to_chars(out, outEnd, tradeSize).ptr;
+
+        std::memcpy(out, pricePrefix.data(), pricePrefix.size());
+        out += pricePrefix.size();
+
+        const uint64_t tradePrice = t->tradePrice;
+        out = std::to_chars(out, outEnd, tradePrice).ptr;
+
+        *out++ = '\n';
+        return out;
     }
 }
\ No newline at end of file
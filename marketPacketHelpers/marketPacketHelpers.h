@@ -1,8 +1,12 @@
 #pragma once
 
 #include <assert.h>
-#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
 
+#include "marketPacketRandom.h"
 #include "marketPacketStrings.h"
 
 namespace marketPacket
@@ -59,6 +63,9 @@ namespace marketPacket
     constexpr const size_t READ_BUFFER_SIZE = 16384;
     constexpr const size_t WRITE_BUFFER_SIZE = 16384;
 
+    // "Trade: " + SYMBOL_LENGTH + " Size: " + 5 digits + " Price: " + 20 digits + '\n' = 53, round up
+    constexpr const size_t MAX_TRADE_STRING_LENGTH = 64;
+
     constexpr const size_t UPDATE_SIZE = sizeof(update_t);
     constexpr const size_t PACKET_HEADER_SIZE = sizeof(packetHeader_t);
     constexpr const size_t UPDATES_IN_WRITE_BUF = WRITE_BUFFER_SIZE / sizeof(trade_t);
@@ -70,6 +77,7 @@ namespace marketPacket
     // Aligned buffers generally make life a lot easier
     static_assert(READ_BUFFER_SIZE % UPDATE_SIZE == 0);
     static_assert(WRITE_BUFFER_SIZE % UPDATE_SIZE == 0);
+    static_assert(WRITE_BUFFER_SIZE >= MAX_TRADE_STRING_LENGTH);
 
     // Forcing one size lets us make a lot of assumptions that make things way smoother
     static_assert(sizeof(quote_t) == UPDATE_SIZE);
@@ -78,6 +86,8 @@ namespace marketPacket
     /**
      * @brief rand() is awful as a random number generator. Create our own
      *
+     *  NOTE: Draws from threadRng(), so it's safe to call from any thread. Use seedThreadRng() for reproducible runs
+     *
      * @return size_t
      */
     size_t rand();
@@ -89,6 +99,11 @@ namespace marketPacket
      */
     std::string generateRandomSymbol();
 
+    /**
+     * @brief Same as above, drawing from rng instead of this thread's generator
+     */
+    std::string generateRandomSymbol(xoshiro256ss_t &rng);
+
     /**
      * @brief Transforms raw trade data in human readable format
      *
@@ -98,4 +113,16 @@ namespace marketPacket
      * @return std::string How we want the trade should look to a human
      */
     std::string generateTradeString(const trade_t *t);
+
+    /**
+     * @brief Writes the same thing as generateTradeString(), plus a '\n', straight into a caller's buffer
+     *
+     *  No allocations, this is the one to use in any hot path
+     *  NOTE: This function does NOT error check the ptrs. Assumes a correctly formed trade is behind t
+     *
+     * @param out Where to write to. Must have at least MAX_TRADE_STRING_LENGTH bytes available
+     * @param t trade ptr
+     * @return char* One past the last character written
+     */
+    char *formatTrade(char *out, const trade_t *t);
 }
\ No newline at end of file
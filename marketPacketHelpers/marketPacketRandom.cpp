@@ -0,0 +1,80 @@
+#include "marketPacketRandom.h"
+
+#include <random>
+
+namespace marketPacket
+{
+    namespace
+    {
+        uint64_t splitmix64(uint64_t &x)
+        {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+    }
+
+    xoshiro256ss_t::xoshiro256ss_t(uint64_t seed)
+        : m_s()
+    {
+        // splitmix64 can't produce four zeros in a row, so the state is always valid
+        for (uint64_t &s : m_s)
+        {
+            s = splitmix64(seed);
+        }
+    };
+
+    void xoshiro256ss_t::fill(std::span<uint64_t> out)
+    {
+        // Work on a local copy so the state lives in registers for the whole loop
+        xoshiro256ss_t rng = *this;
+        for (uint64_t &x : out)
+        {
+            x = rng();
+        }
+
+        m_s = rng.m_s;
+    }
+
+    void xoshiro256ss_t::jump()
+    {
+        static constexpr const std::array<uint64_t, 4> JUMP = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                                               0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+
+        std::array<uint64_t, 4> s{};
+        for (uint64_t jump : JUMP)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (jump & (uint64_t{1} << b))
+                {
+                    for (size_t i = 0; i < s.size(); i++)
+                    {
+                        s[i] ^= m_s[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+
+        m_s = s;
+    }
+
+    uint64_t randomSeed()
+    {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }
+
+    xoshiro256ss_t &threadRng()
+    {
+        thread_local xoshiro256ss_t rng(randomSeed());
+        return rng;
+    }
+
+    void seedThreadRng(uint64_t seed)
+    {
+        threadRng() = xoshiro256ss_t(seed);
+    }
+}
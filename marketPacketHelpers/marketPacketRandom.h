@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace marketPacket
+{
+    /**
+     * xoshiro256** (Blackman / Vigna), a small fast generator with 256 bits of state
+     *
+     * Meets UniformRandomBitGenerator so it drops into anything in <random> that wants one.
+     * Not thread safe. Give every thread / generator its own, jump() them apart if they share a seed
+     */
+    class xoshiro256ss_t
+    {
+    public:
+        using result_type = uint64_t;
+
+        /**
+         * @brief Construct a new xoshiro256ss_t object
+         *
+         * @param seed Same seed, same sequence. Expanded into the full state with splitmix64
+         */
+        explicit xoshiro256ss_t(uint64_t seed);
+
+        static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        /**
+         * @brief Next 64 random bits
+         */
+        result_type operator()()
+        {
+            const uint64_t result = rotl(m_s[1] * 5, 7) * 9;
+            const uint64_t t = m_s[1] << 17;
+
+            m_s[2] ^= m_s[0];
+            m_s[3] ^= m_s[1];
+            m_s[1] ^= m_s[2];
+            m_s[0] ^= m_s[3];
+
+            m_s[2] ^= t;
+            m_s[3] = rotl(m_s[3], 45);
+
+            return result;
+        }
+
+        /**
+         * @brief Uniform in [0, bound) without a divide. bound must be > 0
+         */
+        uint64_t below(uint64_t bound)
+        {
+            // Lemire's multiply shift, the bias is at most bound / 2^64
+            return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * bound) >> 64);
+        }
+
+        /**
+         * @brief Uniform in [0, 1), using the top 53 bits
+         */
+        double uniform() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+
+        /**
+         * @brief Fills out with random bits. Same result as calling operator() out.size() times, just quicker
+         */
+        void fill(std::span<uint64_t> out);
+
+        /**
+         * @brief Equivalent to 2^128 calls to operator()
+         *
+         * Seeding once and jumping between threads gives non-overlapping streams
+         */
+        void jump();
+
+    private:
+        static constexpr uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        std::array<uint64_t, 4> m_s; // Never all zero
+    };
+
+    /**
+     * @brief A non-deterministic seed, for when nobody asked for a specific one
+     */
+    uint64_t randomSeed();
+
+    /**
+     * @brief This thread's generator. Seeded with randomSeed() the first time it's used on a thread
+     */
+    xoshiro256ss_t &threadRng();
+
+    /**
+     * @brief Reseeds this thread's generator so everything built on it (rand(), generateRandomSymbol()) is reproducible
+     */
+    void seedThreadRng(uint64_t seed);
+}
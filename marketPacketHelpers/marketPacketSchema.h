@@ -0,0 +1,256 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+#include "marketPacketHelpers.h"
+
+namespace marketPacket
+{
+    /**
+     * Compile time update schemas
+     *
+     * A field_t says what type sits where in an update. An updateSchema_t says which updateType_e an update is, how long
+     * it is and what fields it has. A schemaSet_t is every schema one feed can send. Validation, working out which schema
+     * an update is and dispatching on it all come out of the set as constexpr tables, so a new update type is one more
+     * schema in a set rather than one more case in a switch. Venue specific types are just other updateType_e values,
+     * e.g. static_cast<updateType_e>('X')
+     */
+
+    /**
+     * @brief A T at OFFSET bytes into an update
+     */
+    template <typename T, size_t OFFSET>
+    struct field_t
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        using value_t = T;
+        static constexpr size_t offset = OFFSET;
+        static constexpr size_t end = OFFSET + sizeof(T);
+
+        /**
+         * @brief Reads / writes the field. Wire data isn't aligned, so these always go through memcpy
+         */
+        static T get(const std::byte *update)
+        {
+            T value;
+            std::memcpy(&value, update + OFFSET, sizeof(T));
+            return value;
+        }
+
+        static void set(std::byte *update, const T &value) { std::memcpy(update + OFFSET, &value, sizeof(T)); }
+    };
+
+    /**
+     * @brief If every update of a schema is exactly its size, or at least its size and however long its header says
+     */
+    enum class updateLength_e : uint8_t
+    {
+        FIXED = 0,
+        VARIABLE
+    };
+
+    /**
+     * @brief One kind of update
+     *
+     * @tparam TYPE     What's in the updateHeader_t's type
+     * @tparam SIZE     Exact size of a FIXED update, smallest a VARIABLE one can be
+     * @tparam LENGTH   FIXED or VARIABLE. Variable sized updates are opt in, per schema
+     * @tparam fields_t field_t's the update has. Bytes not covered by a field are just skipped
+     */
+    template <updateType_e TYPE, size_t SIZE, updateLength_e LENGTH, typename... fields_t>
+    struct updateSchema_t
+    {
+        static constexpr updateType_e type = TYPE;
+        static constexpr size_t size = SIZE;
+        static constexpr bool isVariable = (LENGTH == updateLength_e::VARIABLE);
+
+        static_assert(TYPE != updateType_e::INVALID);
+        static_assert(SIZE >= sizeof(updateHeader_t) && SIZE <= std::numeric_limits<decltype(updateHeader_t::length)>::max());
+        static_assert(((fields_t::offset >= sizeof(updateHeader_t) && fields_t::end <= SIZE) && ...), "Every field has to be between the header and SIZE");
+
+        /**
+         * @brief If other_t is one of this schema's fields
+         */
+        template <typename other_t>
+        static constexpr bool has = (std::is_same_v<other_t, fields_t> || ...);
+    };
+
+    /**
+     * Every schema a feed can send, and everything we work out from them at compile time
+     *
+     * Types have to be unique within a set
+     */
+    template <typename... schemas_t>
+    class schemaSet_t
+    {
+    public:
+        static constexpr size_t numSchemas = sizeof...(schemas_t);
+        static constexpr size_t NO_SCHEMA = numSchemas; // What indexOf() gives for a type no schema has
+
+        static_assert(numSchemas > 0 && numSchemas < std::numeric_limits<uint8_t>::max());
+
+        /**
+         * @brief True if every update in the set is one size. That's the only case the fixed size fast paths can take
+         */
+        static constexpr bool isFixedSize = ((!schemas_t::isVariable && schemas_t::size == std::array<size_t, numSchemas>{schemas_t::size...}[0]) && ...);
+        static constexpr size_t fixedSize = isFixedSize ? std::array<size_t, numSchemas>{schemas_t::size...}[0] : 0;
+
+        /**
+         * @brief Position in the set of the schema for type, NO_SCHEMA if there isn't one
+         */
+        static constexpr size_t indexOf(updateType_e type) { return TYPE_TABLE[static_cast<uint8_t>(type)]; }
+
+        /**
+         * @brief If uh is the header of an update one of our schemas describes. Two table lookups, no switch on the type
+         */
+        static constexpr bool isValid(const updateHeader_t &uh)
+        {
+            const size_t index = indexOf(uh.type);
+            return uh.length >= MIN_LENGTH[index] && uh.length <= MAX_LENGTH[index];
+        }
+
+        /**
+         * @brief Calls visitor(schema_t{}, update) with the schema update matches
+         *
+         * Goes through a table of plain function ptrs, built per visitor type at compile time. Nothing virtual
+         *
+         * @return False, without calling anything, if update isn't valid
+         */
+        template <typename visitor_t>
+        static bool dispatch(const std::byte *update, visitor_t &visitor)
+        {
+            updateHeader_t uh;
+            std::memcpy(&uh, update, sizeof(uh));
+            if (!isValid(uh))
+            {
+                return false;
+            }
+
+            DISPATCH_TABLE<visitor_t>[indexOf(uh.type)](update, visitor);
+            return true;
+        }
+
+        /**
+         * @brief Validates and dispatches every update in a run of back to back ones
+         *
+         * Fixed size sets step by fixedSize, everything else steps by each header's length
+         *
+         * @return Bytes of whole updates decoded. Anything after that is the start of an update that didn't fit.
+         *         Nothing if an update wasn't valid
+         */
+        template <typename visitor_t>
+        static std::optional<size_t> decode(const std::byte *updates, size_t numBytes, visitor_t &visitor)
+        {
+            size_t offset = 0;
+            while (numBytes - offset >= sizeof(updateHeader_t))
+            {
+                size_t length = fixedSize;
+                if constexpr (!isFixedSize)
+                {
+                    updateHeader_t uh;
+                    std::memcpy(&uh, updates + offset, sizeof(uh));
+                    length = uh.length;
+                }
+
+                if (numBytes - offset < length)
+                {
+                    break;
+                }
+
+                if (!dispatch(updates + offset, visitor))
+                {
+                    return std::nullopt;
+                }
+
+                offset += length;
+            }
+
+            return offset;
+        }
+
+    private:
+        static constexpr std::array<uint8_t, 256> buildTypeTable()
+        {
+            std::array<uint8_t, 256> table{};
+            table.fill(NO_SCHEMA);
+
+            uint8_t index = 0;
+            ((table[static_cast<uint8_t>(schemas_t::type)] = index++), ...);
+            return table;
+        }
+
+        static constexpr bool typesAreUnique()
+        {
+            constexpr std::array<updateType_e, numSchemas> types{schemas_t::type...};
+            for (size_t i = 0; i < numSchemas; i++)
+            {
+                for (size_t j = i + 1; j < numSchemas; j++)
+                {
+                    if (types[i] == types[j])
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        static_assert(typesAreUnique(), "Two schemas in a set can't share a type");
+
+        template <typename visitor_t, typename schema_t>
+        static void call(const std::byte *update, visitor_t &visitor) { visitor(schema_t{}, update); }
+
+        static constexpr std::array<uint8_t, 256> TYPE_TABLE = buildTypeTable(); // Type byte to schema index
+
+        // Lengths each schema allows, with one past the end for NO_SCHEMA that nothing can satisfy
+        static constexpr std::array<size_t, numSchemas + 1> MIN_LENGTH{schemas_t::size..., 1};
+        static constexpr std::array<size_t, numSchemas + 1> MAX_LENGTH{(schemas_t::isVariable ? std::numeric_limits<decltype(updateHeader_t::length)>::max() : schemas_t::size)..., 0};
+
+        template <typename visitor_t>
+        static constexpr std::array<void (*)(const std::byte *, visitor_t &), numSchemas> DISPATCH_TABLE{&call<visitor_t, schemas_t>...};
+    };
+
+    /**
+     * @brief The layouts in marketPacketHelpers.h, as schemas
+     */
+    using tradeSymbolField_t = field_t<std::array<char, SYMBOL_LENGTH>, offsetof(trade_t, symbol)>;
+    using tradeSizeField_t = field_t<uint16_t, offsetof(trade_t, tradeSize)>;
+    using tradePriceField_t = field_t<uint64_t, offsetof(trade_t, tradePrice)>;
+
+    using quoteSymbolField_t = field_t<std::array<char, SYMBOL_LENGTH>, offsetof(quote_t, symbol)>;
+    using quotePriceLevelField_t = field_t<uint16_t, offsetof(quote_t, priceLevel)>;
+    using quotePriceLevelSizeField_t = field_t<uint64_t, offsetof(quote_t, priceLevelSize)>;
+    using quoteTimeOfDayField_t = field_t<uint64_t, offsetof(quote_t, timeOfDay)>;
+
+    using tradeSchema_t = updateSchema_t<updateType_e::TRADE, sizeof(trade_t), updateLength_e::FIXED, tradeSymbolField_t, tradeSizeField_t, tradePriceField_t>;
+    using quoteSchema_t = updateSchema_t<updateType_e::QUOTE, sizeof(quote_t), updateLength_e::FIXED, quoteSymbolField_t, quotePriceLevelField_t, quotePriceLevelSizeField_t, quoteTimeOfDayField_t>;
+
+    using defaultSchemaSet_t = schemaSet_t<tradeSchema_t, quoteSchema_t>;
+
+    // Everything else assumes the default feed is one fixed size, make sure the schemas agree
+    static_assert(defaultSchemaSet_t::isFixedSize && defaultSchemaSet_t::fixedSize == UPDATE_SIZE);
+
+    /**
+     * @brief Same trades and quotes, but allowed to run past UPDATE_SIZE. Anything past the usual fields is skipped
+     */
+    using variableTradeSchema_t = updateSchema_t<updateType_e::TRADE, sizeof(trade_t), updateLength_e::VARIABLE, tradeSymbolField_t, tradeSizeField_t, tradePriceField_t>;
+    using variableQuoteSchema_t = updateSchema_t<updateType_e::QUOTE, sizeof(quote_t), updateLength_e::VARIABLE, quoteSymbolField_t, quotePriceLevelField_t, quotePriceLevelSizeField_t, quoteTimeOfDayField_t>;
+
+    using variableSchemaSet_t = schemaSet_t<variableTradeSchema_t, variableQuoteSchema_t>;
+
+    /**
+     * @brief What a processor / index given schemas_t walks packets with, whenever it can't take the fixed size fast path
+     *
+     * The default feed's updates can be padded out, so it's walked with variableSchemaSet_t. Any other set is taken as is
+     */
+    template <typename schemas_t>
+    using walkSchemaSet_t = std::conditional_t<std::is_same_v<schemas_t, defaultSchemaSet_t>, variableSchemaSet_t, schemas_t>;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace marketPacket
+{
+    constexpr const size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * Lock free, bounded, single producer / single consumer ring
+     *
+     * Exactly one thread may push and exactly one thread may pop. Head and tail sit on their own cache lines,
+     * and each side keeps a cached copy of the other side's index so it only touches the shared line when it looks full / empty.
+     * Batch push / pop publish once per batch instead of once per element.
+     *
+     * push() / pop() wait when the ring is full / empty. They spin for a little while, then sleep until the other side
+     * makes progress, so a side that's waiting on I/O doesn't cost the other one a core
+     */
+    template <typename T>
+    class spscRing_t
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        /**
+         * @brief Construct a new spscRing_t object
+         *
+         * @param capacity Rounded up to a power of two
+         */
+        explicit spscRing_t(size_t capacity)
+            : m_slots(std::bit_ceil(std::max<size_t>(capacity, 2))),
+              m_mask(m_slots.size() - 1),
+              m_producer(),
+              m_consumer(){};
+
+        spscRing_t(const spscRing_t &) = delete;
+        spscRing_t &operator=(const spscRing_t &) = delete;
+
+        size_t capacity() const { return m_slots.size(); }
+
+        /**
+         * @brief Producer only. Pushes as many of items as fit
+         *
+         * @return How many were pushed, from the front of items
+         */
+        size_t tryPush(std::span<const T> items)
+        {
+            const size_t tail = m_producer.index.load(std::memory_order_relaxed);
+
+            if (capacity() - (tail - m_producer.otherIndex) < items.size())
+            {
+                m_producer.otherIndex = m_consumer.index.load(std::memory_order_acquire);
+            }
+
+            const size_t numToPush = std::min(items.size(), capacity() - (tail - m_producer.otherIndex));
+            for (size_t i = 0; i < numToPush; i++)
+            {
+                m_slots[(tail + i) & m_mask] = items[i];
+            }
+
+            m_producer.index.store(tail + numToPush, std::memory_order_release);
+            if (numToPush > 0)
+            {
+                unpark(m_consumer);
+            }
+
+            return numToPush;
+        }
+
+        bool tryPush(const T &item) { return tryPush(std::span<const T>(&item, 1)) == 1; }
+
+        /**
+         * @brief Consumer only. Pops as many items as are ready, up to out.size()
+         *
+         * @return How many were popped into the front of out
+         */
+        size_t tryPop(std::span<T> out)
+        {
+            const size_t head = m_consumer.index.load(std::memory_order_relaxed);
+
+            if (m_consumer.otherIndex - head < out.size())
+            {
+                m_consumer.otherIndex = m_producer.index.load(std::memory_order_acquire);
+            }
+
+            const size_t numToPop = std::min(out.size(), m_consumer.otherIndex - head);
+            for (size_t i = 0; i < numToPop; i++)
+            {
+                out[i] = m_slots[(head + i) & m_mask];
+            }
+
+            m_consumer.index.store(head + numToPop, std::memory_order_release);
+            if (numToPop > 0)
+            {
+                unpark(m_producer);
+            }
+
+            return numToPop;
+        }
+
+        bool tryPop(T &item) { return tryPop(std::span<T>(&item, 1)) == 1; }
+
+        /**
+         * @brief Producer only. Pushes all of items, waiting whenever the ring is full
+         *
+         * @param stop Gives up waiting once it's set. Whoever sets it has to call wake() afterwards
+         * @return How many were pushed, from the front of items. All of them unless stop was set
+         */
+        size_t push(std::span<const T> items, const std::atomic<bool> &stop)
+        {
+            size_t numPushed = tryPush(items);
+            while (numPushed < items.size() && !stop.load(std::memory_order_acquire))
+            {
+                park(m_producer, [this, &stop]()
+                     { return m_consumer.index.load(std::memory_order_acquire) + capacity() != m_producer.index.load(std::memory_order_relaxed) ||
+                              stop.load(std::memory_order_acquire); });
+
+                numPushed += tryPush(items.subspan(numPushed));
+            }
+
+            return numPushed;
+        }
+
+        /**
+         * @brief Consumer only. Pops as many items as are ready, up to out.size(), waiting if there aren't any
+         *
+         * @param stop Gives up waiting once it's set. Whoever sets it has to call wake() afterwards
+         * @return How many were popped into the front of out. 0 only once stop is set and everything pushed before it is popped
+         */
+        size_t pop(std::span<T> out, const std::atomic<bool> &stop)
+        {
+            while (true)
+            {
+                // Check before popping, so an empty pop after stop really means there's nothing left
+                const bool stopped = stop.load(std::memory_order_acquire);
+
+                const size_t numPopped = tryPop(out);
+                if (numPopped > 0 || stopped)
+                {
+                    return numPopped;
+                }
+
+                park(m_consumer, [this, &stop]()
+                     { return m_producer.index.load(std::memory_order_acquire) != m_consumer.index.load(std::memory_order_relaxed) ||
+                              stop.load(std::memory_order_acquire); });
+            }
+        }
+
+        /**
+         * @brief Wakes whichever side is waiting, so it notices a stop flag was set
+         */
+        void wake()
+        {
+            unpark(m_producer);
+            unpark(m_consumer);
+        }
+
+    private:
+        /**
+         * @brief One side's index, and its last look at the other side's. Written by one thread only
+         */
+        struct alignas(CACHE_LINE_SIZE) side_t
+        {
+            std::atomic<size_t> index;        // Next slot this side will touch. Only ever increases, wraps through m_mask
+            size_t otherIndex;                // Cached copy of the other side's index
+            std::atomic<bool> parked;         // Set while this side is (about to be) asleep, so the other side knows to wake it
+            std::atomic<uint32_t> numWakeups; // What this side sleeps on. Bumped by whoever wakes it
+        };
+
+        static constexpr size_t SPIN_LIMIT = 64; // How many times a waiting side checks again before it goes to sleep
+
+        /**
+         * @brief Waits until ready() is true. Spins for a bit first, since the other side is usually just about to get there
+         */
+        template <typename ready_t>
+        static void park(side_t &self, ready_t ready)
+        {
+            for (size_t spin = 0; spin < SPIN_LIMIT; spin++)
+            {
+                if (ready())
+                {
+                    return;
+                }
+
+                std::this_thread::yield();
+            }
+
+            while (!ready())
+            {
+                const uint32_t numWakeups = self.numWakeups.load(std::memory_order_acquire);
+
+                // Either the other side sees parked and wakes us, or we see what it did when we check again
+                self.parked.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ready())
+                {
+                    self.numWakeups.wait(numWakeups, std::memory_order_acquire);
+                }
+
+                self.parked.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Wakes other if it's asleep. Call after whatever it's waiting on has changed
+         */
+        static void unpark(side_t &other)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (other.parked.load(std::memory_order_relaxed))
+            {
+                other.numWakeups.fetch_add(1, std::memory_order_release);
+                other.numWakeups.notify_one();
+            }
+        }
+
+        std::vector<T> m_slots; // Power of two sized
+        size_t m_mask;          // capacity() - 1
+
+        side_t m_producer; // Tail
+        side_t m_consumer; // Head
+    };
+}
@@ -14,6 +14,8 @@ namespace marketPacket
     static constexpr failReason_t HEADER_WRITE_FAILED{"writeHeader() failed"};
     static constexpr failReason_t UPDATE_WRITE_FAILED{"Update write failed"};
     static constexpr failReason_t TOO_MANY_UPDATES{"Can't request that many updates in a packet"};
+    static constexpr failReason_t OUTPUT_FILE_FAILED{"Output file couldn't be opened or sized"};
+    static constexpr failReason_t COMPACT_NOT_PARALLEL{"Compact packets can't be generated in parallel"};
 
     // Processor specific failures
     static constexpr failReason_t INPUT_STREAM_CLOSED{"Input stream isn't open"};
@@ -26,4 +28,9 @@ namespace marketPacket
 
     static constexpr failReason_t UPDATE_POORLY_FORMED{"Poorly formed update"};
     static constexpr failReason_t TRADE_WRITE_FAILED{"Failure in writing trade to stream"};
+    static constexpr failReason_t QUOTE_WRITE_FAILED{"Failure in writing quote to stream"};
+    static constexpr failReason_t SCHEMA_UPDATE_WRITE_FAILED{"Failure in writing update to sink"};
+
+    static constexpr failReason_t SEEK_TARGET_NOT_INDEXED{"Seek target isn't in the index"};
+    static constexpr failReason_t SEEK_FAILED{"Input source couldn't seek"};
 }
\ No newline at end of file
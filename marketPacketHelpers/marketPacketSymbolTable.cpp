@@ -0,0 +1,126 @@
+#include "marketPacketSymbolTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace marketPacket
+{
+    symbolTable_t::symbolTable_t(size_t expectedSymbols)
+        : m_slots(),
+          m_slotShift(),
+          m_symbols()
+    {
+        // Keep the load factor at or under a half so probes stay short
+        const size_t numSlots = std::bit_ceil(std::max<size_t>(2 * expectedSymbols, 16));
+        m_slots.assign(numSlots, 0);
+        m_slotShift = 64 - std::countr_zero(numSlots);
+        m_symbols.reserve(expectedSymbols);
+    }
+
+    symbolId_t symbolTable_t::intern(const char *symbol)
+    {
+        const uint64_t key = symbolKey(symbol);
+
+        const size_t slotMask = m_slots.size() - 1;
+        for (size_t slot = slotFor(key);; slot = (slot + 1) & slotMask)
+        {
+            const uint64_t entry = m_slots[slot];
+            if (entry == 0)
+            {
+                break;
+            }
+
+            if ((entry & KEY_MASK) == key)
+            {
+                return static_cast<symbolId_t>((entry >> KEY_BITS) - 1);
+            }
+        }
+
+        // Never seen it, hand out the next ID
+        assert(m_symbols.size() < MAX_SYMBOLS);
+        const symbolId_t id = static_cast<symbolId_t>(m_symbols.size());
+
+        std::array<char, SYMBOL_LENGTH> &storedSymbol = m_symbols.emplace_back();
+        std::memcpy(storedSymbol.data(), symbol, SYMBOL_LENGTH);
+
+        if (2 * m_symbols.size() > m_slots.size())
+        {
+            grow();
+        }
+
+        for (size_t slot = slotFor(key);; slot = (slot + 1) & (m_slots.size() - 1))
+        {
+            if (m_slots[slot] == 0)
+            {
+                m_slots[slot] = (uint64_t{id} + 1) << KEY_BITS | key;
+                break;
+            }
+        }
+
+        return id;
+    }
+
+    std::optional<symbolId_t> symbolTable_t::find(std::string_view symbol) const
+    {
+        assert(symbol.size() == SYMBOL_LENGTH);
+        const uint64_t key = symbolKey(symbol.data());
+
+        const size_t slotMask = m_slots.size() - 1;
+        for (size_t slot = slotFor(key);; slot = (slot + 1) & slotMask)
+        {
+            const uint64_t entry = m_slots[slot];
+            if (entry == 0)
+            {
+                return std::nullopt;
+            }
+
+            if ((entry & KEY_MASK) == key)
+            {
+                return static_cast<symbolId_t>((entry >> KEY_BITS) - 1);
+            }
+        }
+    }
+
+    void symbolTable_t::clear()
+    {
+        std::fill(m_slots.begin(), m_slots.end(), 0);
+        m_symbols.clear();
+    }
+
+    uint64_t symbolTable_t::symbolKey(const char *symbol)
+    {
+        uint64_t key = 0;
+        std::memcpy(&key, symbol, SYMBOL_LENGTH);
+        return key;
+    }
+
+    size_t symbolTable_t::slotFor(uint64_t key) const
+    {
+        // Fibonacci hashing, the top bits of the product are well mixed
+        return (key * 0x9E3779B97F4A7C15ull) >> m_slotShift;
+    }
+
+    void symbolTable_t::grow()
+    {
+        std::vector<uint64_t> oldSlots = std::move(m_slots);
+        m_slots.assign(2 * oldSlots.size(), 0);
+        m_slotShift--;
+
+        const size_t slotMask = m_slots.size() - 1;
+        for (uint64_t entry : oldSlots)
+        {
+            if (entry == 0)
+            {
+                continue;
+            }
+
+            size_t slot = slotFor(entry & KEY_MASK);
+            while (m_slots[slot] != 0)
+            {
+                slot = (slot + 1) & slotMask;
+            }
+            m_slots[slot] = entry;
+        }
+    }
+}
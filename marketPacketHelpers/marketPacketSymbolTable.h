@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "marketPacketHelpers.h"
+
+namespace marketPacket
+{
+    using symbolId_t = uint32_t;
+
+    constexpr const size_t DEFAULT_SYMBOL_CAPACITY = 2048;
+
+    /**
+     * Interns SYMBOL_LENGTH symbols into dense IDs, [0, size())
+     *
+     * Anything per symbol downstream (books, aggregations, filters) can index an array with the ID instead of hashing strings.
+     * Open addressing with linear probing, and every slot is a single uint64_t (40 bits of symbol, 24 bits of ID),
+     * so a table for a couple thousand symbols fits comfortably in L1/L2
+     */
+    class symbolTable_t
+    {
+    public:
+        /**
+         * @brief Construct a new symbolTable_t object
+         *
+         * @param expectedSymbols Roughly how many symbols we expect. The table grows past this, it's just slower
+         */
+        explicit symbolTable_t(size_t expectedSymbols = DEFAULT_SYMBOL_CAPACITY);
+
+        /**
+         * @brief Gets the ID for a symbol, handing out the next one if we've never seen it
+         *
+         * @param symbol SYMBOL_LENGTH long, not necessarily null terminated, symbol
+         * @return Its ID
+         */
+        symbolId_t intern(const char *symbol);
+
+        /**
+         * @brief Gets the ID for a symbol without interning it
+         *
+         * @param symbol SYMBOL_LENGTH long symbol
+         * @return Its ID, nothing if we've never seen it
+         */
+        std::optional<symbolId_t> find(std::string_view symbol) const;
+
+        /**
+         * @brief Reverse lookup. id must have come from this table
+         */
+        std::string_view symbol(symbolId_t id) const { return std::string_view(m_symbols[id].data(), SYMBOL_LENGTH); }
+
+        /**
+         * @brief How many symbols we've interned, which is also one past the biggest ID
+         */
+        size_t size() const { return m_symbols.size(); }
+
+        /**
+         * @brief Forgets every symbol, so IDs start from 0 again. Keeps the slots, nothing is freed
+         */
+        void clear();
+
+    private:
+        static constexpr const size_t KEY_BITS = 8 * SYMBOL_LENGTH;
+        static constexpr const uint64_t KEY_MASK = (uint64_t{1} << KEY_BITS) - 1;
+        static constexpr const size_t MAX_SYMBOLS = (uint64_t{1} << (64 - KEY_BITS)) - 1;
+
+        static uint64_t symbolKey(const char *symbol); // Packs a symbol into the low KEY_BITS of an integer
+        size_t slotFor(uint64_t key) const;            // First slot to probe for a key
+        void grow();                                   // Doubles the number of slots and reinserts everything
+
+        std::vector<uint64_t> m_slots;                          // 0 if empty, otherwise (ID + 1) << KEY_BITS | key
+        size_t m_slotShift;                                     // 64 - log2(number of slots), for the multiplicative hash
+        std::vector<std::array<char, SYMBOL_LENGTH>> m_symbols; // Indexed by ID, for reverse lookups
+    };
+}
@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "marketPacketHelpers/marketPacketArena.h"
+#include "marketPacketHelpers/marketPacketClassify.h"
+#include "marketPacketHelpers/marketPacketCompact.h"
 #include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketRandom.h"
+#include "marketPacketHelpers/marketPacketSchema.h"
+#include "marketPacketHelpers/marketPacketSpscRing.h"
+#include "marketPacketHelpers/marketPacketSymbolTable.h"
 
 namespace test
 {
@@ -19,4 +32,498 @@ namespace test
 
         EXPECT_EQ(expectedString, marketPacket::generateTradeString(&trade));
     }
-}
\ No newline at end of file
+
+    TEST(marketPacketHelpersTest, formatTradeLimits)
+    {
+        // This one DOES want the new line, it's what ends up in the output
+        std::string expectedString("Trade: ZZZZZ Size: 65535 Price: 18446744073709551615\n");
+
+        marketPacket::trade_t trade{
+            .tradeSize = std::numeric_limits<uint16_t>::max(),
+            .tradePrice = std::numeric_limits<uint64_t>::max()};
+        memcpy(trade.symbol, "ZZZZZ", marketPacket::SYMBOL_LENGTH);
+
+        char tradeStr[marketPacket::MAX_TRADE_STRING_LENGTH];
+        char *tradeStrEnd = marketPacket::formatTrade(tradeStr, &trade);
+
+        ASSERT_LE(tradeStrEnd - tradeStr, marketPacket::MAX_TRADE_STRING_LENGTH);
+        EXPECT_EQ(expectedString, std::string(tradeStr, tradeStrEnd));
+    }
+
+    /**
+     * @brief Every classifier we have, so each test runs against all of them
+     */
+    std::vector<bool (*)(const std::byte *, size_t, uint64_t *)> allClassifiers()
+    {
+        std::vector<bool (*)(const std::byte *, size_t, uint64_t *)> classifiers{marketPacket::classifyUpdatesScalar, marketPacket::classifyUpdates};
+        if (marketPacket::cpuSupportsAvx2())
+        {
+            classifiers.push_back(marketPacket::classifyUpdatesAvx2);
+        }
+
+        return classifiers;
+    }
+
+    /**
+     * @brief Random trades / quotes, with what we expect the trade mask to be
+     */
+    std::vector<marketPacket::update_t> randomUpdates(size_t numUpdates, std::vector<uint64_t> &expectedMask)
+    {
+        std::vector<marketPacket::update_t> updates(numUpdates);
+        expectedMask.assign(marketPacket::tradeMaskWords(numUpdates), 0);
+
+        for (size_t i = 0; i < numUpdates; i++)
+        {
+            bool isTrade = marketPacket::rand() % 2;
+            updates[i].updateHeader = {marketPacket::UPDATE_SIZE, isTrade ? marketPacket::updateType_e::TRADE : marketPacket::updateType_e::QUOTE};
+            if (isTrade)
+            {
+                expectedMask[i / 64] |= uint64_t{1} << (i % 64);
+            }
+        }
+
+        return updates;
+    }
+
+    TEST(marketPacketHelpersTest, classifyUpdatesMask)
+    {
+        // Odd sizes so we go through the leftover path too
+        for (size_t numUpdates : {0, 1, 7, 8, 63, 64, 65, 301, 512})
+        {
+            std::vector<uint64_t> expectedMask;
+            std::vector<marketPacket::update_t> updates = randomUpdates(numUpdates, expectedMask);
+
+            for (auto classifier : allClassifiers())
+            {
+                // Junk in the mask shouldn't survive
+                std::vector<uint64_t> mask(expectedMask.size(), ~uint64_t{0});
+                ASSERT_TRUE(classifier(reinterpret_cast<const std::byte *>(updates.data()), numUpdates, mask.data()));
+                EXPECT_EQ(mask, expectedMask) << numUpdates << " updates";
+            }
+        }
+
+        // An empty packet may not hand over any buffers at all
+        for (auto classifier : allClassifiers())
+        {
+            EXPECT_TRUE(classifier(nullptr, 0, nullptr));
+        }
+    }
+
+    TEST(marketPacketHelpersTest, classifyUpdatesInvalid)
+    {
+        constexpr const size_t NUM_UPDATES = 100;
+
+        // A bad update anywhere, in the vector path or the leftovers, should get caught
+        for (size_t badIndex : {size_t{0}, size_t{5}, size_t{63}, NUM_UPDATES - 1})
+        {
+            for (marketPacket::updateHeader_t badHeader : {marketPacket::updateHeader_t{12, marketPacket::updateType_e::TRADE},
+                                                           marketPacket::updateHeader_t{marketPacket::UPDATE_SIZE, marketPacket::updateType_e::INVALID},
+                                                           marketPacket::updateHeader_t{marketPacket::UPDATE_SIZE + 256, marketPacket::updateType_e::QUOTE}})
+            {
+                std::vector<uint64_t> mask;
+                std::vector<marketPacket::update_t> updates = randomUpdates(NUM_UPDATES, mask);
+                updates[badIndex].updateHeader = badHeader;
+
+                for (auto classifier : allClassifiers())
+                {
+                    EXPECT_FALSE(classifier(reinterpret_cast<const std::byte *>(updates.data()), NUM_UPDATES, mask.data())) << badIndex;
+                }
+            }
+        }
+    }
+
+    TEST(marketPacketHelpersTest, schemaMatchesStructs)
+    {
+        marketPacket::quote_t quote{
+            .updateHeader = {marketPacket::UPDATE_SIZE, marketPacket::updateType_e::QUOTE},
+            .symbol = {'Q', 'W', 'E', 'R', 'T'},
+            .priceLevel = 7,
+            .priceLevelSize = 1234567,
+            .timeOfDay = 89};
+        const std::byte *update = reinterpret_cast<const std::byte *>(&quote);
+
+        EXPECT_EQ(std::memcmp(marketPacket::quoteSymbolField_t::get(update).data(), quote.symbol, marketPacket::SYMBOL_LENGTH), 0);
+        EXPECT_EQ(marketPacket::quotePriceLevelField_t::get(update), quote.priceLevel);
+        EXPECT_EQ(marketPacket::quotePriceLevelSizeField_t::get(update), quote.priceLevelSize);
+        EXPECT_EQ(marketPacket::quoteTimeOfDayField_t::get(update), quote.timeOfDay);
+
+        static_assert(marketPacket::defaultSchemaSet_t::indexOf(marketPacket::updateType_e::TRADE) == 0);
+        static_assert(marketPacket::defaultSchemaSet_t::indexOf(marketPacket::updateType_e::INVALID) == marketPacket::defaultSchemaSet_t::NO_SCHEMA);
+        static_assert(marketPacket::quoteSchema_t::has<marketPacket::quoteTimeOfDayField_t>);
+        static_assert(!marketPacket::tradeSchema_t::has<marketPacket::quoteTimeOfDayField_t>);
+
+        // Whatever the schemas say has to line up with what the classifiers accept
+        for (uint16_t length : {uint16_t{0}, uint16_t{12}, uint16_t{marketPacket::UPDATE_SIZE}, uint16_t{marketPacket::UPDATE_SIZE + 1}})
+        {
+            for (int type = 0; type < 256; type++)
+            {
+                const marketPacket::updateHeader_t uh{length, static_cast<marketPacket::updateType_e>(type)};
+                const bool expected = length == marketPacket::UPDATE_SIZE && (uh.type == marketPacket::updateType_e::TRADE || uh.type == marketPacket::updateType_e::QUOTE);
+                EXPECT_EQ(marketPacket::defaultSchemaSet_t::isValid(uh), expected) << length << " " << type;
+            }
+        }
+    }
+
+    /**
+     * A venue with its own fixed size type and an opt in variable size one
+     */
+    TEST(marketPacketHelpersTest, schemaCustomSet)
+    {
+        constexpr const marketPacket::updateType_e IMBALANCE = static_cast<marketPacket::updateType_e>('I');
+        constexpr const marketPacket::updateType_e NEWS = static_cast<marketPacket::updateType_e>('N');
+
+        using imbalanceQtyField_t = marketPacket::field_t<uint32_t, 3>;
+        using newsIdField_t = marketPacket::field_t<uint16_t, 3>;
+
+        using imbalanceSchema_t = marketPacket::updateSchema_t<IMBALANCE, 8, marketPacket::updateLength_e::FIXED, imbalanceQtyField_t>;
+        using newsSchema_t = marketPacket::updateSchema_t<NEWS, 5, marketPacket::updateLength_e::VARIABLE, newsIdField_t>;
+        using venueSet_t = marketPacket::schemaSet_t<marketPacket::tradeSchema_t, imbalanceSchema_t, newsSchema_t>;
+
+        static_assert(!venueSet_t::isFixedSize);
+
+        // Trade, imbalance, news with 10 bytes of text, then half an imbalance
+        std::vector<std::byte> bytes(marketPacket::UPDATE_SIZE + 8 + 15 + 4);
+        std::byte *update = bytes.data();
+
+        marketPacket::updateHeader_t uh{marketPacket::UPDATE_SIZE, marketPacket::updateType_e::TRADE};
+        std::memcpy(update, &uh, sizeof(uh));
+        marketPacket::tradePriceField_t::set(update, 42);
+        update += uh.length;
+
+        uh = {8, IMBALANCE};
+        std::memcpy(update, &uh, sizeof(uh));
+        imbalanceQtyField_t::set(update, 1000);
+        update += uh.length;
+
+        uh = {15, NEWS};
+        std::memcpy(update, &uh, sizeof(uh));
+        newsIdField_t::set(update, 7);
+        update += uh.length;
+
+        uh = {8, IMBALANCE};
+        std::memcpy(update, &uh, sizeof(uh));
+
+        uint64_t sum = 0;
+        size_t numNews = 0;
+        auto visitor = [&sum, &numNews](auto schema, const std::byte *u)
+        {
+            using schema_t = decltype(schema);
+            if constexpr (std::is_same_v<schema_t, marketPacket::tradeSchema_t>)
+            {
+                sum += marketPacket::tradePriceField_t::get(u);
+            }
+            else if constexpr (std::is_same_v<schema_t, imbalanceSchema_t>)
+            {
+                sum += imbalanceQtyField_t::get(u);
+            }
+            else
+            {
+                sum += newsIdField_t::get(u);
+                numNews++;
+            }
+        };
+
+        std::optional<size_t> decoded = venueSet_t::decode(bytes.data(), bytes.size(), visitor);
+        ASSERT_TRUE(decoded.has_value());
+        EXPECT_EQ(decoded.value(), bytes.size() - 4);
+        EXPECT_EQ(sum, 42 + 1000 + 7);
+        EXPECT_EQ(numNews, 1);
+
+        // Shorter than the schema allows
+        uh = {4, NEWS};
+        std::memcpy(bytes.data() + marketPacket::UPDATE_SIZE + 8, &uh, sizeof(uh));
+        EXPECT_FALSE(venueSet_t::decode(bytes.data(), bytes.size(), visitor).has_value());
+
+        // Quotes aren't part of this venue
+        EXPECT_FALSE(venueSet_t::isValid(marketPacket::updateHeader_t{marketPacket::UPDATE_SIZE, marketPacket::updateType_e::QUOTE}));
+    }
+
+    TEST(marketPacketHelpersTest, symbolTableDenseIds)
+    {
+        marketPacket::symbolTable_t symbolTable;
+
+        EXPECT_EQ(symbolTable.intern("AAAAA"), 0);
+        EXPECT_EQ(symbolTable.intern("BBBBB"), 1);
+        EXPECT_EQ(symbolTable.intern("AAAAA"), 0);
+        EXPECT_EQ(symbolTable.size(), 2);
+
+        EXPECT_EQ(symbolTable.find("BBBBB").value(), 1);
+        EXPECT_FALSE(symbolTable.find("CCCCC").has_value());
+        EXPECT_EQ(symbolTable.symbol(1), "BBBBB");
+    }
+
+    TEST(marketPacketHelpersTest, symbolTableGrows)
+    {
+        // Start tiny so we have to rehash plenty of times
+        marketPacket::symbolTable_t symbolTable(1);
+        std::vector<std::string> symbols;
+
+        for (size_t i = 0; i < 5000; i++)
+        {
+            std::string symbol = marketPacket::generateRandomSymbol();
+            marketPacket::symbolId_t id = symbolTable.intern(symbol.c_str());
+
+            // Random symbols can collide, which should give back the same ID
+            if (id == symbols.size())
+            {
+                symbols.push_back(symbol);
+            }
+            ASSERT_EQ(symbols[id], symbol);
+        }
+
+        ASSERT_EQ(symbolTable.size(), symbols.size());
+        for (size_t id = 0; id < symbols.size(); id++)
+        {
+            EXPECT_EQ(symbolTable.find(symbols[id]).value(), id);
+            EXPECT_EQ(symbolTable.symbol(id), symbols[id]);
+        }
+    }
+
+    TEST(marketPacketHelpersTest, rngDeterministic)
+    {
+        marketPacket::xoshiro256ss_t a(42);
+        marketPacket::xoshiro256ss_t b(42);
+        marketPacket::xoshiro256ss_t c(43);
+
+        // Batch fill has to line up exactly with one at a time
+        std::vector<uint64_t> filled(100);
+        a.fill(filled);
+
+        bool anyDifferent = false;
+        for (uint64_t x : filled)
+        {
+            EXPECT_EQ(x, b());
+            anyDifferent |= (x != c());
+        }
+        EXPECT_TRUE(anyDifferent);
+
+        // Including picking up where the fill left off
+        EXPECT_EQ(a(), b());
+
+        // Same for everything built on this thread's generator
+        marketPacket::seedThreadRng(7);
+        const std::string symbol = marketPacket::generateRandomSymbol();
+        marketPacket::seedThreadRng(7);
+        EXPECT_EQ(symbol, marketPacket::generateRandomSymbol());
+    }
+
+    TEST(marketPacketHelpersTest, rngJumpAndBounds)
+    {
+        marketPacket::xoshiro256ss_t a(1);
+        marketPacket::xoshiro256ss_t b(1);
+        b.jump();
+
+        EXPECT_NE(a(), b());
+
+        for (size_t i = 0; i < 10000; i++)
+        {
+            EXPECT_LT(a.below(62), 62);
+
+            const double u = a.uniform();
+            EXPECT_GE(u, 0.0);
+            EXPECT_LT(u, 1.0);
+        }
+    }
+
+    /**
+     * Allocations are aligned and don't overlap, and once a packet has overflowed the arena the next reset() makes room for it
+     */
+    TEST(marketPacketHelpersTest, packetArenaGrowsOnce)
+    {
+        marketPacket::packetArena_t arena(256);
+        EXPECT_EQ(arena.numHeapAllocations(), 1);
+
+        std::byte *bytes = arena.allocate<std::byte>(3);
+        uint64_t *words = arena.allocate<uint64_t>(4);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(words) % alignof(uint64_t), 0);
+        EXPECT_GE(reinterpret_cast<std::byte *>(words), bytes + 3);
+        EXPECT_EQ(arena.numHeapAllocations(), 1);
+
+        // Three times what fits, so this packet has to overflow
+        for (size_t packet = 0; packet < 3; packet++)
+        {
+            arena.reset();
+            EXPECT_EQ(arena.used(), 0);
+
+            marketPacket::arenaList_t<uint64_t> list;
+            list.reset(arena, 96);
+            for (uint64_t i = 0; i < 96; i++)
+            {
+                list.emplace_back(i);
+            }
+
+            EXPECT_TRUE(list.full());
+            uint64_t expected = 0;
+            for (uint64_t value : list)
+            {
+                EXPECT_EQ(value, expected++);
+            }
+        }
+
+        // One overflow block, then one block that fits everything. Nothing after that
+        EXPECT_EQ(arena.numHeapAllocations(), 3);
+        EXPECT_GE(arena.capacity(), 96 * sizeof(uint64_t));
+    }
+
+    /**
+     * Extreme values, prices / times going both ways, and enough symbols to need wide indexes all have to come back exactly
+     */
+    TEST(marketPacketHelpersTest, compactRoundTrip)
+    {
+        constexpr const size_t NUM_UPDATES = marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET;
+
+        marketPacket::xoshiro256ss_t rng(7);
+        std::vector<std::byte> updates(NUM_UPDATES * marketPacket::UPDATE_SIZE);
+        for (size_t i = 0; i < NUM_UPDATES; i++)
+        {
+            const std::string symbol = marketPacket::generateRandomSymbol(rng);
+            const uint64_t big = (i % 5 == 0) ? UINT64_MAX - rng.below(3) : rng.below(100000);
+
+            if (rng.below(2) == 0)
+            {
+                marketPacket::trade_t trade{.updateHeader = {sizeof(marketPacket::trade_t), marketPacket::updateType_e::TRADE}, .tradeSize = static_cast<uint16_t>(rng()), .tradePrice = big};
+                std::memcpy(trade.symbol, symbol.data(), marketPacket::SYMBOL_LENGTH);
+                std::memcpy(updates.data() + i * marketPacket::UPDATE_SIZE, &trade, marketPacket::UPDATE_SIZE);
+            }
+            else
+            {
+                marketPacket::quote_t quote{.updateHeader = {sizeof(marketPacket::quote_t), marketPacket::updateType_e::QUOTE}, .priceLevel = UINT16_MAX, .priceLevelSize = rng(), .timeOfDay = big};
+                std::memcpy(quote.symbol, symbol.data(), marketPacket::SYMBOL_LENGTH);
+                std::memcpy(updates.data() + i * marketPacket::UPDATE_SIZE, &quote, marketPacket::UPDATE_SIZE);
+            }
+        }
+
+        marketPacket::compactEncoder_t encoder;
+        std::vector<std::byte> body(marketPacket::maxCompactBodySize(NUM_UPDATES));
+
+        // All of them, then just the first few so the dictionary gets reused and indexes are a byte
+        for (size_t numUpdates : {NUM_UPDATES, size_t{100}, size_t{1}})
+        {
+            std::optional<size_t> bodySize = encoder.encode(updates.data(), numUpdates, body.data());
+            ASSERT_TRUE(bodySize.has_value());
+            ASSERT_LE(bodySize.value(), marketPacket::maxCompactBodySize(numUpdates));
+
+            std::vector<std::byte> decoded(numUpdates * marketPacket::UPDATE_SIZE);
+            std::vector<uint64_t> tradeMask(marketPacket::tradeMaskWords(numUpdates));
+            ASSERT_TRUE(marketPacket::decodeCompactBody(body.data(), bodySize.value(), numUpdates, decoded.data(), tradeMask.data()));
+            EXPECT_EQ(std::memcmp(decoded.data(), updates.data(), decoded.size()), 0) << numUpdates;
+
+            std::vector<uint64_t> expectedMask(tradeMask.size());
+            ASSERT_TRUE(marketPacket::classifyUpdates(updates.data(), numUpdates, expectedMask.data()));
+            EXPECT_EQ(tradeMask, expectedMask);
+
+            // Every byte has to be accounted for, no more and no less
+            EXPECT_FALSE(marketPacket::decodeCompactBody(body.data(), bodySize.value() - 1, numUpdates, decoded.data(), tradeMask.data()));
+            EXPECT_FALSE(marketPacket::decodeCompactBody(body.data(), bodySize.value() + 1, numUpdates, decoded.data(), tradeMask.data()));
+        }
+
+        // Nothing that isn't a valid trade / quote gets encoded
+        updates[marketPacket::TYPE_OFFSET] = std::byte{'X'};
+        EXPECT_FALSE(encoder.encode(updates.data(), 1, body.data()).has_value());
+    }
+
+    TEST(marketPacketHelpersTest, spscRingInOrder)
+    {
+        constexpr const size_t NUM_ITEMS = 100000;
+
+        // Small and not a power of two, so it gets rounded up and wraps constantly
+        marketPacket::spscRing_t<size_t> ring(5);
+        EXPECT_EQ(ring.capacity(), 8);
+
+        std::thread producer([&ring]
+                             {
+                                 std::array<size_t, 3> batch;
+                                 for (size_t next = 0; next < NUM_ITEMS;)
+                                 {
+                                     const size_t batchSize = std::min(batch.size(), NUM_ITEMS - next);
+                                     for (size_t i = 0; i < batchSize; i++)
+                                     {
+                                         batch[i] = next + i;
+                                     }
+
+                                     const size_t numPushed = ring.tryPush(std::span<const size_t>(batch.data(), batchSize));
+                                     if (numPushed == 0)
+                                     {
+                                         std::this_thread::yield();
+                                     }
+
+                                     next += numPushed;
+                                 } });
+
+        std::array<size_t, 4> out;
+        size_t expected = 0;
+        while (expected < NUM_ITEMS)
+        {
+            const size_t numPopped = ring.tryPop(out);
+            if (numPopped == 0)
+            {
+                std::this_thread::yield();
+            }
+
+            for (size_t i = 0; i < numPopped; i++)
+            {
+                ASSERT_EQ(out[i], expected++);
+            }
+        }
+
+        producer.join();
+
+        size_t leftover;
+        EXPECT_FALSE(ring.tryPop(leftover));
+    }
+
+    TEST(marketPacketHelpersTest, spscRingBlockingPushPop)
+    {
+        constexpr const size_t NUM_ITEMS = 100000;
+
+        // Tiny ring and a slow consumer now and then, so both sides end up asleep on the other
+        marketPacket::spscRing_t<size_t> ring(4);
+        std::atomic<bool> done(false);
+
+        std::thread producer([&ring, &done]
+                             {
+                                 std::array<size_t, 7> batch;
+                                 for (size_t next = 0; next < NUM_ITEMS; next += batch.size())
+                                 {
+                                     for (size_t i = 0; i < batch.size(); i++)
+                                     {
+                                         batch[i] = next + i;
+                                     }
+
+                                     ASSERT_EQ(ring.push(std::span<const size_t>(batch.data(), std::min(batch.size(), NUM_ITEMS - next)), done), std::min(batch.size(), NUM_ITEMS - next));
+                                 }
+
+                                 done.store(true);
+                                 ring.wake(); });
+
+        std::array<size_t, 3> out;
+        size_t expected = 0;
+        for (size_t numPopped = ring.pop(out, done); numPopped > 0; numPopped = ring.pop(out, done))
+        {
+            for (size_t i = 0; i < numPopped; i++)
+            {
+                ASSERT_EQ(out[i], expected++);
+            }
+
+            if (expected % 10000 < 3)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        producer.join();
+        EXPECT_EQ(expected, NUM_ITEMS);
+
+        // A producer stuck on a full ring gives up once it's told to stop
+        std::atomic<bool> stop(false);
+        std::thread stuck([&ring, &stop]
+                          {
+                              std::array<size_t, 5> batch{};
+                              EXPECT_EQ(ring.push(batch, stop), ring.capacity()); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stop.store(true);
+        ring.wake();
+        stuck.join();
+    }
+}
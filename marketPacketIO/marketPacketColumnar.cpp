@@ -0,0 +1,285 @@
+#include "marketPacketColumnar.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace marketPacket
+{
+    namespace
+    {
+        constexpr const std::array<size_t, 3> TRADE_COLUMN_WIDTHS = {sizeof(symbolId_t), sizeof(uint16_t), sizeof(uint64_t)};
+        constexpr const std::array<size_t, 4> QUOTE_COLUMN_WIDTHS = {sizeof(symbolId_t), sizeof(uint16_t), sizeof(uint64_t), sizeof(uint64_t)};
+        constexpr const std::array<size_t, 2> SYMBOL_COLUMN_WIDTHS = {sizeof(symbolId_t), sizeof(uint64_t)};
+
+        static_assert(sizeof(columnFileHeader_t) <= COLUMN_ALIGNMENT);
+        static_assert(sizeof(columnBlockHeader_t) <= COLUMN_ALIGNMENT);
+        static_assert(QUOTE_COLUMN_WIDTHS.size() <= MAX_COLUMNS);
+
+        size_t alignUp(size_t numBytes)
+        {
+            return (numBytes + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+        }
+    }
+
+    std::span<const size_t> columnWidths(columnTable_e table)
+    {
+        switch (table)
+        {
+        case columnTable_e::TRADES:
+            return TRADE_COLUMN_WIDTHS;
+        case columnTable_e::QUOTES:
+            return QUOTE_COLUMN_WIDTHS;
+        case columnTable_e::SYMBOLS:
+            return SYMBOL_COLUMN_WIDTHS;
+        default:
+            return {};
+        }
+    }
+
+    size_t columnOffset(columnTable_e table, size_t column, size_t rowsPerBlock)
+    {
+        // Header gets a page to itself, then each column rounded up to whole pages
+        size_t offset = alignUp(sizeof(columnBlockHeader_t));
+        for (size_t width : columnWidths(table).first(column))
+        {
+            offset += alignUp(width * rowsPerBlock);
+        }
+
+        return offset;
+    }
+
+    size_t columnBlockSize(columnTable_e table, size_t rowsPerBlock)
+    {
+        return columnOffset(table, columnWidths(table).size(), rowsPerBlock);
+    }
+
+    columnarSink_t::columnarSink_t(std::ofstream &&oStream, size_t rowsPerBlock)
+        : m_rowsPerBlock(std::max<size_t>(rowsPerBlock, 1)),
+          m_trades(makeBlock(columnTable_e::TRADES)),
+          m_quotes(makeBlock(columnTable_e::QUOTES)),
+          m_symbols(makeBlock(columnTable_e::SYMBOLS)),
+          m_symbolNames(),
+          m_numSymbolsWritten(),
+          m_outputStream(std::move(oStream))
+    {
+        std::vector<std::byte> fileHeader(alignUp(sizeof(columnFileHeader_t)));
+        const columnFileHeader_t header{COLUMNAR_MAGIC, COLUMNAR_VERSION, static_cast<uint32_t>(m_rowsPerBlock)};
+        std::memcpy(fileHeader.data(), &header, sizeof(header));
+
+        m_outputStream.write(reinterpret_cast<const char *>(fileHeader.data()), fileHeader.size());
+    }
+
+    columnarSink_t::~columnarSink_t()
+    {
+        flush();
+    }
+
+    columnarSink_t &columnarSink_t::operator=(columnarSink_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            flush();
+
+            m_rowsPerBlock = other.m_rowsPerBlock;
+            m_trades = std::move(other.m_trades);
+            m_quotes = std::move(other.m_quotes);
+            m_symbols = std::move(other.m_symbols);
+            m_symbolNames = std::move(other.m_symbolNames);
+            m_numSymbolsWritten = std::exchange(other.m_numSymbolsWritten, 0);
+            m_outputStream = std::move(other.m_outputStream);
+        }
+
+        return *this;
+    }
+
+    bool columnarSink_t::write(const std::byte *, size_t)
+    {
+        // Updates only, nothing should be formatting for us
+        assert(false);
+        return false;
+    }
+
+    bool columnarSink_t::writeTrade(const trade_t *t, symbolId_t symbolId)
+    {
+        rememberSymbol(symbolId, t->symbol);
+
+        setValue(m_trades, TRADE_SYMBOL_ID, &symbolId);
+        setValue(m_trades, TRADE_SIZE, &t->tradeSize);
+        setValue(m_trades, TRADE_PRICE, &t->tradePrice);
+        return finishRow(m_trades);
+    }
+
+    bool columnarSink_t::writeQuote(const quote_t *q, symbolId_t symbolId)
+    {
+        rememberSymbol(symbolId, q->symbol);
+
+        setValue(m_quotes, QUOTE_SYMBOL_ID, &symbolId);
+        setValue(m_quotes, QUOTE_PRICE_LEVEL, &q->priceLevel);
+        setValue(m_quotes, QUOTE_SIZE, &q->priceLevelSize);
+        setValue(m_quotes, QUOTE_TIME_OF_DAY, &q->timeOfDay);
+        return finishRow(m_quotes);
+    }
+
+    bool columnarSink_t::flush()
+    {
+        // Moved from, nothing to do
+        if (!m_outputStream.is_open())
+        {
+            return false;
+        }
+
+        bool written = writeBlock(m_trades) && writeBlock(m_quotes);
+
+        // Symbols last, so they cover every ID in the blocks before them
+        for (; m_numSymbolsWritten < m_symbolNames.size(); m_numSymbolsWritten++)
+        {
+            const symbolId_t symbolId = m_numSymbolsWritten;
+            setValue(m_symbols, SYMBOL_ID, &symbolId);
+            setValue(m_symbols, SYMBOL_NAME, &m_symbolNames[symbolId]);
+            written = finishRow(m_symbols) && written;
+        }
+
+        written = writeBlock(m_symbols) && written;
+        return m_outputStream.flush().good() && written;
+    }
+
+    columnarSink_t::block_t columnarSink_t::makeBlock(columnTable_e table) const
+    {
+        return block_t{table, std::vector<std::byte>(columnBlockSize(table, m_rowsPerBlock)), 0};
+    }
+
+    void columnarSink_t::setValue(block_t &block, size_t column, const void *value)
+    {
+        const size_t width = columnWidths(block.table)[column];
+        std::memcpy(block.bytes.data() + columnOffset(block.table, column, m_rowsPerBlock) + block.numRows * width, value, width);
+    }
+
+    bool columnarSink_t::finishRow(block_t &block)
+    {
+        block.numRows++;
+        return (block.numRows < m_rowsPerBlock) || writeBlock(block);
+    }
+
+    bool columnarSink_t::writeBlock(block_t &block)
+    {
+        if (block.numRows == 0)
+        {
+            return true;
+        }
+
+        // Zero whatever the last block left past our last row, so partial blocks don't leak stale rows
+        const std::span<const size_t> widths = columnWidths(block.table);
+        for (size_t column = 0; column < widths.size() && block.numRows < m_rowsPerBlock; column++)
+        {
+            std::byte *columnStart = block.bytes.data() + columnOffset(block.table, column, m_rowsPerBlock);
+            std::memset(columnStart + block.numRows * widths[column], 0, (m_rowsPerBlock - block.numRows) * widths[column]);
+        }
+
+        const columnBlockHeader_t header{block.table, static_cast<uint32_t>(block.numRows), block.bytes.size()};
+        std::memcpy(block.bytes.data(), &header, sizeof(header));
+        block.numRows = 0;
+
+        return m_outputStream.write(reinterpret_cast<const char *>(block.bytes.data()), block.bytes.size()).good();
+    }
+
+    void columnarSink_t::rememberSymbol(symbolId_t symbolId, const char *symbol)
+    {
+        if (symbolId >= m_symbolNames.size())
+        {
+            m_symbolNames.resize(symbolId + 1);
+        }
+
+        // IDs are handed out densely in order, so this only really does anything the first time we see each one
+        if (m_symbolNames[symbolId] == 0)
+        {
+            std::memcpy(&m_symbolNames[symbolId], symbol, SYMBOL_LENGTH);
+        }
+    }
+
+    columnarFile_t::columnarFile_t(const std::string &path)
+        : m_mappedInput(path),
+          m_valid(false),
+          m_rowsPerBlock(),
+          m_blocks(),
+          m_symbols()
+    {
+        const std::byte *data = m_mappedInput.data();
+        const size_t size = m_mappedInput.size();
+
+        columnFileHeader_t fileHeader;
+        if (!m_mappedInput.isOpen() || size < alignUp(sizeof(fileHeader)))
+        {
+            return;
+        }
+
+        std::memcpy(&fileHeader, data, sizeof(fileHeader));
+        if (fileHeader.magic != COLUMNAR_MAGIC || fileHeader.version != COLUMNAR_VERSION || fileHeader.rowsPerBlock == 0)
+        {
+            return;
+        }
+
+        m_rowsPerBlock = fileHeader.rowsPerBlock;
+
+        for (size_t offset = alignUp(sizeof(fileHeader)); offset < size;)
+        {
+            columnBlockHeader_t blockHeader;
+            if (size - offset < sizeof(blockHeader))
+            {
+                return;
+            }
+
+            std::memcpy(&blockHeader, data + offset, sizeof(blockHeader));
+
+            const std::span<const size_t> widths = columnWidths(blockHeader.table);
+            if (widths.empty() || blockHeader.numRows > m_rowsPerBlock ||
+                blockHeader.blockSize != columnBlockSize(blockHeader.table, m_rowsPerBlock) || size - offset < blockHeader.blockSize)
+            {
+                return;
+            }
+
+            block_t block{blockHeader.table, blockHeader.numRows, {}};
+            for (size_t column = 0; column < widths.size(); column++)
+            {
+                block.columns[column] = data + offset + columnOffset(blockHeader.table, column, m_rowsPerBlock);
+            }
+
+            if (block.table == columnTable_e::SYMBOLS)
+            {
+                std::span<const symbolId_t> ids = column<symbolId_t>(block, SYMBOL_ID);
+                std::span<const uint64_t> names = column<uint64_t>(block, SYMBOL_NAME);
+                for (size_t row = 0; row < block.numRows; row++)
+                {
+                    // The sink hands out IDs in order, so an ID is either one we've seen or the next one. Anything
+                    // else is garbage we shouldn't size m_symbols by
+                    if (ids[row] > m_symbols.size())
+                    {
+                        return;
+                    }
+
+                    if (ids[row] == m_symbols.size())
+                    {
+                        m_symbols.emplace_back();
+                    }
+
+                    std::memcpy(m_symbols[ids[row]].data(), &names[row], SYMBOL_LENGTH);
+                }
+            }
+
+            m_blocks.push_back(block);
+            offset += blockHeader.blockSize;
+        }
+
+        m_valid = true;
+    }
+
+    std::string_view columnarFile_t::symbol(symbolId_t symbolId) const
+    {
+        if (symbolId >= m_symbols.size())
+        {
+            return {};
+        }
+
+        return std::string_view(m_symbols[symbolId].data(), SYMBOL_LENGTH);
+    }
+};
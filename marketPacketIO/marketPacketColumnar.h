@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSymbolTable.h"
+#include "marketPacketIO.h"
+#include "marketPacketMappedFile.h"
+
+namespace marketPacket
+{
+    /**
+     * Columnar file format
+     *
+     * A columnFileHeader_t, then blocks back to back. Every block is a columnBlockHeader_t followed by one column per field,
+     * each holding rowsPerBlock values whether or not the block is full. Headers and columns all start on a COLUMN_ALIGNMENT
+     * boundary, so a reader can mmap a single column straight out of the file, and every column is aligned for SIMD loads.
+     * Blocks of the same table are always the same size, columnBlockSize() says how big
+     */
+    constexpr const uint64_t COLUMNAR_MAGIC = 0x4c4f4354504b4d; // "MKPTCOL"
+    constexpr const uint32_t COLUMNAR_VERSION = 1;
+    constexpr const size_t COLUMN_ALIGNMENT = 4096;
+    constexpr const size_t DEFAULT_ROWS_PER_BLOCK = 4096;
+    constexpr const size_t MAX_COLUMNS = 4;
+
+    /**
+     * @brief Which kind of rows a block holds
+     */
+    enum class columnTable_e : uint32_t
+    {
+        TRADES = 1,
+        QUOTES,
+        SYMBOLS // Symbol ID to SYMBOL_LENGTH chars, for every ID the other tables use
+    };
+
+    /**
+     * @brief Columns of each table, in the order they sit in a block
+     */
+    enum tradeColumn_e : size_t
+    {
+        TRADE_SYMBOL_ID = 0, // symbolId_t
+        TRADE_SIZE,          // uint16_t
+        TRADE_PRICE          // uint64_t
+    };
+
+    enum quoteColumn_e : size_t
+    {
+        QUOTE_SYMBOL_ID = 0, // symbolId_t
+        QUOTE_PRICE_LEVEL,   // uint16_t
+        QUOTE_SIZE,          // uint64_t
+        QUOTE_TIME_OF_DAY    // uint64_t
+    };
+
+    enum symbolColumn_e : size_t
+    {
+        SYMBOL_ID = 0, // symbolId_t
+        SYMBOL_NAME    // uint64_t, the SYMBOL_LENGTH chars in the low bytes
+    };
+
+    struct columnFileHeader_t
+    {
+        uint64_t magic;        // COLUMNAR_MAGIC
+        uint32_t version;      // COLUMNAR_VERSION
+        uint32_t rowsPerBlock; // Values in every column of every block
+    };
+
+    struct columnBlockHeader_t
+    {
+        columnTable_e table; // What's in this block
+        uint32_t numRows;    // How many of the rowsPerBlock rows are real
+        uint64_t blockSize;  // Bytes from this header to the next one
+    };
+
+    /**
+     * @brief Bytes per value of each column in table, in column order
+     */
+    std::span<const size_t> columnWidths(columnTable_e table);
+
+    /**
+     * @brief Where a column starts, relative to the start of its block
+     */
+    size_t columnOffset(columnTable_e table, size_t column, size_t rowsPerBlock);
+
+    /**
+     * @brief Size of every block of table, header and padding included
+     */
+    size_t columnBlockSize(columnTable_e table, size_t rowsPerBlock);
+
+    /**
+     * Sink that lays trades and quotes out in columns instead of formatting them
+     *
+     * Fills a block per table in memory and writes it out whole once it's full. Partial blocks, and the symbols
+     * every ID maps to, go out on flush() (and so on destruction). Raw bytes are always rejected
+     */
+    class columnarSink_t
+    {
+    public:
+        /**
+         * @brief Construct a new columnarSink_t object. Writes the file header straight away
+         *
+         * @param oStream      Where the columnar file goes
+         * @param rowsPerBlock Rows in every block. Bigger blocks mean longer runs for a reader to scan
+         */
+        columnarSink_t(std::ofstream &&oStream, size_t rowsPerBlock = DEFAULT_ROWS_PER_BLOCK);
+        ~columnarSink_t();
+
+        columnarSink_t(columnarSink_t &&other) noexcept = default;
+        columnarSink_t &operator=(columnarSink_t &&other) noexcept;
+
+        columnarSink_t(const columnarSink_t &) = delete;
+        columnarSink_t &operator=(const columnarSink_t &) = delete;
+
+        bool write(const std::byte *data, size_t numBytes);
+        bool writeTrade(const trade_t *t, symbolId_t symbolId);
+        bool writeQuote(const quote_t *q, symbolId_t symbolId);
+
+        /**
+         * @brief Writes out partial blocks and any symbols we haven't written yet
+         *
+         * @return If everything made it to the stream
+         */
+        bool flush();
+
+    private:
+        /**
+         * @brief The block we're filling for one table
+         */
+        struct block_t
+        {
+            columnTable_e table;          // Which table
+            std::vector<std::byte> bytes; // Header, then columns, exactly as they go in the file
+            size_t numRows;               // Rows filled so far
+        };
+
+        block_t makeBlock(columnTable_e table) const;
+        void setValue(block_t &block, size_t column, const void *value); // Sets column of the next row
+        bool finishRow(block_t &block);                                  // Moves on a row, writing the block out if it's full
+        bool writeBlock(block_t &block);                                 // Writes the block, partial or not, and empties it
+        void rememberSymbol(symbolId_t symbolId, const char *symbol);    // Notes down what an ID is for the SYMBOLS table
+
+        size_t m_rowsPerBlock; // Rows in every block
+
+        block_t m_trades;  // Trades waiting to go out
+        block_t m_quotes;  // Quotes waiting to go out
+        block_t m_symbols; // Symbols waiting to go out
+
+        std::vector<uint64_t> m_symbolNames; // Indexed by symbol ID, 0 if we haven't seen it yet
+        size_t m_numSymbolsWritten;          // IDs below this are already in the file
+
+        std::ofstream m_outputStream; // Output stream
+    };
+
+    /**
+     * Read side of the columnar format, over a memory mapping of the whole file
+     *
+     * Hands out columns as spans straight into the mapping, no copies
+     */
+    class columnarFile_t
+    {
+    public:
+        /**
+         * @brief A block's worth of rows
+         */
+        struct block_t
+        {
+            columnTable_e table;                                // Which table
+            size_t numRows;                                     // Rows in every column
+            std::array<const std::byte *, MAX_COLUMNS> columns; // Start of each column, nullptr past the last
+        };
+
+        /**
+         * @brief Maps and walks the file at path. If it's missing or malformed, isValid() will return false
+         */
+        explicit columnarFile_t(const std::string &path);
+
+        bool isValid() const { return m_valid; }
+        size_t rowsPerBlock() const { return m_rowsPerBlock; }
+
+        /**
+         * @brief Every block in the file, in file order
+         */
+        const std::vector<block_t> &blocks() const { return m_blocks; }
+
+        /**
+         * @brief A single column of a block. T must match columnWidths()
+         */
+        template <typename T>
+        static std::span<const T> column(const block_t &block, size_t column)
+        {
+            return std::span<const T>(reinterpret_cast<const T *>(block.columns[column]), block.numRows);
+        }
+
+        /**
+         * @brief What the trades and quotes' symbol IDs stand for. Empty if the ID isn't in the file
+         */
+        std::string_view symbol(symbolId_t symbolId) const;
+
+    private:
+        mappedInputFile_t m_mappedInput;                        // The whole file
+        bool m_valid;                                           // If the file parsed
+        size_t m_rowsPerBlock;                                  // From the file header
+        std::vector<block_t> m_blocks;                          // Every block we found
+        std::vector<std::array<char, SYMBOL_LENGTH>> m_symbols; // Indexed by symbol ID, from the SYMBOLS blocks
+    };
+
+    static_assert(updateSink_c<columnarSink_t>);
+};
@@ -0,0 +1,399 @@
+#include "marketPacketCompressed.h"
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace marketPacket
+{
+    void zstdContextDeleter_t::operator()(ZSTD_CCtx_s *context) const
+    {
+        ZSTD_freeCCtx(context);
+    }
+
+    void zstdContextDeleter_t::operator()(ZSTD_DCtx_s *context) const
+    {
+        ZSTD_freeDCtx(context);
+    }
+
+    compressedSink_t::compressedSink_t(std::ofstream &&oStream, const compressionConfig_t &config)
+        : m_config(config),
+          m_block(),
+          m_compressed(),
+          m_zstd(),
+          m_outputStream(std::move(oStream))
+    {
+        m_config.blockSize = std::clamp<size_t>(m_config.blockSize, 1, MAX_COMPRESSED_BLOCK_SIZE);
+        m_block.reserve(m_config.blockSize);
+
+        switch (m_config.codec)
+        {
+        case compressionCodec_e::LZ4:
+            m_compressed.resize(LZ4_compressBound(static_cast<int>(m_config.blockSize)));
+            break;
+
+        case compressionCodec_e::ZSTD:
+            m_compressed.resize(ZSTD_compressBound(m_config.blockSize));
+            m_zstd.reset(ZSTD_createCCtx());
+            break;
+
+        case compressionCodec_e::NONE:
+            break;
+        }
+    }
+
+    compressedSink_t::~compressedSink_t()
+    {
+        flush();
+    }
+
+    compressedSink_t &compressedSink_t::operator=(compressedSink_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            flush();
+
+            m_config = other.m_config;
+            m_block = std::move(other.m_block);
+            m_compressed = std::move(other.m_compressed);
+            m_zstd = std::move(other.m_zstd);
+            m_outputStream = std::move(other.m_outputStream);
+        }
+
+        return *this;
+    }
+
+    bool compressedSink_t::write(const std::byte *data, size_t numBytes)
+    {
+        if (!m_outputStream.is_open())
+        {
+            return false;
+        }
+
+        while (numBytes > 0)
+        {
+            const size_t toCopy = std::min(numBytes, m_config.blockSize - m_block.size());
+            m_block.insert(m_block.end(), data, data + toCopy);
+            data += toCopy;
+            numBytes -= toCopy;
+
+            if (m_block.size() == m_config.blockSize && !writeBlock())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool compressedSink_t::flush()
+    {
+        if (!m_outputStream.is_open())
+        {
+            return false;
+        }
+
+        return writeBlock() && m_outputStream.flush().good();
+    }
+
+    bool compressedSink_t::writeBlock()
+    {
+        if (m_block.empty())
+        {
+            return true;
+        }
+
+        const char *raw = reinterpret_cast<const char *>(m_block.data());
+        char *compressed = reinterpret_cast<char *>(m_compressed.data());
+
+        // 0 for anything that didn't compress, the block just gets stored
+        size_t compressedSize = 0;
+        switch (m_config.codec)
+        {
+        case compressionCodec_e::LZ4:
+            compressedSize = LZ4_compress_default(raw, compressed, static_cast<int>(m_block.size()), static_cast<int>(m_compressed.size()));
+            break;
+
+        case compressionCodec_e::ZSTD:
+        {
+            const size_t result = (m_zstd == nullptr) ? 0 : ZSTD_compressCCtx(m_zstd.get(), compressed, m_compressed.size(), raw, m_block.size(), m_config.level);
+            compressedSize = ZSTD_isError(result) ? 0 : result;
+            break;
+        }
+
+        case compressionCodec_e::NONE:
+            break;
+        }
+
+        compressedBlockHeader_t header{COMPRESSED_BLOCK_MAGIC, m_config.codec, {}, static_cast<uint32_t>(m_block.size()), static_cast<uint32_t>(compressedSize)};
+        if (compressedSize == 0 || compressedSize >= m_block.size())
+        {
+            header.codec = compressionCodec_e::NONE;
+            header.compressedSize = header.rawSize;
+            compressed = const_cast<char *>(raw);
+        }
+
+        m_outputStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_outputStream.write(compressed, header.compressedSize);
+        m_block.clear();
+
+        return m_outputStream.good();
+    }
+
+    compressedSource_t::compressedSource_t(std::ifstream &&iStream, size_t numBuffers)
+        : m_numBuffers(std::max<size_t>(numBuffers, 2)),
+          m_shared(),
+          m_decompressor(),
+          m_currentSeq(),
+          m_currentPos(),
+          m_staging()
+    {
+        if (!iStream.is_open())
+        {
+            return;
+        }
+
+        m_shared = std::make_unique<shared_t>();
+        m_shared->inputStream = std::move(iStream);
+        m_shared->buffers.resize(m_numBuffers);
+        m_shared->numFilled = 0;
+        m_shared->numReleased = 0;
+        m_shared->done = false;
+        m_shared->bad = false;
+        m_shared->stop = false;
+
+        m_decompressor = std::thread(&compressedSource_t::decompressAhead, m_shared.get(), m_numBuffers);
+    }
+
+    compressedSource_t::~compressedSource_t()
+    {
+        stopThread();
+    }
+
+    compressedSource_t &compressedSource_t::operator=(compressedSource_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            stopThread();
+
+            m_numBuffers = other.m_numBuffers;
+            m_shared = std::move(other.m_shared);
+            m_decompressor = std::move(other.m_decompressor);
+            m_currentSeq = std::exchange(other.m_currentSeq, 0);
+            m_currentPos = std::exchange(other.m_currentPos, 0);
+            m_staging = std::move(other.m_staging);
+        }
+
+        return *this;
+    }
+
+    sourceStatus_e compressedSource_t::status()
+    {
+        if (m_shared == nullptr)
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        if (m_currentPos < waitBuffer(m_currentSeq))
+        {
+            return sourceStatus_e::GOOD;
+        }
+
+        // Used up this block, so it's down to whether there's another. Don't hand this one back, the last read still points into it
+        if (waitBuffer(m_currentSeq + 1) > 0)
+        {
+            return sourceStatus_e::GOOD;
+        }
+
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        return m_shared->bad ? sourceStatus_e::BAD : sourceStatus_e::END_OF_FILE;
+    }
+
+    const std::byte *compressedSource_t::read(size_t numBytes)
+    {
+        if (m_shared == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The last read finished off this block. Nobody can be looking at it anymore, so give it back
+        size_t bytesFilled = waitBuffer(m_currentSeq);
+        if (bytesFilled > 0 && m_currentPos == bytesFilled)
+        {
+            advance();
+            bytesFilled = waitBuffer(m_currentSeq);
+        }
+
+        // Common case, it's all in this block
+        if (bytesFilled - m_currentPos >= numBytes)
+        {
+            const std::byte *inputPtr = m_shared->buffers[m_currentSeq % m_numBuffers].data() + m_currentPos;
+            m_currentPos += numBytes;
+            return inputPtr;
+        }
+
+        if (m_staging.size() < numBytes)
+        {
+            m_staging.resize(numBytes);
+        }
+
+        // Stitch together as many blocks as it takes, running out of blocks is the end of the stream
+        size_t staged = 0;
+        while (true)
+        {
+            const size_t toCopy = std::min(numBytes - staged, bytesFilled - m_currentPos);
+            std::memcpy(m_staging.data() + staged, m_shared->buffers[m_currentSeq % m_numBuffers].data() + m_currentPos, toCopy);
+            staged += toCopy;
+            m_currentPos += toCopy;
+
+            if (staged == numBytes)
+            {
+                return m_staging.data();
+            }
+
+            if (bytesFilled == 0)
+            {
+                return nullptr;
+            }
+
+            advance();
+            bytesFilled = waitBuffer(m_currentSeq);
+        }
+    }
+
+    void compressedSource_t::decompressAhead(shared_t *shared, size_t numBuffers)
+    {
+        std::unique_ptr<ZSTD_DCtx_s, zstdContextDeleter_t> zstd(ZSTD_createDCtx());
+        std::vector<std::byte> compressed; // Payload of the block we're on, unless it's stored
+
+        for (size_t seq = 0;; seq++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(shared->mutex);
+                shared->bufferFree.wait(lock, [&]
+                                        { return shared->stop || seq - shared->numReleased < numBuffers; });
+
+                if (shared->stop)
+                {
+                    return;
+                }
+            }
+
+            compressedBlockHeader_t header;
+            shared->inputStream.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+            // Running out exactly between blocks is the only clean way to end
+            bool good = shared->inputStream.gcount() == sizeof(header);
+            const bool last = !good && shared->inputStream.gcount() == 0 && shared->inputStream.eof();
+
+            good = good && header.magic == COMPRESSED_BLOCK_MAGIC && header.reserved[0] == 0 && header.reserved[1] == 0 && header.reserved[2] == 0 &&
+                   header.rawSize > 0 && header.rawSize <= MAX_COMPRESSED_BLOCK_SIZE && header.compressedSize <= MAX_COMPRESSED_BLOCK_SIZE;
+
+            std::vector<std::byte> &buffer = shared->buffers[seq % numBuffers];
+            if (good)
+            {
+                buffer.resize(header.rawSize);
+
+                switch (header.codec)
+                {
+                case compressionCodec_e::NONE:
+                    good = header.compressedSize == header.rawSize &&
+                           shared->inputStream.read(reinterpret_cast<char *>(buffer.data()), header.rawSize).good();
+                    break;
+
+                case compressionCodec_e::LZ4:
+                    compressed.resize(header.compressedSize);
+                    good = shared->inputStream.read(reinterpret_cast<char *>(compressed.data()), header.compressedSize).good() &&
+                           LZ4_decompress_safe(reinterpret_cast<const char *>(compressed.data()), reinterpret_cast<char *>(buffer.data()),
+                                               static_cast<int>(header.compressedSize), static_cast<int>(header.rawSize)) == static_cast<int>(header.rawSize);
+                    break;
+
+                case compressionCodec_e::ZSTD:
+                {
+                    compressed.resize(header.compressedSize);
+                    good = zstd != nullptr && shared->inputStream.read(reinterpret_cast<char *>(compressed.data()), header.compressedSize).good();
+
+                    const size_t result = good ? ZSTD_decompressDCtx(zstd.get(), buffer.data(), header.rawSize, compressed.data(), header.compressedSize) : 0;
+                    good = good && !ZSTD_isError(result) && result == header.rawSize;
+                    break;
+                }
+
+                default:
+                    good = false;
+                    break;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                if (good)
+                {
+                    shared->numFilled = seq + 1;
+                }
+                else
+                {
+                    shared->done = true;
+                    shared->bad = !last;
+                }
+            }
+
+            shared->bufferReady.notify_one();
+
+            if (!good)
+            {
+                return;
+            }
+        }
+    }
+
+    size_t compressedSource_t::waitBuffer(size_t seq)
+    {
+        std::unique_lock<std::mutex> lock(m_shared->mutex);
+        m_shared->bufferReady.wait(lock, [&]
+                                   { return m_shared->numFilled > seq || m_shared->done; });
+
+        // Asked past the last block there'll ever be
+        if (m_shared->numFilled <= seq)
+        {
+            return 0;
+        }
+
+        return m_shared->buffers[seq % m_numBuffers].size();
+    }
+
+    void compressedSource_t::advance()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->numReleased = m_currentSeq + 1;
+        }
+
+        m_shared->bufferFree.notify_one();
+
+        m_currentSeq++;
+        m_currentPos = 0;
+    }
+
+    void compressedSource_t::stopThread()
+    {
+        if (m_shared == nullptr)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->stop = true;
+        }
+
+        m_shared->bufferFree.notify_one();
+
+        if (m_decompressor.joinable())
+        {
+            m_decompressor.join();
+        }
+    }
+};
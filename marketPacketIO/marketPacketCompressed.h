@@ -0,0 +1,182 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "marketPacketIO.h"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace marketPacket
+{
+    /**
+     * Compressed capture format
+     *
+     * Blocks back to back, each a compressedBlockHeader_t followed by compressedSize bytes that come out as rawSize bytes
+     * of the usual packet stream. Blocks are cut at an arbitrary byte, not on packet boundaries, and every block is
+     * compressed on its own so a reader never needs anything from the block before. A block that didn't get any smaller
+     * is stored as NONE
+     */
+    constexpr const uint32_t COMPRESSED_BLOCK_MAGIC = 0x4b4c424d; // "MBLK"
+    constexpr const size_t DEFAULT_COMPRESSED_BLOCK_SIZE = 1 << 20;
+    constexpr const size_t MAX_COMPRESSED_BLOCK_SIZE = 64 << 20; // Anything claiming to be bigger is corrupt
+
+    /**
+     * @brief How a block's payload is compressed
+     */
+    enum class compressionCodec_e : uint8_t
+    {
+        NONE = 0, // Stored as is
+        LZ4,      // LZ4 block format, fast enough to keep up with a disk
+        ZSTD      // Zstandard frame, smaller but slower
+    };
+
+    struct compressedBlockHeader_t
+    {
+        uint32_t magic;           // COMPRESSED_BLOCK_MAGIC
+        compressionCodec_e codec; // How the payload is compressed
+        uint8_t reserved[3];      // Always 0
+        uint32_t rawSize;         // Bytes the payload decompresses to
+        uint32_t compressedSize;  // Bytes of payload after this header
+    };
+
+    static_assert(sizeof(compressedBlockHeader_t) == 16);
+
+    /**
+     * @brief How a compressed sink should compress
+     */
+    struct compressionConfig_t
+    {
+        compressionCodec_e codec = compressionCodec_e::LZ4;
+        size_t blockSize = DEFAULT_COMPRESSED_BLOCK_SIZE; // Raw bytes per block. Bigger compresses better, but a reader buffers whole blocks
+        int level = 0;                                    // ZSTD level, 0 for zstd's default. Ignored by LZ4
+    };
+
+    /**
+     * @brief Deleters for the zstd contexts we keep around, so their headers stay out of ours
+     */
+    struct zstdContextDeleter_t
+    {
+        void operator()(ZSTD_CCtx_s *context) const;
+        void operator()(ZSTD_DCtx_s *context) const;
+    };
+
+    /**
+     * Sink on top of an std::ofstream that writes the compressed capture format
+     *
+     * Collects a block's worth of bytes, compresses it on the calling thread and writes it out. The partial block at
+     * the end goes out on flush() (and so on destruction)
+     */
+    class compressedSink_t
+    {
+    public:
+        /**
+         * @brief Construct a new compressedSink_t object
+         *
+         * @param oStream Where the compressed capture goes
+         * @param config  How to compress it
+         */
+        compressedSink_t(std::ofstream &&oStream, const compressionConfig_t &config = compressionConfig_t{});
+        ~compressedSink_t();
+
+        compressedSink_t(compressedSink_t &&other) noexcept = default;
+        compressedSink_t &operator=(compressedSink_t &&other) noexcept;
+
+        compressedSink_t(const compressedSink_t &) = delete;
+        compressedSink_t &operator=(const compressedSink_t &) = delete;
+
+        bool write(const std::byte *data, size_t numBytes);
+
+        /**
+         * @brief Writes out the partial block
+         *
+         * @return If everything written so far made it to the stream
+         */
+        bool flush();
+
+    private:
+        bool writeBlock(); // Compresses and writes whatever is in m_block, and empties it
+
+        compressionConfig_t m_config; // How to compress
+
+        std::vector<std::byte> m_block;      // Raw bytes of the block we're filling
+        std::vector<std::byte> m_compressed; // Where blocks get compressed to, big enough for the worst case
+
+        std::unique_ptr<ZSTD_CCtx_s, zstdContextDeleter_t> m_zstd; // Reused for every block, nullptr unless we're on ZSTD
+
+        std::ofstream m_outputStream; // Output stream
+    };
+
+    /**
+     * Source on top of an std::ifstream of the compressed capture format, with a background thread decompressing ahead
+     *
+     * Works like prefetchSource_t, except the thread reads a block and decompresses it, so decompression overlaps with
+     * whatever the caller does with the bytes. A buffer is only handed back once the caller has read past it and called
+     * read() again, and reads that straddle blocks get stitched together in a staging buffer
+     */
+    class compressedSource_t
+    {
+    public:
+        /**
+         * @brief Starts decompressing ahead straight away. If the stream isn't open, status() will return CLOSED
+         *
+         * @param iStream    Input stream, owned by the decompressing thread from here on
+         * @param numBuffers How many decompressed blocks rotate between the thread and us. At least 2
+         */
+        compressedSource_t(std::ifstream &&iStream, size_t numBuffers = DEFAULT_NUM_READ_BUFFERS);
+        ~compressedSource_t();
+
+        compressedSource_t(compressedSource_t &&other) noexcept = default;
+        compressedSource_t &operator=(compressedSource_t &&other) noexcept;
+
+        compressedSource_t(const compressedSource_t &) = delete;
+        compressedSource_t &operator=(const compressedSource_t &) = delete;
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes); // Grows the staging buffer if numBytes is more than a block
+
+    private:
+        /**
+         * @brief Everything the decompressing thread touches. Lives on the heap so moving the source doesn't move it out from under the thread
+         */
+        struct shared_t
+        {
+            std::ifstream inputStream;                   // Only the thread touches this once it's started
+            std::vector<std::vector<std::byte>> buffers; // Decompressed blocks, sized to exactly what's in them
+
+            std::mutex mutex;                    // Guards everything below
+            std::condition_variable bufferFree;  // Signalled when we hand a buffer back
+            std::condition_variable bufferReady; // Signalled when the thread fills one
+            size_t numFilled;                    // Buffers filled since the start, the next one to fill is numFilled % numBuffers
+            size_t numReleased;                  // Buffers handed back since the start
+            bool done;                           // Thread has filled its last buffer
+            bool bad;                            // Thread stopped on a bad block or stream error rather than the end of the file
+            bool stop;                           // We're going away, thread should too
+        };
+
+        static void decompressAhead(shared_t *shared, size_t numBuffers); // Decompressing thread body
+
+        size_t waitBuffer(size_t seq); // Blocks until buffer seq is filled, returns how many bytes it has. 0 past the last
+        void advance();                // Done with the current buffer, hand it back to the thread
+        void stopThread();             // Tells the thread to stop and waits for it
+
+        size_t m_numBuffers; // Buffers in the rotation
+
+        std::unique_ptr<shared_t> m_shared; // Buffers and state shared with the thread, nullptr if the stream wasn't open
+        std::thread m_decompressor;         // Fills buffers ahead of us
+
+        size_t m_currentSeq;              // Buffer we're reading out of, counting from the start of the stream
+        size_t m_currentPos;              // How far into the current buffer we've read
+        std::vector<std::byte> m_staging; // Where reads that straddle buffers get put together
+    };
+
+    static_assert(byteSource_c<compressedSource_t>);
+    static_assert(byteSink_c<compressedSink_t>);
+};
@@ -0,0 +1,246 @@
+#include "marketPacketFollow.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace marketPacket
+{
+    followSource_t::followSource_t(const std::string &path, const followConfig_t &config)
+        : m_fd(::open(path.c_str(), O_RDONLY)),
+          m_notifyFd(-1),
+          m_config(config),
+          m_backoff(config.minBackoff),
+          m_buffer(READ_BUFFER_SIZE),
+          m_bufferStart(),
+          m_bufferEnd(),
+          m_stopped(std::make_unique<std::atomic<bool>>(false))
+    {
+        if (m_fd < 0 || m_config.wait != followWait_e::INOTIFY)
+        {
+            return;
+        }
+
+        // Anything that can't watch the file (no inotify, out of watches) can still poll it
+        m_notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_notifyFd >= 0 && ::inotify_add_watch(m_notifyFd, path.c_str(), IN_MODIFY) < 0)
+        {
+            ::close(m_notifyFd);
+            m_notifyFd = -1;
+        }
+    }
+
+    followSource_t::~followSource_t()
+    {
+        close();
+    }
+
+    followSource_t::followSource_t(followSource_t &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)),
+          m_notifyFd(std::exchange(other.m_notifyFd, -1)),
+          m_config(other.m_config),
+          m_backoff(other.m_backoff),
+          m_buffer(std::move(other.m_buffer)),
+          m_bufferStart(std::exchange(other.m_bufferStart, 0)),
+          m_bufferEnd(std::exchange(other.m_bufferEnd, 0)),
+          m_stopped(std::exchange(other.m_stopped, std::make_unique<std::atomic<bool>>(false)))
+    {
+    }
+
+    followSource_t &followSource_t::operator=(followSource_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+
+            m_fd = std::exchange(other.m_fd, -1);
+            m_notifyFd = std::exchange(other.m_notifyFd, -1);
+            m_config = other.m_config;
+            m_backoff = other.m_backoff;
+            m_buffer = std::move(other.m_buffer);
+            m_bufferStart = std::exchange(other.m_bufferStart, 0);
+            m_bufferEnd = std::exchange(other.m_bufferEnd, 0);
+            m_stopped = std::exchange(other.m_stopped, std::make_unique<std::atomic<bool>>(false));
+        }
+
+        return *this;
+    }
+
+    sourceStatus_e followSource_t::status()
+    {
+        if (m_fd < 0)
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        // We're between packets here, so this is the one place we're allowed to give up
+        const auto deadline = (m_config.idleTimeout == std::chrono::milliseconds::max())
+                                  ? std::chrono::steady_clock::time_point::max()
+                                  : std::chrono::steady_clock::now() + m_config.idleTimeout;
+
+        while (true)
+        {
+            // Only GOOD once the whole packet is here, so the reads for it can't run dry, and a stop() never leaves half of it consumed
+            fill_e filled = fill(PACKET_HEADER_SIZE);
+            if (filled == fill_e::FILLED)
+            {
+                filled = fill(bufferedPacketLength());
+            }
+
+            switch (filled)
+            {
+            case fill_e::FILLED:
+                return sourceStatus_e::GOOD;
+
+            case fill_e::FAILED:
+                return sourceStatus_e::BAD;
+
+            case fill_e::DRY:
+                break;
+            }
+
+            if (stopped() || std::chrono::steady_clock::now() >= deadline)
+            {
+                return sourceStatus_e::END_OF_FILE;
+            }
+
+            waitForGrowth();
+        }
+    }
+
+    const std::byte *followSource_t::read(size_t numBytes)
+    {
+        if (m_fd < 0)
+        {
+            return nullptr;
+        }
+
+        while (true)
+        {
+            switch (fill(numBytes))
+            {
+            case fill_e::FILLED:
+            {
+                const std::byte *inputPtr = m_buffer.data() + m_bufferStart;
+                m_bufferStart += numBytes;
+                return inputPtr;
+            }
+
+            case fill_e::FAILED:
+                return nullptr;
+
+            case fill_e::DRY:
+                break;
+            }
+
+            // Whatever we have stays buffered, so a later read() still starts at the same byte
+            if (stopped())
+            {
+                return nullptr;
+            }
+
+            waitForGrowth();
+        }
+    }
+
+    size_t followSource_t::bufferedPacketLength() const
+    {
+        packetHeader_t packetHeader;
+        std::memcpy(&packetHeader, m_buffer.data() + m_bufferStart, PACKET_HEADER_SIZE);
+
+        // A nonsense length is for the processor to fail on, we just need the header for that
+        return std::max<size_t>(packetHeader.packetLength, PACKET_HEADER_SIZE);
+    }
+
+    followSource_t::fill_e followSource_t::fill(size_t numBytes)
+    {
+        if (m_bufferEnd - m_bufferStart >= numBytes)
+        {
+            return fill_e::FILLED;
+        }
+
+        // Whatever was handed out last is done with by now, so make room by sliding what's left to the front
+        if (m_buffer.size() - m_bufferStart < numBytes)
+        {
+            std::memmove(m_buffer.data(), m_buffer.data() + m_bufferStart, m_bufferEnd - m_bufferStart);
+            m_bufferEnd -= m_bufferStart;
+            m_bufferStart = 0;
+
+            if (m_buffer.size() < numBytes)
+            {
+                m_buffer.resize(numBytes);
+            }
+        }
+
+        while (m_bufferEnd - m_bufferStart < numBytes)
+        {
+            ssize_t numRead = ::read(m_fd, m_buffer.data() + m_bufferEnd, m_buffer.size() - m_bufferEnd);
+            if (numRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (numRead < 0)
+            {
+                return fill_e::FAILED;
+            }
+
+            if (numRead == 0)
+            {
+                return fill_e::DRY;
+            }
+
+            m_bufferEnd += numRead;
+            m_backoff = m_config.minBackoff;
+        }
+
+        return fill_e::FILLED;
+    }
+
+    void followSource_t::waitForGrowth()
+    {
+        if (m_notifyFd < 0)
+        {
+            std::this_thread::sleep_for(m_backoff);
+            m_backoff = std::min(m_backoff * 2, m_config.maxBackoff);
+            return;
+        }
+
+        // The watch was up before we last hit the end, so any write since then has already queued an event.
+        // Still wake up every maxBackoff, that's how we notice stop()
+        pollfd notify{m_notifyFd, POLLIN, 0};
+        const int timeoutMs = static_cast<int>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(m_config.maxBackoff).count(), 1));
+        if (::poll(&notify, 1, timeoutMs) <= 0)
+        {
+            return;
+        }
+
+        // We only care that something happened, not what
+        alignas(inotify_event) char events[4096];
+        while (::read(m_notifyFd, events, sizeof(events)) > 0)
+        {
+        }
+    }
+
+    void followSource_t::close()
+    {
+        if (m_notifyFd >= 0)
+        {
+            ::close(m_notifyFd);
+            m_notifyFd = -1;
+        }
+
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "marketPacketIO.h"
+
+namespace marketPacket
+{
+    /**
+     * @brief How a follow source waits for a file to grow
+     */
+    enum class followWait_e : uint8_t
+    {
+        INOTIFY = 0, // Sleep until the kernel says the file was written to
+        POLL         // Sleep and check again, backing off the longer nothing shows up
+    };
+
+    /**
+     * @brief How a follow source should wait
+     *
+     * Asking for INOTIFY where inotify isn't available quietly gets POLL instead
+     */
+    struct followConfig_t
+    {
+        followWait_e wait = followWait_e::INOTIFY;
+        std::chrono::microseconds minBackoff{50};                                 // First poll sleep after we run dry
+        std::chrono::microseconds maxBackoff{10000};                              // Longest poll sleep, also how often an inotify wait checks for stop()
+        std::chrono::milliseconds idleTimeout = std::chrono::milliseconds::max(); // How long status() waits between packets before giving END_OF_FILE
+    };
+
+    /**
+     * Source that follows a file while something else is still appending to it
+     *
+     * Running out of bytes isn't the end, it waits for more instead. status() is only ever asked between packets, so it is
+     * the only one that gives up (after idleTimeout, or once stop() is called) with END_OF_FILE. It doesn't say GOOD until
+     * the whole of the next packet is buffered, so the reads for that packet never have to wait, and a packet the writer is
+     * only half way through is left alone until it's finished. Bytes are only read from the file once, and nothing gets
+     * consumed unless it's handed out whole, so calling processNextPacket() again after END_OF_FILE picks up exactly where
+     * the last packet ended
+     */
+    class followSource_t
+    {
+    public:
+        /**
+         * @brief Opens path and starts following it from the start. If it isn't there, status() will return CLOSED
+         */
+        followSource_t(const std::string &path, const followConfig_t &config = followConfig_t{});
+        ~followSource_t();
+
+        followSource_t(followSource_t &&other) noexcept;
+        followSource_t &operator=(followSource_t &&other) noexcept;
+
+        followSource_t(const followSource_t &) = delete;
+        followSource_t &operator=(const followSource_t &) = delete;
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes);
+
+        /**
+         * @brief Makes anything waiting give up. Safe to call from another thread, and sticks until resume()
+         */
+        void stop() { m_stopped->store(true, std::memory_order_release); }
+        void resume() { m_stopped->store(false, std::memory_order_release); }
+
+        bool usingInotify() const { return m_notifyFd >= 0; }
+
+    private:
+        /**
+         * @brief What filling the buffer came to
+         */
+        enum class fill_e : uint8_t
+        {
+            FILLED = 0, // Got everything we wanted
+            DRY,        // File has nothing more, for now
+            FAILED      // read() gave an error
+        };
+
+        fill_e fill(size_t numBytes);        // Reads from the file until numBytes are buffered, or it runs dry
+        size_t bufferedPacketLength() const; // Length of the packet whose header is at m_bufferStart, needs the header buffered
+        void waitForGrowth();                // Blocks until the file might have grown, or for a backoff if we can't tell
+        bool stopped() const { return m_stopped->load(std::memory_order_acquire); }
+        void close();
+
+        int m_fd;                            // File we're following, -1 if not open
+        int m_notifyFd;                      // inotify instance watching m_fd's path, -1 if we're polling
+        followConfig_t m_config;             // How to wait
+        std::chrono::microseconds m_backoff; // Next poll sleep
+
+        std::vector<std::byte> m_buffer; // Bytes read from the file but not handed out yet start at m_bufferStart
+        size_t m_bufferStart;            // First byte not handed out yet
+        size_t m_bufferEnd;              // One past the last byte read from the file
+
+        std::unique_ptr<std::atomic<bool>> m_stopped; // On the heap so it can be shared with whoever calls stop(), and we stay movable
+    };
+
+    /**
+     * @brief Sources whose END_OF_FILE just means "nothing yet", so a processor can pick up again later
+     */
+    template <typename T>
+    concept followSource_c = byteSource_c<T> && requires(T &source) {
+        source.stop();
+        source.resume();
+    };
+
+    static_assert(followSource_c<followSource_t>);
+};
@@ -0,0 +1,906 @@
+#include "marketPacketIO.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace marketPacket
+{
+    sourceStatus_e streamSource_t::status()
+    {
+        if (!m_inputStream.is_open())
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        // Do a quick peek to set flags if we're at the end of a file
+        m_inputStream.peek();
+        if (!m_inputStream.good())
+        {
+            return m_inputStream.eof() ? sourceStatus_e::END_OF_FILE : sourceStatus_e::BAD;
+        }
+
+        return sourceStatus_e::GOOD;
+    }
+
+    const std::byte *streamSource_t::read(size_t numBytes)
+    {
+        if (numBytes > m_readBuffer.size())
+        {
+            m_readBuffer.resize(numBytes);
+        }
+
+        if (!(m_inputStream.read(reinterpret_cast<char *>(m_readBuffer.data()), numBytes)).good())
+        {
+            return nullptr;
+        }
+
+        return m_readBuffer.data();
+    }
+
+    bool streamSource_t::seek(uint64_t offset)
+    {
+        if (!m_inputStream.is_open())
+        {
+            return false;
+        }
+
+        // Hitting the end sets eof, which would stick around past the seek
+        m_inputStream.clear();
+        m_inputStream.seekg(0, std::ios::end);
+        if (!m_inputStream.good() || static_cast<uint64_t>(m_inputStream.tellg()) < offset)
+        {
+            return false;
+        }
+
+        return m_inputStream.seekg(offset).good();
+    }
+
+    prefetchSource_t::prefetchSource_t(std::ifstream &&iStream, const readConfig_t &config)
+        : m_bufferSize(std::max<size_t>(config.bufferSize, 1)),
+          m_numBuffers(std::max<size_t>(config.numBuffers, 2)),
+          m_shared(),
+          m_reader(),
+          m_currentSeq(),
+          m_currentPos(),
+          m_staging()
+    {
+        if (!iStream.is_open())
+        {
+            return;
+        }
+
+        m_shared = std::make_unique<shared_t>();
+        m_shared->inputStream = std::move(iStream);
+        m_shared->buffers.resize(m_bufferSize * m_numBuffers);
+        m_shared->bytesFilled.resize(m_numBuffers);
+        m_shared->numFilled = 0;
+        m_shared->numReleased = 0;
+        m_shared->done = false;
+        m_shared->bad = false;
+        m_shared->stop = false;
+
+        m_reader = std::thread(&prefetchSource_t::readAhead, m_shared.get(), m_bufferSize, m_numBuffers);
+    }
+
+    prefetchSource_t::~prefetchSource_t()
+    {
+        stopReader();
+    }
+
+    prefetchSource_t &prefetchSource_t::operator=(prefetchSource_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            stopReader();
+
+            m_bufferSize = other.m_bufferSize;
+            m_numBuffers = other.m_numBuffers;
+            m_shared = std::move(other.m_shared);
+            m_reader = std::move(other.m_reader);
+            m_currentSeq = std::exchange(other.m_currentSeq, 0);
+            m_currentPos = std::exchange(other.m_currentPos, 0);
+            m_staging = std::move(other.m_staging);
+        }
+
+        return *this;
+    }
+
+    sourceStatus_e prefetchSource_t::status()
+    {
+        if (m_shared == nullptr)
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        const size_t bytesFilled = waitBuffer(m_currentSeq);
+        if (m_currentPos < bytesFilled)
+        {
+            return sourceStatus_e::GOOD;
+        }
+
+        // Used up a full buffer, so it's down to whether the next one has anything. Don't hand this one back, the last read still points into it
+        if (bytesFilled == m_bufferSize && waitBuffer(m_currentSeq + 1) > 0)
+        {
+            return sourceStatus_e::GOOD;
+        }
+
+        std::lock_guard<std::mutex> lock(m_shared->mutex);
+        return m_shared->bad ? sourceStatus_e::BAD : sourceStatus_e::END_OF_FILE;
+    }
+
+    const std::byte *prefetchSource_t::read(size_t numBytes)
+    {
+        if (m_shared == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The last read finished off this buffer. Nobody can be looking at it anymore, so give it back
+        if (m_currentPos == m_bufferSize)
+        {
+            advance();
+        }
+
+        // Common case, it's all in this buffer
+        size_t bytesFilled = waitBuffer(m_currentSeq);
+        if (bytesFilled - m_currentPos >= numBytes)
+        {
+            const std::byte *inputPtr = bufferData(m_currentSeq) + m_currentPos;
+            m_currentPos += numBytes;
+            return inputPtr;
+        }
+
+        if (m_staging.size() < numBytes)
+        {
+            m_staging.resize(numBytes);
+        }
+
+        // Stitch together as many buffers as it takes, a short one is the end of the stream
+        size_t staged = 0;
+        while (true)
+        {
+            const size_t toCopy = std::min(numBytes - staged, bytesFilled - m_currentPos);
+            std::memcpy(m_staging.data() + staged, bufferData(m_currentSeq) + m_currentPos, toCopy);
+            staged += toCopy;
+            m_currentPos += toCopy;
+
+            if (staged == numBytes)
+            {
+                return m_staging.data();
+            }
+
+            if (bytesFilled < m_bufferSize)
+            {
+                return nullptr;
+            }
+
+            advance();
+            bytesFilled = waitBuffer(m_currentSeq);
+        }
+    }
+
+    void prefetchSource_t::readAhead(shared_t *shared, size_t bufferSize, size_t numBuffers)
+    {
+        for (size_t seq = 0;; seq++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(shared->mutex);
+                shared->bufferFree.wait(lock, [&]
+                                        { return shared->stop || seq - shared->numReleased < numBuffers; });
+
+                if (shared->stop)
+                {
+                    return;
+                }
+            }
+
+            std::byte *buffer = shared->buffers.data() + (seq % numBuffers) * bufferSize;
+            shared->inputStream.read(reinterpret_cast<char *>(buffer), bufferSize);
+
+            const size_t bytesFilled = shared->inputStream.gcount();
+            const bool last = bytesFilled < bufferSize;
+
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->bytesFilled[seq % numBuffers] = bytesFilled;
+                shared->numFilled = seq + 1;
+
+                if (last)
+                {
+                    shared->done = true;
+                    shared->bad = shared->inputStream.bad() || !shared->inputStream.eof();
+                }
+            }
+
+            shared->bufferReady.notify_one();
+
+            if (last)
+            {
+                return;
+            }
+        }
+    }
+
+    size_t prefetchSource_t::waitBuffer(size_t seq)
+    {
+        std::unique_lock<std::mutex> lock(m_shared->mutex);
+        m_shared->bufferReady.wait(lock, [&]
+                                   { return m_shared->numFilled > seq || m_shared->done; });
+
+        // Asked past the last buffer there'll ever be
+        if (m_shared->numFilled <= seq)
+        {
+            return 0;
+        }
+
+        return m_shared->bytesFilled[seq % m_numBuffers];
+    }
+
+    void prefetchSource_t::advance()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->numReleased = m_currentSeq + 1;
+        }
+
+        m_shared->bufferFree.notify_one();
+
+        m_currentSeq++;
+        m_currentPos = 0;
+    }
+
+    void prefetchSource_t::stopReader()
+    {
+        if (m_shared == nullptr)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            m_shared->stop = true;
+        }
+
+        m_shared->bufferFree.notify_one();
+
+        if (m_reader.joinable())
+        {
+            m_reader.join();
+        }
+
+        m_shared.reset();
+    }
+
+    sourceStatus_e mappedSource_t::status()
+    {
+        if (!m_mappedInput.isOpen())
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        return (m_offset == m_mappedInput.size()) ? sourceStatus_e::END_OF_FILE : sourceStatus_e::GOOD;
+    }
+
+    const std::byte *mappedSource_t::read(size_t numBytes)
+    {
+        if (m_mappedInput.size() - m_offset < numBytes)
+        {
+            return nullptr;
+        }
+
+        // No copy, just hand out where we are in the mapping
+        const std::byte *inputPtr = m_mappedInput.data() + m_offset;
+        m_offset += numBytes;
+        m_mappedInput.readAhead(m_offset);
+        return inputPtr;
+    }
+
+    bool mappedSource_t::seek(uint64_t offset)
+    {
+        if (!m_mappedInput.isOpen() || offset > m_mappedInput.size())
+        {
+            return false;
+        }
+
+        m_offset = offset;
+        m_mappedInput.readAhead(m_offset);
+        return true;
+    }
+
+    sourceStatus_e memorySource_t::status()
+    {
+        return (m_offset == m_bytes.size()) ? sourceStatus_e::END_OF_FILE : sourceStatus_e::GOOD;
+    }
+
+    const std::byte *memorySource_t::read(size_t numBytes)
+    {
+        if (m_bytes.size() - m_offset < numBytes)
+        {
+            return nullptr;
+        }
+
+        const std::byte *inputPtr = m_bytes.data() + m_offset;
+        m_offset += numBytes;
+        return inputPtr;
+    }
+
+    uringSource_t::uringSource_t(const std::string &path, const ioConfig_t &config)
+        : m_fd(::open(path.c_str(), O_RDONLY)),
+          m_chunkSize(std::max(config.chunkSize, READ_BUFFER_SIZE)),
+          m_ring((config.backend == ioBackend_e::URING && m_fd >= 0) ? std::max<size_t>(config.queueDepth, 2) : 0),
+          m_buffers(),
+          m_chunks(),
+          m_staging(),
+          m_current(),
+          m_currentPos(),
+          m_nextOffset(),
+          m_sawEnd(false)
+    {
+        if (m_fd < 0)
+        {
+            return;
+        }
+
+        const size_t queueDepth = std::max<size_t>(config.queueDepth, 2);
+        m_buffers.resize(queueDepth * m_chunkSize);
+        m_chunks.resize(queueDepth);
+        m_staging.resize(m_chunkSize);
+
+        ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        if (m_ring.isOpen())
+        {
+            std::vector<iovec> iovecs(queueDepth);
+            for (size_t chunk = 0; chunk < queueDepth; chunk++)
+            {
+                iovecs[chunk] = iovec{chunkData(chunk), m_chunkSize};
+            }
+
+            m_ring.registerBuffers(iovecs);
+        }
+
+        // Get every chunk going straight away, the first one is all we have to wait on
+        for (size_t chunk = 0; chunk < queueDepth; chunk++)
+        {
+            submitChunk(chunk);
+        }
+
+        m_ring.submit();
+    }
+
+    uringSource_t::~uringSource_t()
+    {
+        close();
+    }
+
+    uringSource_t::uringSource_t(uringSource_t &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)),
+          m_chunkSize(other.m_chunkSize),
+          m_ring(std::move(other.m_ring)),
+          m_buffers(std::move(other.m_buffers)),
+          m_chunks(std::move(other.m_chunks)),
+          m_staging(std::move(other.m_staging)),
+          m_current(std::exchange(other.m_current, 0)),
+          m_currentPos(std::exchange(other.m_currentPos, 0)),
+          m_nextOffset(std::exchange(other.m_nextOffset, 0)),
+          m_sawEnd(std::exchange(other.m_sawEnd, false))
+    {
+    }
+
+    uringSource_t &uringSource_t::operator=(uringSource_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+
+            // Moving the vectors keeps their storage where it is, so anything in flight still lands in the right place
+            m_fd = std::exchange(other.m_fd, -1);
+            m_chunkSize = other.m_chunkSize;
+            m_ring = std::move(other.m_ring);
+            m_buffers = std::move(other.m_buffers);
+            m_chunks = std::move(other.m_chunks);
+            m_staging = std::move(other.m_staging);
+            m_current = std::exchange(other.m_current, 0);
+            m_currentPos = std::exchange(other.m_currentPos, 0);
+            m_nextOffset = std::exchange(other.m_nextOffset, 0);
+            m_sawEnd = std::exchange(other.m_sawEnd, false);
+        }
+
+        return *this;
+    }
+
+    sourceStatus_e uringSource_t::status()
+    {
+        if (m_fd < 0)
+        {
+            return sourceStatus_e::CLOSED;
+        }
+
+        waitChunk(m_current);
+        const chunk_t &current = m_chunks[m_current];
+        if (current.result < 0)
+        {
+            return sourceStatus_e::BAD;
+        }
+
+        if (m_currentPos < static_cast<size_t>(current.result))
+        {
+            return sourceStatus_e::GOOD;
+        }
+
+        if (static_cast<size_t>(current.result) < m_chunkSize)
+        {
+            return sourceStatus_e::END_OF_FILE;
+        }
+
+        // Used up a full chunk, so it's down to whether the next one has anything. Don't retire this one, the last read still points into it
+        const size_t next = (m_current + 1) % m_chunks.size();
+        waitChunk(next);
+        if (m_chunks[next].result < 0)
+        {
+            return sourceStatus_e::BAD;
+        }
+
+        return (m_chunks[next].result == 0) ? sourceStatus_e::END_OF_FILE : sourceStatus_e::GOOD;
+    }
+
+    const std::byte *uringSource_t::read(size_t numBytes)
+    {
+        if (m_fd < 0)
+        {
+            return nullptr;
+        }
+
+        // The last read finished off this chunk. Nobody can be looking at it anymore, so put it back to work
+        if (m_currentPos == m_chunkSize)
+        {
+            advance();
+        }
+
+        waitChunk(m_current);
+        if (m_chunks[m_current].result < 0)
+        {
+            return nullptr;
+        }
+
+        // Common case, it's all in this chunk
+        size_t bytesFilled = m_chunks[m_current].result;
+        if (bytesFilled - m_currentPos >= numBytes)
+        {
+            const std::byte *inputPtr = chunkData(m_current) + m_currentPos;
+            m_currentPos += numBytes;
+            return inputPtr;
+        }
+
+        if (m_staging.size() < numBytes)
+        {
+            m_staging.resize(numBytes);
+        }
+
+        // Stitch together as many chunks as it takes, a short one is the end of the file
+        size_t staged = 0;
+        while (true)
+        {
+            const size_t toCopy = std::min(numBytes - staged, bytesFilled - m_currentPos);
+            std::memcpy(m_staging.data() + staged, chunkData(m_current) + m_currentPos, toCopy);
+            staged += toCopy;
+            m_currentPos += toCopy;
+
+            if (staged == numBytes)
+            {
+                return m_staging.data();
+            }
+
+            if (bytesFilled < m_chunkSize)
+            {
+                return nullptr;
+            }
+
+            advance();
+            waitChunk(m_current);
+            if (m_chunks[m_current].result < 0)
+            {
+                return nullptr;
+            }
+
+            bytesFilled = m_chunks[m_current].result;
+        }
+    }
+
+    bool uringSource_t::seek(uint64_t offset)
+    {
+        struct stat st;
+        if (m_fd < 0 || ::fstat(m_fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < offset)
+        {
+            return false;
+        }
+
+        // Whatever's in flight is for the wrong part of the file, but it still has to land before the buffers get reused
+        for (size_t chunk = 0; chunk < m_chunks.size() && m_ring.isOpen(); chunk++)
+        {
+            waitChunk(chunk);
+        }
+
+        m_current = 0;
+        m_currentPos = 0;
+        m_nextOffset = offset;
+        m_sawEnd = false;
+
+        for (size_t chunk = 0; chunk < m_chunks.size(); chunk++)
+        {
+            m_chunks[chunk].inFlight = false;
+            submitChunk(chunk);
+        }
+
+        m_ring.submit();
+        return true;
+    }
+
+    void uringSource_t::submitChunk(size_t chunk)
+    {
+        chunk_t &c = m_chunks[chunk];
+        c.fileOffset = m_nextOffset;
+        c.result = 0;
+        m_nextOffset += m_chunkSize;
+
+        // Past the end of the file, don't bother the kernel
+        if (m_sawEnd)
+        {
+            c.inFlight = false;
+            return;
+        }
+
+        c.inFlight = true;
+
+        // If the ring won't take it, waitChunk() will just read it the blocking way
+        if (m_ring.isOpen() && !m_ring.prepRead(m_fd, chunkData(chunk), m_chunkSize, c.fileOffset, chunk, chunk))
+        {
+            completeChunk(chunk, 0);
+        }
+    }
+
+    void uringSource_t::waitChunk(size_t chunk)
+    {
+        while (m_chunks[chunk].inFlight)
+        {
+            // Blocking reads happen on demand
+            if (!m_ring.isOpen())
+            {
+                completeChunk(chunk, 0);
+                return;
+            }
+
+            ioRing_t::completion_t completion;
+            if (!m_ring.waitCompletion(completion))
+            {
+                m_chunks[chunk].inFlight = false;
+                m_chunks[chunk].result = -EIO;
+                return;
+            }
+
+            // Might not be the one we're waiting for, they can finish in any order
+            completeChunk(completion.userData, completion.result);
+        }
+    }
+
+    void uringSource_t::completeChunk(size_t chunk, int64_t result)
+    {
+        chunk_t &c = m_chunks[chunk];
+        c.inFlight = false;
+
+        // A short read isn't necessarily the end of the file, keep going until the kernel says there's nothing left
+        while (result >= 0 && static_cast<size_t>(result) < m_chunkSize)
+        {
+            ssize_t numRead = ::pread(m_fd, chunkData(chunk) + result, m_chunkSize - result, c.fileOffset + result);
+            if (numRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (numRead < 0)
+            {
+                result = -errno;
+                break;
+            }
+
+            if (numRead == 0)
+            {
+                m_sawEnd = true;
+                break;
+            }
+
+            result += numRead;
+        }
+
+        c.result = result;
+    }
+
+    void uringSource_t::advance()
+    {
+        submitChunk(m_current);
+        m_ring.submit();
+
+        m_current = (m_current + 1) % m_chunks.size();
+        m_currentPos = 0;
+    }
+
+    void uringSource_t::close()
+    {
+        // The kernel could still be reading into our buffers, they have to outlive every read
+        for (size_t chunk = 0; chunk < m_chunks.size() && m_ring.isOpen(); chunk++)
+        {
+            waitChunk(chunk);
+        }
+
+        m_ring = ioRing_t(0);
+        m_chunks.clear();
+
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    uringSink_t::uringSink_t(const std::string &path, const ioConfig_t &config)
+        : m_fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+          m_chunkSize(std::max(config.chunkSize, WRITE_BUFFER_SIZE)),
+          m_ring((config.backend == ioBackend_e::URING && m_fd >= 0) ? std::max<size_t>(config.queueDepth, 2) : 0),
+          m_buffers(),
+          m_chunks(),
+          m_current(),
+          m_currentUsed(),
+          m_nextOffset(),
+          m_failed(false)
+    {
+        if (m_fd < 0)
+        {
+            return;
+        }
+
+        const size_t queueDepth = std::max<size_t>(config.queueDepth, 2);
+        m_buffers.resize(queueDepth * m_chunkSize);
+        m_chunks.resize(queueDepth);
+
+        if (m_ring.isOpen())
+        {
+            std::vector<iovec> iovecs(queueDepth);
+            for (size_t chunk = 0; chunk < queueDepth; chunk++)
+            {
+                iovecs[chunk] = iovec{chunkData(chunk), m_chunkSize};
+            }
+
+            m_ring.registerBuffers(iovecs);
+        }
+    }
+
+    uringSink_t::~uringSink_t()
+    {
+        flush();
+        close();
+    }
+
+    uringSink_t::uringSink_t(uringSink_t &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)),
+          m_chunkSize(other.m_chunkSize),
+          m_ring(std::move(other.m_ring)),
+          m_buffers(std::move(other.m_buffers)),
+          m_chunks(std::move(other.m_chunks)),
+          m_current(std::exchange(other.m_current, 0)),
+          m_currentUsed(std::exchange(other.m_currentUsed, 0)),
+          m_nextOffset(std::exchange(other.m_nextOffset, 0)),
+          m_failed(std::exchange(other.m_failed, false))
+    {
+    }
+
+    uringSink_t &uringSink_t::operator=(uringSink_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            flush();
+            close();
+
+            m_fd = std::exchange(other.m_fd, -1);
+            m_chunkSize = other.m_chunkSize;
+            m_ring = std::move(other.m_ring);
+            m_buffers = std::move(other.m_buffers);
+            m_chunks = std::move(other.m_chunks);
+            m_current = std::exchange(other.m_current, 0);
+            m_currentUsed = std::exchange(other.m_currentUsed, 0);
+            m_nextOffset = std::exchange(other.m_nextOffset, 0);
+            m_failed = std::exchange(other.m_failed, false);
+        }
+
+        return *this;
+    }
+
+    bool uringSink_t::write(const std::byte *data, size_t numBytes)
+    {
+        if (m_fd < 0 || m_failed)
+        {
+            return false;
+        }
+
+        // Once we've failed, a chunk we gave up waiting on might still be queued, so its buffer can't be touched again
+        while (numBytes > 0 && !m_failed)
+        {
+            const size_t toCopy = std::min(numBytes, m_chunkSize - m_currentUsed);
+            std::memcpy(chunkData(m_current) + m_currentUsed, data, toCopy);
+
+            m_currentUsed += toCopy;
+            data += toCopy;
+            numBytes -= toCopy;
+
+            if (m_currentUsed == m_chunkSize)
+            {
+                submitCurrent();
+            }
+        }
+
+        return !m_failed;
+    }
+
+    bool uringSink_t::flush()
+    {
+        if (m_fd < 0)
+        {
+            return false;
+        }
+
+        if (m_currentUsed > 0 && !m_failed)
+        {
+            submitCurrent();
+        }
+
+        for (size_t chunk = 0; chunk < m_chunks.size(); chunk++)
+        {
+            waitChunk(chunk);
+        }
+
+        return !m_failed;
+    }
+
+    void uringSink_t::submitCurrent()
+    {
+        chunk_t &c = m_chunks[m_current];
+        c.fileOffset = m_nextOffset;
+        c.numBytes = m_currentUsed;
+        c.inFlight = true;
+        m_nextOffset += m_currentUsed;
+
+        // Blocking writes, or the ring had no room for it, either way it goes out right now
+        if (!m_ring.isOpen() || !m_ring.prepWrite(m_fd, chunkData(m_current), c.numBytes, c.fileOffset, m_current, m_current))
+        {
+            completeChunk(m_current, 0);
+        }
+        else
+        {
+            // Once it's queued the kernel will get to it sooner or later, so it has to stay in flight until it says so.
+            // If submitting didn't work (EAGAIN, EBUSY), the next enter() takes it along, waitChunk() at the latest
+            m_ring.submit();
+        }
+
+        // Can't start filling the next chunk until whatever was last written out of it is done
+        m_current = (m_current + 1) % m_chunks.size();
+        m_currentUsed = 0;
+        waitChunk(m_current);
+    }
+
+    void uringSink_t::waitChunk(size_t chunk)
+    {
+        while (m_chunks[chunk].inFlight)
+        {
+            ioRing_t::completion_t completion;
+            if (!m_ring.waitCompletion(completion))
+            {
+                m_chunks[chunk].inFlight = false;
+                m_failed = true;
+                return;
+            }
+
+            // Might not be the one we're waiting for, they can finish in any order
+            completeChunk(completion.userData, completion.result);
+        }
+    }
+
+    void uringSink_t::completeChunk(size_t chunk, int64_t result)
+    {
+        chunk_t &c = m_chunks[chunk];
+        c.inFlight = false;
+
+        // Short writes can happen (e.g. a signal), finish them off by hand
+        while (result >= 0 && static_cast<size_t>(result) < c.numBytes)
+        {
+            ssize_t numWritten = ::pwrite(m_fd, chunkData(chunk) + result, c.numBytes - result, c.fileOffset + result);
+            if (numWritten < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (numWritten <= 0)
+            {
+                result = -1;
+                break;
+            }
+
+            result += numWritten;
+        }
+
+        if (result < 0)
+        {
+            m_failed = true;
+        }
+    }
+
+    void uringSink_t::close()
+    {
+        // The kernel could still be writing out of our buffers, they have to outlive every write
+        for (size_t chunk = 0; chunk < m_chunks.size(); chunk++)
+        {
+            waitChunk(chunk);
+        }
+
+        m_ring = ioRing_t(0);
+        m_chunks.clear();
+
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool memorySource_t::seek(uint64_t offset)
+    {
+        if (offset > m_bytes.size())
+        {
+            return false;
+        }
+
+        m_offset = offset;
+        return true;
+    }
+
+    bool streamSink_t::write(const std::byte *data, size_t numBytes)
+    {
+        // We're relying that the outputStream knows how to buffer it's own writes
+        return m_outputStream.write(reinterpret_cast<const char *>(data), numBytes).good();
+    }
+
+    bool memorySink_t::write(const std::byte *data, size_t numBytes)
+    {
+        m_bytes.insert(m_bytes.end(), data, data + numBytes);
+        return true;
+    }
+
+    bool nullSink_t::write(const std::byte *, size_t)
+    {
+        return true;
+    }
+
+    bool tradeRingSink_t::write(const std::byte *, size_t)
+    {
+        // Trades only, nothing should be formatting for us
+        assert(false);
+        return false;
+    }
+
+    bool tradeRingSink_t::writeTrade(const trade_t *t)
+    {
+        m_pending[m_numPending++] = *t;
+        return m_numPending < m_pending.size() || flushTrades();
+    }
+
+    bool tradeRingSink_t::flushTrades()
+    {
+        const size_t numPending = std::exchange(m_numPending, 0);
+        return m_ring->push(std::span<const trade_t>(m_pending.data(), numPending), *m_abort) == numPending;
+    }
+};
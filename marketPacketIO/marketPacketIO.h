@@ -0,0 +1,490 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSpscRing.h"
+#include "marketPacketHelpers/marketPacketSymbolTable.h"
+#include "marketPacketMappedFile.h"
+#include "marketPacketUring.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_NUM_READ_BUFFERS = 3;
+
+    /**
+     * @brief What a source can tell us about itself before we try to read from it
+     */
+    enum class sourceStatus_e : uint8_t
+    {
+        GOOD = 0,
+
+        CLOSED,
+        END_OF_FILE,
+        BAD
+    };
+
+    /**
+     * @brief Anything the processor can pull bytes from
+     *
+     * read() hands back a ptr to exactly numBytes bytes (or nullptr if there aren't that many left).
+     * That ptr only has to stay valid until the next call to read()
+     */
+    template <typename T>
+    concept byteSource_c = requires(T &source, size_t numBytes) {
+        { source.status() } -> std::same_as<sourceStatus_e>;
+        { source.read(numBytes) } -> std::same_as<const std::byte *>;
+    };
+
+    /**
+     * @brief A source that can jump to any byte offset. The next read() starts there
+     *
+     * seek() returns false if the offset is past the end, or the source can't get there
+     */
+    template <typename T>
+    concept seekableSource_c = byteSource_c<T> && requires(T &source, uint64_t offset) {
+        { source.seek(offset) } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief A source whose read() ptrs stay valid for as long as the source does, not just until the next read()
+     */
+    template <typename T>
+    concept stableSource_c = byteSource_c<T> && T::STABLE_READS;
+
+    /**
+     * @brief Anything the generator / processor can push bytes to
+     *
+     * write() returns false if the bytes couldn't be written
+     */
+    template <typename T>
+    concept byteSink_c = requires(T &sink, const std::byte *data, size_t numBytes) {
+        { sink.write(data, numBytes) } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief A sink that wants trades as they are, instead of formatted text
+     *
+     * The processor hands these sinks every trade through writeTrade() and skips formatting entirely.
+     * The trade ptr is only valid for the duration of the call
+     */
+    template <typename T>
+    concept tradeSink_c = byteSink_c<T> && requires(T &sink, const trade_t *t) {
+        { sink.writeTrade(t) } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief A tradeSink_c that holds on to trades, and wants to know when it's been handed every trade of a packet
+     *
+     * The processor calls flushTrades() once it's given the sink every trade it decoded from the last read
+     */
+    template <typename T>
+    concept batchingTradeSink_c = tradeSink_c<T> && requires(T &sink) {
+        { sink.flushTrades() } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief A sink that wants every decoded update, trades and quotes, along with its interned symbol ID
+     *
+     * Takes priority over tradeSink_c. The update ptr is only valid for the duration of the call
+     */
+    template <typename T>
+    concept updateSink_c = byteSink_c<T> && requires(T &sink, const trade_t *t, const quote_t *q, symbolId_t symbolId) {
+        { sink.writeTrade(t, symbolId) } -> std::same_as<bool>;
+        { sink.writeQuote(q, symbolId) } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief A sink that takes updates of schema_t, for feeds with more than trades and quotes
+     *
+     * A processor hands these sinks every update of any schema other than a trade or a quote. The update ptr is only valid
+     * for the duration of the call
+     */
+    template <typename T, typename schema_t>
+    concept schemaSink_c = byteSink_c<T> && requires(T &sink, const std::byte *update) {
+        { sink.writeUpdate(schema_t{}, update) } -> std::same_as<bool>;
+    };
+
+    /**
+     * Source on top of an std::ifstream. Copies into its own buffer
+     */
+    class streamSource_t
+    {
+    public:
+        streamSource_t(std::ifstream &&iStream)
+            : m_readBuffer(READ_BUFFER_SIZE),
+              m_inputStream(std::move(iStream)){};
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes); // Grows the buffer if numBytes doesn't fit
+        bool seek(uint64_t offset);
+
+    private:
+        std::vector<std::byte> m_readBuffer; // Where we read into
+        std::ifstream m_inputStream;         // Input stream
+    };
+
+    /**
+     * @brief How a prefetching source splits up its reads
+     */
+    struct readConfig_t
+    {
+        size_t bufferSize = READ_BUFFER_SIZE;         // Bytes per read from the stream
+        size_t numBuffers = DEFAULT_NUM_READ_BUFFERS; // How many buffers rotate between the reader and us. At least 2
+    };
+
+    /**
+     * Source on top of an std::ifstream, with a background thread reading ahead into a rotation of buffers
+     *
+     * While the caller works through one buffer, the reader fills the rest. A buffer is only handed back to the reader
+     * once the caller has read past it and called read() again, so ptrs stay valid exactly as long as the concept promises.
+     * Reads that straddle two buffers get stitched together in a staging buffer
+     */
+    class prefetchSource_t
+    {
+    public:
+        /**
+         * @brief Starts reading ahead straight away. If the stream isn't open, status() will return CLOSED
+         *
+         * @param iStream Input stream, owned by the reader thread from here on
+         * @param config  How to split up the reads
+         */
+        prefetchSource_t(std::ifstream &&iStream, const readConfig_t &config = readConfig_t{});
+        ~prefetchSource_t();
+
+        prefetchSource_t(prefetchSource_t &&other) noexcept = default;
+        prefetchSource_t &operator=(prefetchSource_t &&other) noexcept;
+
+        prefetchSource_t(const prefetchSource_t &) = delete;
+        prefetchSource_t &operator=(const prefetchSource_t &) = delete;
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes); // Grows the staging buffer if numBytes is more than a buffer
+
+    private:
+        /**
+         * @brief Everything the reader thread touches. Lives on the heap so moving the source doesn't move it out from under the thread
+         */
+        struct shared_t
+        {
+            std::ifstream inputStream;       // Only the reader touches this once it's started
+            std::vector<std::byte> buffers;  // Every buffer, back to back
+            std::vector<size_t> bytesFilled; // Per buffer, how much the reader put in it. Short means it's the last one
+
+            std::mutex mutex;                    // Guards everything below
+            std::condition_variable bufferFree;  // Signalled when we hand a buffer back
+            std::condition_variable bufferReady; // Signalled when the reader fills one
+            size_t numFilled;                    // Buffers filled since the start, the next one to fill is numFilled % numBuffers
+            size_t numReleased;                  // Buffers handed back since the start
+            bool done;                           // Reader has filled its last buffer
+            bool bad;                            // Reader stopped on an error rather than the end of the file
+            bool stop;                           // We're going away, reader should too
+        };
+
+        std::byte *bufferData(size_t seq) { return m_shared->buffers.data() + (seq % m_numBuffers) * m_bufferSize; }
+
+        static void readAhead(shared_t *shared, size_t bufferSize, size_t numBuffers); // Reader thread body
+
+        size_t waitBuffer(size_t seq); // Blocks until buffer seq is filled, returns how many bytes it has
+        void advance();                // Done with the current buffer, hand it back to the reader
+        void stopReader();             // Tells the reader to stop and waits for it
+
+        size_t m_bufferSize; // Bytes per buffer
+        size_t m_numBuffers; // Buffers in the rotation
+
+        std::unique_ptr<shared_t> m_shared; // Buffers and state shared with the reader, nullptr if the stream wasn't open
+        std::thread m_reader;               // Fills buffers ahead of us
+
+        size_t m_currentSeq;              // Buffer we're reading out of, counting from the start of the stream
+        size_t m_currentPos;              // How far into the current buffer we've read
+        std::vector<std::byte> m_staging; // Where reads that straddle buffers get put together
+    };
+
+    /**
+     * Source on top of a memory mapped file. Never copies, ptrs point straight into the mapping
+     */
+    class mappedSource_t
+    {
+    public:
+        mappedSource_t(mappedInputFile_t &&iFile)
+            : m_mappedInput(std::move(iFile)),
+              m_offset(){};
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes);
+        bool seek(uint64_t offset);
+
+        static constexpr bool STABLE_READS = true; // Ptrs point into the mapping, which lives as long as we do
+
+    private:
+        mappedInputFile_t m_mappedInput; // Mapped input file
+        size_t m_offset;                 // How far into the mapping we've read
+    };
+
+    /**
+     * Source on top of bytes someone else owns. The bytes must outlive the source
+     */
+    class memorySource_t
+    {
+    public:
+        memorySource_t(std::span<const std::byte> bytes)
+            : m_bytes(bytes),
+              m_offset(){};
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes);
+        bool seek(uint64_t offset);
+
+        static constexpr bool STABLE_READS = true; // Ptrs point into the caller's bytes
+
+    private:
+        std::span<const std::byte> m_bytes; // What we're reading from
+        size_t m_offset;                    // How far into the bytes we've read
+    };
+
+    /**
+     * Source on top of a file, read in big chunks with several reads in flight while the caller works through the current one
+     *
+     * Ptrs point straight into the chunk unless a read straddles two chunks, then those bytes get stitched together in a staging buffer.
+     * See ioConfig_t for falling back to blocking reads
+     */
+    class uringSource_t
+    {
+    public:
+        /**
+         * @brief Opens the file at path and starts reading. If it can't be opened, status() will return CLOSED
+         *
+         * @param path   File to read
+         * @param config How to read it
+         */
+        explicit uringSource_t(const std::string &path, const ioConfig_t &config = ioConfig_t{});
+        ~uringSource_t();
+
+        uringSource_t(uringSource_t &&other) noexcept;
+        uringSource_t &operator=(uringSource_t &&other) noexcept;
+
+        uringSource_t(const uringSource_t &) = delete;
+        uringSource_t &operator=(const uringSource_t &) = delete;
+
+        sourceStatus_e status();
+        const std::byte *read(size_t numBytes); // Grows the staging buffer if numBytes is more than a chunk
+        bool seek(uint64_t offset);             // Throws away everything in flight and starts reading ahead from offset
+
+        /**
+         * @brief If reads are actually going through io_uring, rather than the blocking fallback
+         */
+        bool usingUring() const { return m_ring.isOpen(); }
+
+    private:
+        /**
+         * @brief One chunk worth of the file, and what happened when we read it
+         */
+        struct chunk_t
+        {
+            uint64_t fileOffset; // Where in the file this chunk starts
+            int64_t result;      // Bytes in the chunk, or -errno
+            bool inFlight;       // Read submitted but not reaped yet
+        };
+
+        std::byte *chunkData(size_t chunk) { return m_buffers.data() + chunk * m_chunkSize; }
+
+        void submitChunk(size_t chunk);                   // Starts reading the next part of the file into chunk
+        void waitChunk(size_t chunk);                     // Blocks until chunk has its bytes
+        void completeChunk(size_t chunk, int64_t result); // Records a finished read, topping up short ones
+        void advance();                                   // Done with the current chunk, reuse it for later in the file
+        void close();
+
+        int m_fd;           // File we're reading, -1 if not open
+        size_t m_chunkSize; // Bytes per chunk
+        ioRing_t m_ring;    // Not open if we're doing blocking reads
+
+        std::vector<std::byte> m_buffers; // Every chunk, back to back
+        std::vector<chunk_t> m_chunks;    // What's in each chunk
+        std::vector<std::byte> m_staging; // Where reads that straddle chunks get put together
+
+        size_t m_current;      // Chunk we're reading out of
+        size_t m_currentPos;   // How far into the current chunk we've read
+        uint64_t m_nextOffset; // Where in the file the next chunk we submit starts
+        bool m_sawEnd;         // A chunk came back short, nothing after it is worth reading
+    };
+
+    /**
+     * Sink on top of an std::ofstream
+     */
+    class streamSink_t
+    {
+    public:
+        streamSink_t(std::ofstream &&oStream)
+            : m_outputStream(std::move(oStream)){};
+
+        bool write(const std::byte *data, size_t numBytes);
+
+    private:
+        std::ofstream m_outputStream; // Output stream
+    };
+
+    /**
+     * Sink that collects everything written to it in memory
+     */
+    class memorySink_t
+    {
+    public:
+        memorySink_t()
+            : m_bytes(){};
+
+        bool write(const std::byte *data, size_t numBytes);
+
+        const std::vector<std::byte> &bytes() const { return m_bytes; }
+        void clear() { m_bytes.clear(); }
+
+    private:
+        std::vector<std::byte> m_bytes; // Everything written so far
+    };
+
+    /**
+     * Sink that throws away everything written to it. For processors that only hand out updates through decodeBatch()
+     */
+    class nullSink_t
+    {
+    public:
+        bool write(const std::byte *data, size_t numBytes);
+    };
+
+    /**
+     * Sink on top of a file, written in big chunks with several writes in flight while the caller fills the next one
+     *
+     * Chunks are registered with the ring once, so writes don't pin pages every time. See ioConfig_t for falling back to blocking writes.
+     * A write failing in the background is reported by the next write() / flush()
+     */
+    class uringSink_t
+    {
+    public:
+        /**
+         * @brief Creates (or truncates) the file at path. If it can't be opened, every write fails
+         *
+         * @param path   File to write
+         * @param config How to write it
+         */
+        explicit uringSink_t(const std::string &path, const ioConfig_t &config = ioConfig_t{});
+        ~uringSink_t();
+
+        uringSink_t(uringSink_t &&other) noexcept;
+        uringSink_t &operator=(uringSink_t &&other) noexcept;
+
+        uringSink_t(const uringSink_t &) = delete;
+        uringSink_t &operator=(const uringSink_t &) = delete;
+
+        bool write(const std::byte *data, size_t numBytes);
+
+        /**
+         * @brief Writes out the partial chunk and waits for everything in flight. Also done on destruction
+         *
+         * @return If everything written so far made it to the file
+         */
+        bool flush();
+
+        /**
+         * @brief If writes are actually going through io_uring, rather than the blocking fallback
+         */
+        bool usingUring() const { return m_ring.isOpen(); }
+
+    private:
+        /**
+         * @brief One chunk worth of output, and where it's going
+         */
+        struct chunk_t
+        {
+            uint64_t fileOffset; // Where in the file this chunk goes
+            size_t numBytes;     // How much of it we submitted
+            bool inFlight;       // Write submitted but not reaped yet
+        };
+
+        std::byte *chunkData(size_t chunk) { return m_buffers.data() + chunk * m_chunkSize; }
+
+        void submitCurrent();                             // Sends off whatever is in the current chunk and moves to the next one
+        void waitChunk(size_t chunk);                     // Blocks until chunk is free to fill again
+        void completeChunk(size_t chunk, int64_t result); // Records a finished write, topping up short ones
+        void close();
+
+        int m_fd;           // File we're writing, -1 if not open
+        size_t m_chunkSize; // Bytes per chunk
+        ioRing_t m_ring;    // Not open if we're doing blocking writes
+
+        std::vector<std::byte> m_buffers; // Every chunk, back to back
+        std::vector<chunk_t> m_chunks;    // What's in each chunk
+
+        size_t m_current;      // Chunk we're filling
+        size_t m_currentUsed;  // How much of the current chunk is filled
+        uint64_t m_nextOffset; // Where in the file the current chunk goes
+        bool m_failed;         // Some write didn't make it
+    };
+
+    constexpr const size_t TRADE_RING_BATCH_SIZE = 256;
+
+    /**
+     * Producer side of a trade ring. Copies trades into the ring, waiting for room if it's full
+     *
+     * Trades are held back until flushTrades() (or until TRADE_RING_BATCH_SIZE of them pile up), then pushed in one go,
+     * so the consumer sees one publish per batch rather than one per trade. Only takes trades, raw bytes are always rejected
+     */
+    class tradeRingSink_t
+    {
+    public:
+        /**
+         * @brief Construct a new tradeRingSink_t object
+         *
+         * @param ring  Ring to push to. This sink must be the only thing pushing to it
+         * @param abort Once set, stop waiting on a full ring and fail the write
+         */
+        tradeRingSink_t(spscRing_t<trade_t> &ring, const std::atomic<bool> &abort)
+            : m_ring(&ring),
+              m_abort(&abort),
+              m_pending(),
+              m_numPending(){};
+
+        bool write(const std::byte *data, size_t numBytes);
+        bool writeTrade(const trade_t *t);
+
+        /**
+         * @brief Pushes every trade held back so far
+         *
+         * @return False if the consumer gave up before they all fit
+         */
+        bool flushTrades();
+
+    private:
+        spscRing_t<trade_t> *m_ring;      // Where trades go
+        const std::atomic<bool> *m_abort; // Set by the consumer if it's given up
+
+        std::array<trade_t, TRADE_RING_BATCH_SIZE> m_pending; // Trades not pushed yet
+        size_t m_numPending;                                  // How many of m_pending are filled
+    };
+
+    static_assert(byteSource_c<streamSource_t>);
+    static_assert(byteSource_c<prefetchSource_t>);
+    static_assert(byteSource_c<mappedSource_t>);
+    static_assert(byteSource_c<memorySource_t>);
+    static_assert(byteSource_c<uringSource_t>);
+    static_assert(seekableSource_c<streamSource_t>);
+    static_assert(seekableSource_c<mappedSource_t>);
+    static_assert(seekableSource_c<memorySource_t>);
+    static_assert(seekableSource_c<uringSource_t>);
+    static_assert(byteSink_c<streamSink_t>);
+    static_assert(byteSink_c<memorySink_t>);
+    static_assert(byteSink_c<nullSink_t>);
+    static_assert(stableSource_c<mappedSource_t>);
+    static_assert(stableSource_c<memorySource_t>);
+    static_assert(byteSink_c<uringSink_t>);
+    static_assert(batchingTradeSink_c<tradeRingSink_t>);
+};
@@ -0,0 +1,118 @@
+#include "marketPacketMappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace marketPacket
+{
+    mappedInputFile_t::mappedInputFile_t(const std::string &path)
+        : m_fd(-1),
+          m_data(nullptr),
+          m_size(),
+          m_readAheadOffset()
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return;
+        }
+
+        // mmap() refuses zero length mappings, but an empty file is still a valid (empty) input
+        if (st.st_size > 0)
+        {
+            void *mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                ::close(fd);
+                return;
+            }
+
+            m_data = static_cast<std::byte *>(mapping);
+            m_size = st.st_size;
+
+            // We only ever walk front to back, so let the kernel read aggressively and drop pages behind us
+            ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        m_fd = fd;
+        readAhead(0);
+    }
+
+    mappedInputFile_t::~mappedInputFile_t()
+    {
+        unmap();
+    }
+
+    mappedInputFile_t::mappedInputFile_t(mappedInputFile_t &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1)),
+          m_data(std::exchange(other.m_data, nullptr)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_readAheadOffset(std::exchange(other.m_readAheadOffset, 0))
+    {
+    }
+
+    mappedInputFile_t &mappedInputFile_t::operator=(mappedInputFile_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+
+            m_fd = std::exchange(other.m_fd, -1);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_readAheadOffset = std::exchange(other.m_readAheadOffset, 0);
+        }
+
+        return *this;
+    }
+
+    void mappedInputFile_t::readAhead(size_t offset)
+    {
+        // Still inside a window we already asked for
+        if (offset < m_readAheadOffset || m_readAheadOffset >= m_size)
+        {
+            return;
+        }
+
+        // Ask for the window after the one we're in, so it's paged in by the time we get there
+        size_t windowStart = (offset / READAHEAD_WINDOW_SIZE) * READAHEAD_WINDOW_SIZE;
+        size_t windowEnd = windowStart + 2 * READAHEAD_WINDOW_SIZE;
+        if (windowEnd > m_size)
+        {
+            windowEnd = m_size;
+        }
+
+        ::madvise(m_data + windowStart, windowEnd - windowStart, MADV_WILLNEED);
+        m_readAheadOffset = windowStart + READAHEAD_WINDOW_SIZE;
+    }
+
+    void mappedInputFile_t::unmap()
+    {
+        if (m_data != nullptr)
+        {
+            ::munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        m_size = 0;
+        m_readAheadOffset = 0;
+    }
+};
@@ -0,0 +1,324 @@
+#include "marketPacketUring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace marketPacket
+{
+    namespace
+    {
+        int ioUringSetup(unsigned entries, io_uring_params *params)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        int ioUringRegister(int ringFd, unsigned opcode, const void *arg, unsigned numArgs)
+        {
+            return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, opcode, arg, numArgs));
+        }
+
+        // The kernel reads / writes these concurrently with us, so every touch goes through an atomic_ref
+        unsigned loadAcquire(unsigned *p) { return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire); }
+        void storeRelease(unsigned *p, unsigned v) { std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release); }
+    }
+
+    ioRing_t::ioRing_t(unsigned entries)
+        : m_ringFd(-1),
+          m_sqMapping(nullptr),
+          m_sqMapSize(),
+          m_cqMapping(nullptr),
+          m_cqMapSize(),
+          m_sqes(nullptr),
+          m_sqesSize(),
+          m_sqHead(nullptr),
+          m_sqTail(nullptr),
+          m_sqArray(nullptr),
+          m_sqMask(),
+          m_sqEntries(),
+          m_cqHead(nullptr),
+          m_cqTail(nullptr),
+          m_cqes(nullptr),
+          m_cqMask(),
+          m_toSubmit(),
+          m_fixedBuffers(false)
+    {
+        // Nothing to set up, this is the empty state a move starts from
+        if (entries == 0)
+        {
+            return;
+        }
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        int ringFd = ioUringSetup(entries, &params);
+        if (ringFd < 0)
+        {
+            return;
+        }
+
+        // Keep the fd now so close() cleans up if any of the mappings fail
+        m_ringFd = ringFd;
+
+        m_sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // Newer kernels let both rings share one mapping
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+        {
+            m_sqMapSize = std::max(m_sqMapSize, m_cqMapSize);
+        }
+
+        void *sqMapping = ::mmap(nullptr, m_sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqMapping == MAP_FAILED)
+        {
+            close();
+            return;
+        }
+        m_sqMapping = sqMapping;
+
+        void *cqBase = sqMapping;
+        if (!singleMapping)
+        {
+            void *cqMapping = ::mmap(nullptr, m_cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqMapping == MAP_FAILED)
+            {
+                close();
+                return;
+            }
+
+            m_cqMapping = cqMapping;
+            cqBase = cqMapping;
+        }
+
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            close();
+            return;
+        }
+        m_sqes = sqes;
+
+        std::byte *sqBytes = static_cast<std::byte *>(sqMapping);
+        m_sqHead = reinterpret_cast<unsigned *>(sqBytes + params.sq_off.head);
+        m_sqTail = reinterpret_cast<unsigned *>(sqBytes + params.sq_off.tail);
+        m_sqArray = reinterpret_cast<unsigned *>(sqBytes + params.sq_off.array);
+        m_sqMask = *reinterpret_cast<unsigned *>(sqBytes + params.sq_off.ring_mask);
+        m_sqEntries = params.sq_entries;
+
+        std::byte *cqBytes = static_cast<std::byte *>(cqBase);
+        m_cqHead = reinterpret_cast<unsigned *>(cqBytes + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned *>(cqBytes + params.cq_off.tail);
+        m_cqes = cqBytes + params.cq_off.cqes;
+        m_cqMask = *reinterpret_cast<unsigned *>(cqBytes + params.cq_off.ring_mask);
+    }
+
+    ioRing_t::~ioRing_t()
+    {
+        close();
+    }
+
+    ioRing_t::ioRing_t(ioRing_t &&other) noexcept
+        : ioRing_t(0)
+    {
+        *this = std::move(other);
+    }
+
+    ioRing_t &ioRing_t::operator=(ioRing_t &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+
+            m_ringFd = std::exchange(other.m_ringFd, -1);
+            m_sqMapping = std::exchange(other.m_sqMapping, nullptr);
+            m_sqMapSize = std::exchange(other.m_sqMapSize, 0);
+            m_cqMapping = std::exchange(other.m_cqMapping, nullptr);
+            m_cqMapSize = std::exchange(other.m_cqMapSize, 0);
+            m_sqes = std::exchange(other.m_sqes, nullptr);
+            m_sqesSize = std::exchange(other.m_sqesSize, 0);
+            m_sqHead = std::exchange(other.m_sqHead, nullptr);
+            m_sqTail = std::exchange(other.m_sqTail, nullptr);
+            m_sqArray = std::exchange(other.m_sqArray, nullptr);
+            m_sqMask = std::exchange(other.m_sqMask, 0);
+            m_sqEntries = std::exchange(other.m_sqEntries, 0);
+            m_cqHead = std::exchange(other.m_cqHead, nullptr);
+            m_cqTail = std::exchange(other.m_cqTail, nullptr);
+            m_cqes = std::exchange(other.m_cqes, nullptr);
+            m_cqMask = std::exchange(other.m_cqMask, 0);
+            m_toSubmit = std::exchange(other.m_toSubmit, 0);
+            m_fixedBuffers = std::exchange(other.m_fixedBuffers, false);
+        }
+
+        return *this;
+    }
+
+    bool ioRing_t::available()
+    {
+        // Seccomp'd containers and old kernels both just fail the setup
+        static const bool isAvailable = ioRing_t(2).isOpen();
+        return isAvailable;
+    }
+
+    bool ioRing_t::registerBuffers(std::span<const iovec> buffers)
+    {
+        if (!isOpen() || m_fixedBuffers)
+        {
+            return false;
+        }
+
+        m_fixedBuffers = ioUringRegister(m_ringFd, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size()) == 0;
+        return m_fixedBuffers;
+    }
+
+    bool ioRing_t::prepRead(int fd, std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData)
+    {
+        return prep(m_fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ, fd, buf, numBytes, offset, bufIndex, userData);
+    }
+
+    bool ioRing_t::prepWrite(int fd, const std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData)
+    {
+        return prep(m_fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, buf, numBytes, offset, bufIndex, userData);
+    }
+
+    bool ioRing_t::prep(uint8_t opcode, int fd, const std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData)
+    {
+        if (!isOpen())
+        {
+            return false;
+        }
+
+        // We're the only one moving the tail, the kernel only ever moves the head
+        const unsigned tail = *m_sqTail;
+        if (tail - loadAcquire(m_sqHead) == m_sqEntries)
+        {
+            if (!submit() || tail - loadAcquire(m_sqHead) == m_sqEntries)
+            {
+                return false;
+            }
+        }
+
+        const unsigned index = tail & m_sqMask;
+        io_uring_sqe &sqe = static_cast<io_uring_sqe *>(m_sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.addr = reinterpret_cast<uint64_t>(buf);
+        sqe.len = numBytes;
+        sqe.user_data = userData;
+        if (opcode == IORING_OP_READ_FIXED || opcode == IORING_OP_WRITE_FIXED)
+        {
+            sqe.buf_index = bufIndex;
+        }
+
+        m_sqArray[index] = index;
+        storeRelease(m_sqTail, tail + 1);
+        m_toSubmit++;
+
+        return true;
+    }
+
+    bool ioRing_t::submit()
+    {
+        return enter(0);
+    }
+
+    bool ioRing_t::waitCompletion(completion_t &completion)
+    {
+        if (!isOpen())
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            // We're the only one moving the head, the kernel only ever moves the tail
+            const unsigned head = *m_cqHead;
+            if (head != loadAcquire(m_cqTail))
+            {
+                const io_uring_cqe &cqe = static_cast<const io_uring_cqe *>(m_cqes)[head & m_cqMask];
+                completion.userData = cqe.user_data;
+                completion.result = cqe.res;
+
+                storeRelease(m_cqHead, head + 1);
+                return true;
+            }
+
+            if (!enter(1))
+            {
+                return false;
+            }
+        }
+    }
+
+    bool ioRing_t::enter(unsigned minComplete)
+    {
+        if (m_toSubmit == 0 && minComplete == 0)
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            int submitted = ioUringEnter(m_ringFd, m_toSubmit, minComplete, (minComplete > 0) ? IORING_ENTER_GETEVENTS : 0);
+            if (submitted >= 0)
+            {
+                m_toSubmit -= std::min<unsigned>(submitted, m_toSubmit);
+                return true;
+            }
+
+            // Signals can interrupt the wait, nothing actually went wrong
+            if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    void ioRing_t::close()
+    {
+        if (m_sqes != nullptr)
+        {
+            ::munmap(m_sqes, m_sqesSize);
+            m_sqes = nullptr;
+        }
+
+        if (m_cqMapping != nullptr)
+        {
+            ::munmap(m_cqMapping, m_cqMapSize);
+            m_cqMapping = nullptr;
+        }
+
+        if (m_sqMapping != nullptr)
+        {
+            ::munmap(m_sqMapping, m_sqMapSize);
+            m_sqMapping = nullptr;
+        }
+
+        if (m_ringFd >= 0)
+        {
+            ::close(m_ringFd);
+            m_ringFd = -1;
+        }
+
+        m_toSubmit = 0;
+        m_fixedBuffers = false;
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <sys/uio.h>
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_IO_CHUNK_SIZE = 256 * 1024;
+    constexpr const size_t DEFAULT_IO_QUEUE_DEPTH = 4;
+
+    /**
+     * @brief Which way the uring sources / sinks move their bytes
+     */
+    enum class ioBackend_e : uint8_t
+    {
+        BLOCKING = 0, // pread() / pwrite() one chunk at a time
+        URING         // Keep up to queueDepth chunks in flight through io_uring
+    };
+
+    /**
+     * @brief How the uring sources / sinks should do their I/O
+     *
+     * Asking for URING on a kernel (or sandbox) without io_uring quietly gets BLOCKING instead
+     */
+    struct ioConfig_t
+    {
+        ioBackend_e backend = ioBackend_e::URING;
+        size_t chunkSize = DEFAULT_IO_CHUNK_SIZE;   // Bytes per read / write we hand the kernel. At least READ_BUFFER_SIZE
+        size_t queueDepth = DEFAULT_IO_QUEUE_DEPTH; // How many chunks we own, and so how many can be in flight. At least 2
+    };
+
+    /**
+     * Bare bones io_uring instance, talking to the kernel through the raw syscalls
+     *
+     * Only does what the uring sources / sinks need: fixed buffer reads and writes at an offset, and waiting on completions.
+     * Not thread safe, one thread submits and reaps
+     */
+    class ioRing_t
+    {
+    public:
+        /**
+         * @brief A finished read / write
+         */
+        struct completion_t
+        {
+            uint64_t userData; // Whatever was handed to prepRead() / prepWrite()
+            int32_t result;    // Bytes transferred, or -errno
+        };
+
+        /**
+         * @brief Sets up a ring. If the kernel says no, isOpen() will return false
+         *
+         * @param entries How many requests can be queued at once
+         */
+        explicit ioRing_t(unsigned entries);
+        ~ioRing_t();
+
+        ioRing_t(ioRing_t &&other) noexcept;
+        ioRing_t &operator=(ioRing_t &&other) noexcept;
+
+        ioRing_t(const ioRing_t &) = delete;
+        ioRing_t &operator=(const ioRing_t &) = delete;
+
+        /**
+         * @brief Whether this process can use io_uring at all
+         */
+        static bool available();
+
+        bool isOpen() const { return m_ringFd >= 0; }
+
+        /**
+         * @brief Pins buffers once up front, so fixed reads / writes skip pinning pages on every call
+         *
+         * Reads and writes still work if this fails (e.g. RLIMIT_MEMLOCK is too low), they just aren't fixed
+         *
+         * @return If the kernel took them
+         */
+        bool registerBuffers(std::span<const iovec> buffers);
+
+        /**
+         * @brief Queues a read / write. Nothing happens until submit() or waitCompletion()
+         *
+         * @param bufIndex Index of buf in what was given to registerBuffers(). Ignored if nothing's registered
+         * @return False if the submission queue is full and we couldn't make room
+         */
+        bool prepRead(int fd, std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData);
+        bool prepWrite(int fd, const std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData);
+
+        /**
+         * @brief Hands everything queued so far to the kernel
+         */
+        bool submit();
+
+        /**
+         * @brief Submits anything queued, then blocks until something finishes
+         *
+         * @return False if the kernel gave us an error instead
+         */
+        bool waitCompletion(completion_t &completion);
+
+    private:
+        bool prep(uint8_t opcode, int fd, const std::byte *buf, unsigned numBytes, uint64_t offset, uint16_t bufIndex, uint64_t userData);
+        bool enter(unsigned minComplete);
+        void close();
+
+        int m_ringFd; // io_uring fd, -1 if not open
+
+        void *m_sqMapping;  // Submission ring mapping (also the completion ring with IORING_FEAT_SINGLE_MMAP)
+        size_t m_sqMapSize; // Size of the submission ring mapping
+        void *m_cqMapping;  // Completion ring mapping, nullptr if shared with the submission ring
+        size_t m_cqMapSize; // Size of the completion ring mapping
+        void *m_sqes;       // Submission queue entries
+        size_t m_sqesSize;  // Size of the submission queue entries mapping
+
+        unsigned *m_sqHead;   // Kernel moves this as it consumes submissions
+        unsigned *m_sqTail;   // We move this as we queue submissions
+        unsigned *m_sqArray;  // Indirection from ring slot to entry
+        unsigned m_sqMask;    // Submission ring size - 1
+        unsigned m_sqEntries; // Submission ring size
+
+        unsigned *m_cqHead; // We move this as we reap completions
+        unsigned *m_cqTail; // Kernel moves this as it posts completions
+        void *m_cqes;       // Completion entries
+        unsigned m_cqMask;  // Completion ring size - 1
+
+        unsigned m_toSubmit; // Queued but not yet handed to the kernel
+        bool m_fixedBuffers; // If registerBuffers() succeeded
+    };
+};
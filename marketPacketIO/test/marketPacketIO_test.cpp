@@ -0,0 +1,451 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <linux/filter.h>
+#include <linux/io_uring.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+#include "marketPacketIO/marketPacketColumnar.h"
+#include "marketPacketIO/marketPacketCompressed.h"
+#include "marketPacketIO/marketPacketFollow.h"
+#include "marketPacketIO/marketPacketIO.h"
+#include "marketPacketIO/marketPacketMappedFile.h"
+
+namespace test
+{
+    // Ideally, this goes into a config file
+    const std::string MAPPED_PATH = "./mapped_test.dat";
+    const std::string URING_PATH = "./uring_test.dat";
+    const std::string FOLLOW_PATH = "./follow_test.dat";
+    const std::string COMPRESSED_PATH = "./compressed_test.dat";
+
+    TEST(marketPacketIOTest, mapMissingFile)
+    {
+        marketPacket::mappedInputFile_t mappedFile("./this_file_does_not_exist.dat");
+        EXPECT_FALSE(mappedFile.isOpen());
+    }
+
+    TEST(marketPacketIOTest, mapEmptyFile)
+    {
+        std::ofstream{MAPPED_PATH};
+
+        marketPacket::mappedInputFile_t mappedFile(MAPPED_PATH);
+        ASSERT_TRUE(mappedFile.isOpen());
+        EXPECT_EQ(mappedFile.size(), 0);
+    }
+
+    TEST(marketPacketIOTest, mapContentsMatch)
+    {
+        const std::string contents = "Some bytes we expect to see through the mapping";
+        ASSERT_TRUE(std::ofstream(MAPPED_PATH).write(contents.data(), contents.size()));
+
+        marketPacket::mappedInputFile_t mappedFile(MAPPED_PATH);
+        ASSERT_TRUE(mappedFile.isOpen());
+        ASSERT_EQ(mappedFile.size(), contents.size());
+        EXPECT_EQ(std::memcmp(mappedFile.data(), contents.data(), contents.size()), 0);
+
+        // Moving the mapping shouldn't unmap it
+        marketPacket::mappedInputFile_t movedFile(std::move(mappedFile));
+        EXPECT_FALSE(mappedFile.isOpen());
+        ASSERT_TRUE(movedFile.isOpen());
+        EXPECT_EQ(std::memcmp(movedFile.data(), contents.data(), contents.size()), 0);
+    }
+
+    TEST(marketPacketIOTest, uringRoundTrip)
+    {
+        // A few chunks and a bit, written and read in sizes that never line up with a chunk
+        std::vector<std::byte> contents(3 * marketPacket::READ_BUFFER_SIZE + 1234);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>(i * 7);
+        }
+
+        for (marketPacket::ioBackend_e backend : {marketPacket::ioBackend_e::BLOCKING, marketPacket::ioBackend_e::URING})
+        {
+            const marketPacket::ioConfig_t config{.backend = backend, .chunkSize = marketPacket::READ_BUFFER_SIZE, .queueDepth = 2};
+
+            {
+                marketPacket::uringSink_t sink(URING_PATH, config);
+                for (size_t offset = 0; offset < contents.size(); offset += 1000)
+                {
+                    ASSERT_TRUE(sink.write(contents.data() + offset, std::min<size_t>(1000, contents.size() - offset)));
+                }
+
+                ASSERT_TRUE(sink.flush());
+            }
+
+            marketPacket::uringSource_t source(URING_PATH, config);
+            if (backend == marketPacket::ioBackend_e::BLOCKING)
+            {
+                EXPECT_FALSE(source.usingUring());
+            }
+
+            size_t offset = 0;
+            while (source.status() == marketPacket::sourceStatus_e::GOOD)
+            {
+                const size_t numBytes = std::min<size_t>(3000, contents.size() - offset);
+                const std::byte *bytes = source.read(numBytes);
+                ASSERT_NE(bytes, nullptr);
+                ASSERT_EQ(std::memcmp(bytes, contents.data() + offset, numBytes), 0) << offset;
+                offset += numBytes;
+            }
+
+            EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+            EXPECT_EQ(offset, contents.size());
+            EXPECT_EQ(source.read(1), nullptr);
+        }
+    }
+
+    /**
+     * Makes io_uring_enter() fail with EAGAIN on this thread whenever it's only submitting, and fewer than minToSubmit
+     * at that. Waits for completions still go through, and take whatever's queued with them
+     *
+     * @return If the filter went in
+     */
+    bool failSmallSubmits(unsigned minToSubmit)
+    {
+        sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_enter, 0, 5),
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[3])),
+            BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, IORING_ENTER_GETEVENTS, 3, 0),
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[1])),
+            BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, minToSubmit, 1, 0),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EAGAIN),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        };
+        sock_fprog program{static_cast<unsigned short>(std::size(filter)), filter};
+
+        return ::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 && ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == 0;
+    }
+
+    TEST(marketPacketIOTest, uringSinkSubmitFails)
+    {
+        if (!marketPacket::ioRing_t::available())
+        {
+            GTEST_SKIP() << "No io_uring here";
+        }
+
+        // Every chunk different, so a chunk written out of a reused buffer can't match by accident
+        constexpr const size_t CHUNK_SIZE = marketPacket::WRITE_BUFFER_SIZE;
+        std::vector<std::byte> contents(5 * CHUNK_SIZE + 1234);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>(i * 7 + (i / CHUNK_SIZE) * 101);
+        }
+
+        // The first three chunks are queued but their submits fail, then the fourth goes through, reusing the first
+        // chunk's buffer. Only safe if the first chunk's write is still treated as in flight
+        bool filtered = false;
+        bool written = false;
+        std::thread writer([&]()
+                           {
+                             filtered = failSmallSubmits(4);
+                             if (!filtered)
+                             {
+                               return;
+                             }
+
+                             marketPacket::uringSink_t sink(URING_PATH, marketPacket::ioConfig_t{.backend = marketPacket::ioBackend_e::URING, .chunkSize = CHUNK_SIZE, .queueDepth = 3});
+                             written = sink.usingUring() && sink.write(contents.data(), contents.size()) && sink.flush(); });
+        writer.join();
+
+        if (!filtered)
+        {
+            GTEST_SKIP() << "Can't install a seccomp filter here";
+        }
+
+        ASSERT_TRUE(written);
+
+        std::ifstream iStream(URING_PATH, std::ios::binary);
+        std::vector<char> fileContents((std::istreambuf_iterator<char>(iStream)), std::istreambuf_iterator<char>());
+        ASSERT_EQ(fileContents.size(), contents.size());
+        EXPECT_EQ(std::memcmp(fileContents.data(), contents.data(), contents.size()), 0);
+    }
+
+    TEST(marketPacketIOTest, uringSeek)
+    {
+        std::vector<std::byte> contents(3 * marketPacket::READ_BUFFER_SIZE + 1234);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>(i * 13);
+        }
+        ASSERT_TRUE(std::ofstream(URING_PATH).write(reinterpret_cast<const char *>(contents.data()), contents.size()));
+
+        for (marketPacket::ioBackend_e backend : {marketPacket::ioBackend_e::BLOCKING, marketPacket::ioBackend_e::URING})
+        {
+            marketPacket::uringSource_t source(URING_PATH, marketPacket::ioConfig_t{.backend = backend, .chunkSize = marketPacket::READ_BUFFER_SIZE, .queueDepth = 2});
+
+            // Backwards, forwards past what's in flight, and right to the end
+            for (size_t offset : {size_t{2 * marketPacket::READ_BUFFER_SIZE + 5}, size_t{17}, contents.size() - 100})
+            {
+                ASSERT_TRUE(source.seek(offset));
+                const std::byte *bytes = source.read(100);
+                ASSERT_NE(bytes, nullptr);
+                EXPECT_EQ(std::memcmp(bytes, contents.data() + offset, 100), 0) << offset;
+            }
+
+            EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+            EXPECT_FALSE(source.seek(contents.size() + 1));
+        }
+    }
+
+    TEST(marketPacketIOTest, uringMissingFile)
+    {
+        marketPacket::uringSource_t source("./this_file_does_not_exist.dat");
+        EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::CLOSED);
+        EXPECT_EQ(source.read(1), nullptr);
+    }
+
+    TEST(marketPacketIOTest, prefetchReadsAcrossBuffers)
+    {
+        std::vector<std::byte> contents(10000);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>(i * 13);
+        }
+
+        ASSERT_TRUE(std::ofstream(MAPPED_PATH).write(reinterpret_cast<const char *>(contents.data()), contents.size()));
+
+        // Tiny buffers, so reads land inside one, straddle two, and span several
+        for (size_t readSize : {size_t{100}, size_t{1024}, size_t{3000}})
+        {
+            marketPacket::prefetchSource_t source(std::ifstream{MAPPED_PATH}, marketPacket::readConfig_t{.bufferSize = 1024, .numBuffers = 2});
+
+            size_t offset = 0;
+            while (source.status() == marketPacket::sourceStatus_e::GOOD)
+            {
+                const size_t numBytes = std::min(readSize, contents.size() - offset);
+                const std::byte *bytes = source.read(numBytes);
+                ASSERT_NE(bytes, nullptr);
+                ASSERT_EQ(std::memcmp(bytes, contents.data() + offset, numBytes), 0) << readSize << " " << offset;
+                offset += numBytes;
+            }
+
+            EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+            EXPECT_EQ(offset, contents.size());
+            EXPECT_EQ(source.read(1), nullptr);
+        }
+    }
+
+    TEST(marketPacketIOTest, prefetchMissingFile)
+    {
+        marketPacket::prefetchSource_t source(std::ifstream{"./this_file_does_not_exist.dat"});
+        EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::CLOSED);
+        EXPECT_EQ(source.read(1), nullptr);
+    }
+
+    TEST(marketPacketIOTest, columnarRejectsGarbage)
+    {
+        EXPECT_FALSE(marketPacket::columnarFile_t("./this_file_does_not_exist.dat").isValid());
+
+        const std::string contents = "Definitely not a columnar file";
+        ASSERT_TRUE(std::ofstream(MAPPED_PATH).write(contents.data(), contents.size()));
+        EXPECT_FALSE(marketPacket::columnarFile_t(MAPPED_PATH).isValid());
+
+        // Just a header is a valid, empty, file
+        {
+            marketPacket::columnarSink_t sink(std::ofstream{MAPPED_PATH});
+        }
+
+        marketPacket::columnarFile_t columnar(MAPPED_PATH);
+        EXPECT_TRUE(columnar.isValid());
+        EXPECT_TRUE(columnar.blocks().empty());
+    }
+
+    /**
+     * A symbol ID past the ones the file has defined so far would have us size the symbol table by whatever it says
+     */
+    TEST(marketPacketIOTest, columnarRejectsBadSymbolId)
+    {
+        constexpr const size_t ROWS_PER_BLOCK = 4;
+
+        {
+            marketPacket::columnarSink_t sink(std::ofstream{MAPPED_PATH}, ROWS_PER_BLOCK);
+            for (marketPacket::symbolId_t symbolId : {0, 1, 2})
+            {
+                marketPacket::trade_t trade{};
+                std::memset(trade.symbol, 'A' + symbolId, marketPacket::SYMBOL_LENGTH);
+                ASSERT_TRUE(sink.writeTrade(&trade, symbolId));
+            }
+        }
+
+        EXPECT_EQ(marketPacket::columnarFile_t(MAPPED_PATH).symbol(2), "CCCCC");
+
+        std::ifstream iStream(MAPPED_PATH, std::ios::binary);
+        std::vector<char> contents{std::istreambuf_iterator<char>(iStream), std::istreambuf_iterator<char>()};
+        iStream.close();
+
+        // Symbols go out last, so the final block holds them
+        const size_t symbolBlock = contents.size() - marketPacket::columnBlockSize(marketPacket::columnTable_e::SYMBOLS, ROWS_PER_BLOCK);
+        const size_t idColumn = symbolBlock + marketPacket::columnOffset(marketPacket::columnTable_e::SYMBOLS, marketPacket::SYMBOL_ID, ROWS_PER_BLOCK);
+        const marketPacket::symbolId_t badId = std::numeric_limits<marketPacket::symbolId_t>::max();
+        std::memcpy(contents.data() + idColumn + sizeof(marketPacket::symbolId_t), &badId, sizeof(badId));
+
+        ASSERT_TRUE(std::ofstream(MAPPED_PATH, std::ios::trunc | std::ios::binary).write(contents.data(), contents.size()));
+        EXPECT_FALSE(marketPacket::columnarFile_t(MAPPED_PATH).isValid());
+    }
+
+    TEST(marketPacketIOTest, columnarBlocksAreAligned)
+    {
+        for (marketPacket::columnTable_e table : {marketPacket::columnTable_e::TRADES, marketPacket::columnTable_e::QUOTES, marketPacket::columnTable_e::SYMBOLS})
+        {
+            for (size_t column = 0; column <= marketPacket::columnWidths(table).size(); column++)
+            {
+                EXPECT_EQ(marketPacket::columnOffset(table, column, 1000) % marketPacket::COLUMN_ALIGNMENT, 0);
+            }
+        }
+    }
+
+    /**
+     * Reads have to wait on a writer that's still going, in both wait modes
+     */
+    TEST(marketPacketIOTest, followWaitsForWriter)
+    {
+        std::vector<std::byte> contents(2 * marketPacket::READ_BUFFER_SIZE + 321);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>(i * 11);
+        }
+
+        for (marketPacket::followWait_e wait : {marketPacket::followWait_e::POLL, marketPacket::followWait_e::INOTIFY})
+        {
+            std::ofstream(FOLLOW_PATH, std::ios::trunc);
+
+            marketPacket::followSource_t source(FOLLOW_PATH, marketPacket::followConfig_t{.wait = wait, .idleTimeout = std::chrono::milliseconds(20)});
+            if (wait == marketPacket::followWait_e::POLL)
+            {
+                EXPECT_FALSE(source.usingInotify());
+            }
+
+            // Nothing's there yet
+            EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+
+            // Pieces that never line up with the reads
+            std::thread writer([&contents]()
+                               {
+                                   std::ofstream oStream(FOLLOW_PATH, std::ios::app | std::ios::binary);
+                                   for (size_t offset = 0; offset < contents.size(); offset += 1000)
+                                   {
+                                       oStream.write(reinterpret_cast<const char *>(contents.data() + offset), std::min<size_t>(1000, contents.size() - offset));
+                                       oStream.flush();
+                                       std::this_thread::sleep_for(std::chrono::microseconds(200));
+                                   } });
+
+            size_t offset = 0;
+            while (offset < contents.size())
+            {
+                const size_t numBytes = std::min<size_t>(3000, contents.size() - offset);
+                const std::byte *bytes = source.read(numBytes);
+                ASSERT_NE(bytes, nullptr);
+                ASSERT_EQ(std::memcmp(bytes, contents.data() + offset, numBytes), 0) << offset;
+                offset += numBytes;
+            }
+
+            writer.join();
+            EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+
+            // Stopped, a read we can't fill gives up instead of waiting
+            source.stop();
+            EXPECT_EQ(source.read(1), nullptr);
+        }
+    }
+
+    TEST(marketPacketIOTest, followMissingFile)
+    {
+        marketPacket::followSource_t source("./this_file_does_not_exist.dat");
+        EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::CLOSED);
+        EXPECT_EQ(source.read(1), nullptr);
+    }
+
+    /**
+     * Every codec should give back exactly what went in, with reads landing inside a block, straddling two and spanning several
+     */
+    TEST(marketPacketIOTest, compressedRoundTrip)
+    {
+        // Repetitive enough to compress, but not so much that a block is all one byte
+        std::vector<std::byte> contents(10000);
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<std::byte>((i % 32 < 8) ? i / 32 : i % 7);
+        }
+
+        for (marketPacket::compressionCodec_e codec : {marketPacket::compressionCodec_e::NONE, marketPacket::compressionCodec_e::LZ4, marketPacket::compressionCodec_e::ZSTD})
+        {
+            {
+                marketPacket::compressedSink_t sink(std::ofstream{COMPRESSED_PATH}, marketPacket::compressionConfig_t{.codec = codec, .blockSize = 1024});
+                ASSERT_TRUE(sink.write(contents.data(), 700));
+                ASSERT_TRUE(sink.write(contents.data() + 700, contents.size() - 700));
+            }
+
+            std::ifstream compressed(COMPRESSED_PATH, std::ios::binary | std::ios::ate);
+            const size_t compressedSize = compressed.tellg();
+            if (codec == marketPacket::compressionCodec_e::NONE)
+            {
+                EXPECT_EQ(compressedSize, contents.size() + 10 * sizeof(marketPacket::compressedBlockHeader_t));
+            }
+            else
+            {
+                EXPECT_LT(compressedSize, contents.size() / 2) << static_cast<int>(codec);
+            }
+
+            for (size_t readSize : {size_t{100}, size_t{1024}, size_t{3000}})
+            {
+                marketPacket::compressedSource_t source(std::ifstream{COMPRESSED_PATH}, 2);
+
+                size_t offset = 0;
+                while (source.status() == marketPacket::sourceStatus_e::GOOD)
+                {
+                    const size_t numBytes = std::min(readSize, contents.size() - offset);
+                    const std::byte *bytes = source.read(numBytes);
+                    ASSERT_NE(bytes, nullptr);
+                    ASSERT_EQ(std::memcmp(bytes, contents.data() + offset, numBytes), 0) << static_cast<int>(codec) << " " << readSize << " " << offset;
+                    offset += numBytes;
+                }
+
+                EXPECT_EQ(source.status(), marketPacket::sourceStatus_e::END_OF_FILE);
+                EXPECT_EQ(offset, contents.size());
+                EXPECT_EQ(source.read(1), nullptr);
+            }
+        }
+    }
+
+    /**
+     * A block cut short, or one that isn't a block at all, is an error rather than the end of the file
+     */
+    TEST(marketPacketIOTest, compressedRejectsGarbage)
+    {
+        marketPacket::compressedSource_t missing(std::ifstream{"./this_file_does_not_exist.dat"});
+        EXPECT_EQ(missing.status(), marketPacket::sourceStatus_e::CLOSED);
+        EXPECT_EQ(missing.read(1), nullptr);
+
+        const std::string contents = "Definitely not a compressed file";
+        ASSERT_TRUE(std::ofstream(COMPRESSED_PATH).write(contents.data(), contents.size()));
+        EXPECT_EQ(marketPacket::compressedSource_t(std::ifstream{COMPRESSED_PATH}).status(), marketPacket::sourceStatus_e::BAD);
+
+        std::vector<std::byte> block(5000, std::byte{'A'});
+        {
+            marketPacket::compressedSink_t sink(std::ofstream{COMPRESSED_PATH}, marketPacket::compressionConfig_t{.codec = marketPacket::compressionCodec_e::LZ4});
+            ASSERT_TRUE(sink.write(block.data(), block.size()));
+        }
+
+        std::ifstream whole(COMPRESSED_PATH, std::ios::binary | std::ios::ate);
+        const size_t wholeSize = whole.tellg();
+        std::filesystem::resize_file(COMPRESSED_PATH, wholeSize - 1);
+
+        marketPacket::compressedSource_t truncated(std::ifstream{COMPRESSED_PATH});
+        EXPECT_EQ(truncated.status(), marketPacket::sourceStatus_e::BAD);
+        EXPECT_EQ(truncated.read(1), nullptr);
+    }
+}
@@ -0,0 +1,197 @@
+#include "marketPacketIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "marketPacketHelpers/marketPacketClassify.h"
+#include "marketPacketHelpers/marketPacketCompact.h"
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSchema.h"
+#include "marketPacketIO/marketPacketMappedFile.h"
+
+namespace marketPacket
+{
+    namespace
+    {
+        /**
+         * @brief What the schema sets dispatch every update to while indexing. Only schemas with a time of day field have one to give
+         */
+        struct timeOfDayVisitor_t
+        {
+            uint64_t minTimeOfDay = indexEntry_t::NO_TIME_OF_DAY;
+            uint64_t maxTimeOfDay = 0;
+
+            template <typename schema_t>
+            void operator()(schema_t, const std::byte *update)
+            {
+                if constexpr (schema_t::template has<quoteTimeOfDayField_t>)
+                {
+                    const uint64_t timeOfDay = quoteTimeOfDayField_t::get(update);
+                    minTimeOfDay = std::min(minTimeOfDay, timeOfDay);
+                    maxTimeOfDay = std::max(maxTimeOfDay, timeOfDay);
+                }
+            }
+        };
+    }
+
+    template <typename schemas_t>
+    std::optional<packetIndex_t> packetIndex_t::build(const std::string &capturePath, size_t packetsPerEntry)
+    {
+        mappedInputFile_t capture(capturePath);
+        if (!capture.isOpen())
+        {
+            return std::nullopt;
+        }
+
+        packetIndex_t index;
+        index.m_packetsPerEntry = std::clamp<size_t>(packetsPerEntry, 1, std::numeric_limits<decltype(fileHeader_t::packetsPerEntry)>::max());
+
+        const std::byte *data = capture.data();
+        const size_t size = capture.size();
+
+        // Compact packets get decoded here, then walked like any fixed size packet
+        std::vector<std::byte> decoded;
+        std::vector<uint64_t> tradeMask;
+
+        uint64_t offset = 0;
+        while (size - offset >= PACKET_HEADER_SIZE)
+        {
+            packetHeader_t packetHeader;
+            std::memcpy(&packetHeader, data + offset, PACKET_HEADER_SIZE);
+
+            // Same checks the processor would fail on, nothing past here is worth indexing
+            if (packetHeader.packetLength < PACKET_HEADER_SIZE || size - offset < packetHeader.packetLength)
+            {
+                break;
+            }
+
+            // Fixed size packets of the default set step by UPDATE_SIZE, anything else by each update's own length
+            size_t bodySize = packetHeader.packetLength - PACKET_HEADER_SIZE;
+            bool fixedPacket = std::is_same_v<schemas_t, defaultSchemaSet_t> && (bodySize == packetHeader.numMarketUpdates * UPDATE_SIZE);
+            const std::byte *body = data + offset + PACKET_HEADER_SIZE;
+
+            if ((packetHeader.numMarketUpdates & COMPACT_PACKET_FLAG) != 0)
+            {
+                const size_t numUpdates = packetHeader.numMarketUpdates & ~COMPACT_PACKET_FLAG;
+                decoded.resize(numUpdates * UPDATE_SIZE);
+                tradeMask.resize(std::max<size_t>(tradeMaskWords(numUpdates), 1));
+
+                if (!decodeCompactBody(body, bodySize, numUpdates, decoded.data(), tradeMask.data()))
+                {
+                    break;
+                }
+
+                body = decoded.data();
+                bodySize = decoded.size();
+                fixedPacket = true;
+            }
+
+            timeOfDayVisitor_t times;
+            const std::optional<size_t> numDecoded = fixedPacket ? defaultSchemaSet_t::decode(body, bodySize, times)
+                                                                 : walkSchemaSet_t<schemas_t>::decode(body, bodySize, times);
+            if (numDecoded != bodySize)
+            {
+                break;
+            }
+
+            if (index.m_numPackets % index.m_packetsPerEntry == 0)
+            {
+                index.m_entries.push_back(indexEntry_t{offset, index.m_numPackets, indexEntry_t::NO_TIME_OF_DAY, 0});
+            }
+
+            indexEntry_t &entry = index.m_entries.back();
+            entry.minTimeOfDay = std::min(entry.minTimeOfDay, times.minTimeOfDay);
+            entry.maxTimeOfDay = std::max(entry.maxTimeOfDay, times.maxTimeOfDay);
+
+            offset += packetHeader.packetLength;
+            index.m_numPackets++;
+        }
+
+        index.m_captureSize = offset;
+        return index;
+    }
+
+    std::optional<packetIndex_t> packetIndex_t::load(const std::string &indexPath)
+    {
+        std::ifstream indexStream(indexPath, std::ios::binary);
+
+        fileHeader_t header;
+        if (!indexStream.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            header.magic != PACKET_INDEX_MAGIC || header.version != PACKET_INDEX_VERSION || header.packetsPerEntry == 0)
+        {
+            return std::nullopt;
+        }
+
+        // Every packet but the last few of a run starts an entry, so anything else means the file is lying
+        if (header.numEntries != header.numPackets / header.packetsPerEntry + (header.numPackets % header.packetsPerEntry != 0))
+        {
+            return std::nullopt;
+        }
+
+        // Nor can it have more entries than bytes to hold them, check before we size anything by what it says
+        const std::streampos entriesStart = indexStream.tellg();
+        if (!indexStream.seekg(0, std::ios::end))
+        {
+            return std::nullopt;
+        }
+
+        const uint64_t entriesSize = static_cast<uint64_t>(indexStream.tellg() - entriesStart);
+        if (header.numEntries > entriesSize / sizeof(indexEntry_t) || !indexStream.seekg(entriesStart))
+        {
+            return std::nullopt;
+        }
+
+        packetIndex_t index;
+        index.m_packetsPerEntry = header.packetsPerEntry;
+        index.m_numPackets = header.numPackets;
+        index.m_captureSize = header.captureSize;
+        index.m_entries.resize(header.numEntries);
+
+        if (!indexStream.read(reinterpret_cast<char *>(index.m_entries.data()), index.m_entries.size() * sizeof(indexEntry_t)))
+        {
+            return std::nullopt;
+        }
+
+        return index;
+    }
+
+    bool packetIndex_t::save(const std::string &indexPath) const
+    {
+        std::ofstream indexStream(indexPath, std::ios::binary | std::ios::trunc);
+
+        const fileHeader_t header{PACKET_INDEX_MAGIC, PACKET_INDEX_VERSION, static_cast<uint32_t>(m_packetsPerEntry), m_numPackets, m_captureSize, m_entries.size()};
+        indexStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        indexStream.write(reinterpret_cast<const char *>(m_entries.data()), m_entries.size() * sizeof(indexEntry_t));
+
+        return indexStream.flush().good();
+    }
+
+    std::optional<indexEntry_t> packetIndex_t::findPacket(uint64_t packetNumber) const
+    {
+        if (packetNumber >= m_numPackets)
+        {
+            return std::nullopt;
+        }
+
+        return m_entries[packetNumber / m_packetsPerEntry];
+    }
+
+    std::optional<indexEntry_t> packetIndex_t::findTime(uint64_t timeOfDay) const
+    {
+        // Times aren't necessarily sorted across entries, so this has to look at all of them. Still nothing next to replaying the capture
+        auto it = std::find_if(m_entries.begin(), m_entries.end(), [timeOfDay](const indexEntry_t &entry)
+                               { return entry.hasQuotes() && entry.maxTimeOfDay >= timeOfDay; });
+
+        if (it == m_entries.end())
+        {
+            return std::nullopt;
+        }
+
+        return *it;
+    }
+
+    template std::optional<packetIndex_t> packetIndex_t::build<defaultSchemaSet_t>(const std::string &capturePath, size_t packetsPerEntry);
+    template std::optional<packetIndex_t> packetIndex_t::build<variableSchemaSet_t>(const std::string &capturePath, size_t packetsPerEntry);
+};
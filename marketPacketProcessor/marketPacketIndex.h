@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketSchema.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_PACKETS_PER_INDEX_ENTRY = 1024;
+    constexpr const uint64_t PACKET_INDEX_MAGIC = 0x5844494b504d; // "MPKIDX"
+    constexpr const uint32_t PACKET_INDEX_VERSION = 1;
+
+    /**
+     * @brief Where a run of packetsPerEntry packets starts, and the quote times inside it
+     */
+    struct indexEntry_t
+    {
+        uint64_t byteOffset;   // Where the first packet's header starts in the capture
+        uint64_t packetNumber; // Which packet that is, counting from 0
+        uint64_t minTimeOfDay; // Earliest quote timeOfDay in the run, NO_TIME_OF_DAY if there were no quotes
+        uint64_t maxTimeOfDay; // Latest quote timeOfDay in the run, 0 if there were no quotes
+
+        static constexpr const uint64_t NO_TIME_OF_DAY = std::numeric_limits<uint64_t>::max();
+
+        bool hasQuotes() const { return minTimeOfDay != NO_TIME_OF_DAY; }
+    };
+
+    /**
+     * Sparse index over a capture file, one entry every packetsPerEntry packets
+     *
+     * Lets a processor jump to a packet or a time without replaying everything before it. See basicMarketPacketProcessor_t::seekToPacket()
+     */
+    class packetIndex_t
+    {
+    public:
+        packetIndex_t()
+            : m_packetsPerEntry(DEFAULT_PACKETS_PER_INDEX_ENTRY),
+              m_numPackets(),
+              m_captureSize(),
+              m_entries(){};
+
+        /**
+         * @brief Walks a whole capture file and indexes it. Stops at the first malformed or truncated packet
+         *
+         * schemas_t is the same set the processor reading the capture uses. Updates with a quoteTimeOfDayField_t give the
+         * entries their times. Explicit instantiations live at the bottom of marketPacketIndex.cpp, add new sets there
+         *
+         * @param capturePath     File to index
+         * @param packetsPerEntry Packets between entries. Smaller is faster to seek, bigger is a smaller index. Clamped
+         *                        to what the index file can hold
+         * @return Nothing if the file couldn't be opened
+         */
+        template <typename schemas_t = defaultSchemaSet_t>
+        static std::optional<packetIndex_t> build(const std::string &capturePath, size_t packetsPerEntry = DEFAULT_PACKETS_PER_INDEX_ENTRY);
+
+        /**
+         * @brief Reads back what save() wrote
+         *
+         * @return Nothing if the file is missing or isn't an index
+         */
+        static std::optional<packetIndex_t> load(const std::string &indexPath);
+
+        /**
+         * @brief Writes the index out so it doesn't have to be rebuilt
+         *
+         * @return If it all made it to the file
+         */
+        bool save(const std::string &indexPath) const;
+
+        /**
+         * @brief The entry packetNumber falls in
+         *
+         * @return Nothing if packetNumber is past the last whole packet we indexed
+         */
+        std::optional<indexEntry_t> findPacket(uint64_t packetNumber) const;
+
+        /**
+         * @brief The first entry with a quote at or after timeOfDay
+         *
+         * @return Nothing if no quote is that late
+         */
+        std::optional<indexEntry_t> findTime(uint64_t timeOfDay) const;
+
+        size_t packetsPerEntry() const { return m_packetsPerEntry; }
+        uint64_t numPackets() const { return m_numPackets; }   // Whole, well formed, packets in the capture
+        uint64_t captureSize() const { return m_captureSize; } // Bytes those packets take up, anything after wasn't indexed
+        const std::vector<indexEntry_t> &entries() const { return m_entries; }
+
+    private:
+        /**
+         * @brief What's at the start of an index file, before the entries
+         */
+        struct fileHeader_t
+        {
+            uint64_t magic;           // PACKET_INDEX_MAGIC
+            uint32_t version;         // PACKET_INDEX_VERSION
+            uint32_t packetsPerEntry; // Packets between entries
+            uint64_t numPackets;      // Packets indexed
+            uint64_t captureSize;     // Bytes indexed
+            uint64_t numEntries;      // Entries after the header
+        };
+
+        size_t m_packetsPerEntry;            // Packets between entries
+        uint64_t m_numPackets;               // Whole packets we indexed
+        uint64_t m_captureSize;              // Bytes those packets take up
+        std::vector<indexEntry_t> m_entries; // Entry i starts at packet i * m_packetsPerEntry
+    };
+};
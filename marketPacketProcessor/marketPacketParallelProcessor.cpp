@@ -0,0 +1,207 @@
+#include "marketPacketParallelProcessor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "marketPacketProcessor.h"
+
+namespace marketPacket
+{
+    template <byteSink_c sink_t>
+    marketPacketParallelProcessor_t<sink_t>::marketPacketParallelProcessor_t(mappedInputFile_t &&iFile, sink_t &&oSink, size_t numThreads, size_t chunkSize)
+        : m_mappedInput(std::move(iFile)),
+          m_sink(std::move(oSink)),
+          m_failReason(),
+          m_chunkSize(chunkSize),
+          m_scanOffset(),
+          m_mutex(),
+          m_workReady(),
+          m_chunkDone(),
+          m_pending(),
+          m_shutdown(false),
+          m_workers()
+    {
+        if (numThreads == 0)
+        {
+            numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        m_workers.reserve(numThreads);
+        for (size_t i = 0; i < numThreads; i++)
+        {
+            m_workers.emplace_back(&marketPacketParallelProcessor_t::workerLoop, this);
+        }
+    }
+
+    template <byteSink_c sink_t>
+    marketPacketParallelProcessor_t<sink_t>::~marketPacketParallelProcessor_t()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_workReady.notify_all();
+
+        for (std::thread &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    template <byteSink_c sink_t>
+    const std::optional<failReason_t> &marketPacketParallelProcessor_t<sink_t>::processAll()
+    {
+        if (!m_mappedInput.isOpen())
+        {
+            m_failReason.emplace(INPUT_STREAM_CLOSED);
+            return m_failReason;
+        }
+
+        // Enough chunks in flight to keep everyone busy while we wait on the oldest one, without holding the whole file's output in memory
+        const size_t maxChunksInFlight = 2 * m_workers.size();
+        std::deque<chunk_t> inFlight;
+
+        while (true)
+        {
+            // Keep the pool fed, unless something already went wrong
+            while (!m_failReason.has_value() && inFlight.size() < maxChunksInFlight)
+            {
+                std::optional<std::span<const std::byte>> chunkInput = scanNextChunk();
+                if (!chunkInput.has_value())
+                {
+                    break;
+                }
+
+                chunk_t &chunk = inFlight.emplace_back(chunk_t{chunkInput.value(), memorySink_t{}, std::nullopt, false});
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_pending.push_back(&chunk);
+                }
+                m_workReady.notify_one();
+            }
+
+            if (inFlight.empty())
+            {
+                break;
+            }
+
+            // Chunks have to come out in the order they went in
+            chunk_t &oldest = inFlight.front();
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_chunkDone.wait(lock, [&oldest]
+                                 { return oldest.done; });
+            }
+
+            // Once we've failed, the rest is only drained so nothing is left pointing at inFlight
+            if (!m_failReason.has_value())
+            {
+                const std::vector<std::byte> &output = oldest.output.bytes();
+                if (!output.empty() && !m_sink.write(output.data(), output.size()))
+                {
+                    m_failReason.emplace(TRADE_WRITE_FAILED);
+                }
+                else if (oldest.failReason.has_value())
+                {
+                    m_failReason.emplace(oldest.failReason.value());
+                }
+            }
+
+            inFlight.pop_front();
+        }
+
+        if (!m_failReason.has_value())
+        {
+            m_failReason.emplace(END_OF_FILE);
+        }
+
+        return m_failReason;
+    }
+
+    template <byteSink_c sink_t>
+    std::optional<std::span<const std::byte>> marketPacketParallelProcessor_t<sink_t>::scanNextChunk()
+    {
+        const size_t fileSize = m_mappedInput.size();
+        if (m_scanOffset == fileSize)
+        {
+            return std::nullopt;
+        }
+
+        const size_t chunkStart = m_scanOffset;
+        size_t chunkEnd = chunkStart;
+
+        while (chunkEnd - chunkStart < m_chunkSize)
+        {
+            if (fileSize - chunkEnd < PACKET_HEADER_SIZE)
+            {
+                chunkEnd = fileSize;
+                break;
+            }
+
+            packetHeader_t ph;
+            std::memcpy(&ph, m_mappedInput.data() + chunkEnd, PACKET_HEADER_SIZE);
+
+            // Something is off, give the rest of the file to one chunk and let its processor report what went wrong
+            if (ph.packetLength < PACKET_HEADER_SIZE || fileSize - chunkEnd < ph.packetLength)
+            {
+                chunkEnd = fileSize;
+                break;
+            }
+
+            chunkEnd += ph.packetLength;
+        }
+
+        m_mappedInput.readAhead(chunkEnd);
+        m_scanOffset = chunkEnd;
+        return std::span<const std::byte>(m_mappedInput.data() + chunkStart, chunkEnd - chunkStart);
+    }
+
+    template <byteSink_c sink_t>
+    void marketPacketParallelProcessor_t<sink_t>::workerLoop()
+    {
+        while (true)
+        {
+            chunk_t *chunk = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workReady.wait(lock, [this]
+                                 { return m_shutdown || !m_pending.empty(); });
+
+                if (m_shutdown)
+                {
+                    return;
+                }
+
+                chunk = m_pending.front();
+                m_pending.pop_front();
+            }
+
+            processChunk(*chunk);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                chunk->done = true;
+            }
+            m_chunkDone.notify_one();
+        }
+    }
+
+    template <byteSink_c sink_t>
+    void marketPacketParallelProcessor_t<sink_t>::processChunk(chunk_t &chunk)
+    {
+        basicMarketPacketProcessor_t<memorySource_t, memorySink_t> mpp(memorySource_t{chunk.input}, memorySink_t{});
+        mpp.initialize();
+
+        // Running out of chunk is the expected way for this to stop
+        const std::optional<failReason_t> &failReason = mpp.processNextPacket();
+        if (failReason.has_value() && failReason.value() != END_OF_FILE)
+        {
+            chunk.failReason.emplace(failReason.value());
+        }
+
+        chunk.output = std::move(mpp.sink());
+    }
+
+    template class marketPacketParallelProcessor_t<streamSink_t>;
+    template class marketPacketParallelProcessor_t<memorySink_t>;
+};
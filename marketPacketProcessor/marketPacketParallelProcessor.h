@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketIO/marketPacketIO.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_PARALLEL_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    /**
+     * Processes a whole mapped capture file across a pool of threads
+     *
+     * Packet boundaries are found by hopping from header to header, the file is cut into packet aligned chunks,
+     * every chunk is decoded and formatted on its own by a worker, and the outputs are written to the sink in file order.
+     * Output is identical to running a single processor over the file
+     *
+     * Explicit instantiations live at the bottom of marketPacketParallelProcessor.cpp, add new sinks there
+     */
+    template <byteSink_c sink_t>
+    class marketPacketParallelProcessor_t
+    {
+    public:
+        /**
+         * @brief Construct a new marketPacketParallelProcessor_t object
+         *
+         * @param iFile      Mapped input file, where we get our data from
+         * @param oSink      Output sink, where to write the interpreted updates
+         * @param numThreads How many workers to decode with. 0 means one per core
+         * @param chunkSize  Roughly how many bytes each worker gets at a time. Chunks always end on a packet boundary
+         */
+        marketPacketParallelProcessor_t(mappedInputFile_t &&iFile, sink_t &&oSink, size_t numThreads = 0, size_t chunkSize = DEFAULT_PARALLEL_CHUNK_SIZE);
+        ~marketPacketParallelProcessor_t();
+
+        marketPacketParallelProcessor_t(const marketPacketParallelProcessor_t &) = delete;
+        marketPacketParallelProcessor_t &operator=(const marketPacketParallelProcessor_t &) = delete;
+
+        /**
+         * @brief Processes every packet in the file
+         *
+         * @return Same as processNextPacket() on a single processor, END_OF_FILE if we got through everything
+         */
+        const std::optional<failReason_t> &processAll();
+
+        /**
+         * @brief Where we've been writing to. Mostly useful for in memory sinks
+         */
+        const sink_t &sink() const { return m_sink; }
+
+    private:
+        /**
+         * @brief One packet aligned piece of the file, and what came out of it
+         */
+        struct chunk_t
+        {
+            std::span<const std::byte> input;       // Packets in this chunk
+            memorySink_t output;                    // Formatted output for this chunk
+            std::optional<failReason_t> failReason; // Why the chunk stopped, if not because it ran out of packets
+            bool done;                              // Whether a worker has finished with it
+        };
+
+        /**
+         * @brief Hops over packet headers to find where the next chunk should end
+         *
+         * @return The next chunk, nothing if we've already handed out the whole file
+         */
+        std::optional<std::span<const std::byte>> scanNextChunk();
+
+        void workerLoop();                 // What every worker runs until we shut down
+        void processChunk(chunk_t &chunk); // Runs a regular processor over a single chunk
+
+        mappedInputFile_t m_mappedInput;          // Mapped input file
+        sink_t m_sink;                            // Output sink
+        std::optional<failReason_t> m_failReason; // Why we stopped processing
+
+        size_t m_chunkSize;  // Target chunk size in bytes
+        size_t m_scanOffset; // How far into the file we've cut chunks
+
+        std::mutex m_mutex;                  // Guards everything below
+        std::condition_variable m_workReady; // Signalled when there's a chunk to process or we're shutting down
+        std::condition_variable m_chunkDone; // Signalled when a worker finishes a chunk
+        std::deque<chunk_t *> m_pending;     // Chunks waiting for a worker
+        bool m_shutdown;                     // Tells workers to exit
+
+        std::vector<std::thread> m_workers; // Thread pool
+    };
+};
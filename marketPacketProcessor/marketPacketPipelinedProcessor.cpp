@@ -0,0 +1,108 @@
+#include "marketPacketPipelinedProcessor.h"
+
+#include <span>
+#include <thread>
+
+namespace marketPacket
+{
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketPipelinedProcessor_t<source_t, sink_t>::initialize()
+    {
+        m_decoder.initialize();
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    const std::optional<failReason_t> &marketPacketPipelinedProcessor_t<source_t, sink_t>::processAll()
+    {
+        m_abort.store(false);
+        m_decodeDone.store(false);
+
+        std::optional<failReason_t> decodeFailReason;
+        std::thread decoder([this, &decodeFailReason]
+                            {
+                                const std::optional<failReason_t> &failReason = m_decoder.processNextPacket();
+                                if (failReason.has_value())
+                                {
+                                    decodeFailReason.emplace(failReason.value());
+                                }
+
+                                // Everything pushed before this is visible to whoever sees it set
+                                m_decodeDone.store(true, std::memory_order_release);
+                                m_ring.wake(); });
+
+        formatTrades();
+        decoder.join();
+
+        // A write failure on our side is what made the decoder stop, so it's the more useful reason
+        m_failReason.reset();
+        if (m_abort.load())
+        {
+            m_failReason.emplace(TRADE_WRITE_FAILED);
+        }
+        else if (decodeFailReason.has_value())
+        {
+            m_failReason.emplace(decodeFailReason.value());
+        }
+
+        return m_failReason;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketPipelinedProcessor_t<source_t, sink_t>::formatTrades()
+    {
+        // Enough to pop a buffer's worth of text in one go
+        std::array<trade_t, WRITE_BUFFER_SIZE / MAX_TRADE_STRING_LENGTH> trades;
+
+        while (true)
+        {
+            // Sleeps while the decoder is busy, only comes back empty once it's done and everything's been popped
+            const size_t numTrades = m_ring.pop(std::span<trade_t>(trades), m_decodeDone);
+            if (numTrades == 0)
+            {
+                break;
+            }
+
+            for (size_t i = 0; i < numTrades; i++)
+            {
+                if (WRITE_BUFFER_SIZE - m_writeBufferUsed < MAX_TRADE_STRING_LENGTH && !flushWriteBuffer())
+                {
+                    abort();
+                    return;
+                }
+
+                char *writePos = m_writeBuffer.data() + m_writeBufferUsed;
+                m_writeBufferUsed += formatTrade(writePos, &trades[i]) - writePos;
+            }
+        }
+
+        if (!flushWriteBuffer())
+        {
+            abort();
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketPipelinedProcessor_t<source_t, sink_t>::abort()
+    {
+        m_abort.store(true, std::memory_order_release);
+        m_ring.wake();
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    bool marketPacketPipelinedProcessor_t<source_t, sink_t>::flushWriteBuffer()
+    {
+        if (m_writeBufferUsed == 0)
+        {
+            return true;
+        }
+
+        const bool written = m_sink.write(reinterpret_cast<const std::byte *>(m_writeBuffer.data()), m_writeBufferUsed);
+        m_writeBufferUsed = 0;
+        return written;
+    }
+
+    template class marketPacketPipelinedProcessor_t<streamSource_t, streamSink_t>;
+    template class marketPacketPipelinedProcessor_t<mappedSource_t, streamSink_t>;
+    template class marketPacketPipelinedProcessor_t<memorySource_t, streamSink_t>;
+    template class marketPacketPipelinedProcessor_t<memorySource_t, memorySink_t>;
+};
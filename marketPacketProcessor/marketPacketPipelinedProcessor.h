@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSpscRing.h"
+#include "marketPacketIO/marketPacketIO.h"
+#include "marketPacketProcessor.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_TRADE_RING_CAPACITY = 16384;
+
+    /**
+     * Processes a source on two threads, with the stages overlapping instead of taking turns
+     *
+     * A decoder thread reads, validates and decodes packets, applies quotes to the book, and copies every trade into an SPSC ring.
+     * The calling thread pops trades off the ring in batches, formats them, and writes them to the sink.
+     * Output is identical to running a single processor over the same source
+     *
+     * Explicit instantiations live at the bottom of marketPacketPipelinedProcessor.cpp, add new sources / sinks there
+     */
+    template <byteSource_c source_t, byteSink_c sink_t>
+    class marketPacketPipelinedProcessor_t
+    {
+    public:
+        /**
+         * @brief Construct a new marketPacketPipelinedProcessor_t object
+         *
+         * @param iSource      Input source, where we get our data from
+         * @param oSink        Output sink, where to write the interpreted updates
+         * @param ringCapacity How many decoded trades can be waiting on the formatter before the decoder has to wait
+         */
+        marketPacketPipelinedProcessor_t(source_t &&iSource, sink_t &&oSink, size_t ringCapacity = DEFAULT_TRADE_RING_CAPACITY)
+            : m_ring(ringCapacity),
+              m_abort(false),
+              m_decodeDone(false),
+              m_decoder(std::move(iSource), tradeRingSink_t{m_ring, m_abort}),
+              m_failReason(),
+              m_writeBuffer(),
+              m_writeBufferUsed(),
+              m_sink(std::move(oSink)){};
+
+        marketPacketPipelinedProcessor_t(const marketPacketPipelinedProcessor_t &) = delete;
+        marketPacketPipelinedProcessor_t &operator=(const marketPacketPipelinedProcessor_t &) = delete;
+
+        /**
+         * @brief Sets up the processor for use. Processor won't work unless this is called
+         */
+        void initialize();
+
+        /**
+         * @brief Processes everything in the source
+         *
+         * @return Same as processNextPacket() on a single processor, END_OF_FILE if we got through everything
+         */
+        const std::optional<failReason_t> &processAll();
+
+        /**
+         * @brief Where we've been writing to. Mostly useful for in memory sinks
+         */
+        const sink_t &sink() const { return m_sink; }
+
+        /**
+         * @brief Built up by the decoder thread. Only look at these once processAll() has returned
+         */
+        const symbolTable_t &symbolTable() const { return m_decoder.symbolTable(); }
+        const quoteBook_t &quoteBook() const { return m_decoder.quoteBook(); }
+
+    private:
+        /**
+         * @brief Formatter side. Drains the ring until the decoder is done or we fail to write
+         */
+        void formatTrades();
+
+        /**
+         * @brief Tells the decoder we've given up, waking it if it's waiting on a full ring
+         */
+        void abort();
+
+        /**
+         * @brief Hands everything in the write buffer to the output sink
+         *
+         * @return If the sink took it
+         */
+        bool flushWriteBuffer();
+
+        spscRing_t<trade_t> m_ring;     // Decoded trades on their way to the formatter
+        std::atomic<bool> m_abort;      // Set by the formatter if it can't write, so the decoder stops waiting on it
+        std::atomic<bool> m_decodeDone; // Set by the decoder once it's pushed its last trade
+
+        basicMarketPacketProcessor_t<source_t, tradeRingSink_t> m_decoder; // Does everything except formatting trades
+        std::optional<failReason_t> m_failReason;                          // Why we stopped processing
+
+        std::array<char, WRITE_BUFFER_SIZE> m_writeBuffer; // Where formatted trades go before we write them out in one block
+        size_t m_writeBufferUsed;                          // How much of the write buffer is filled
+
+        sink_t m_sink; // Output sink
+    };
+};
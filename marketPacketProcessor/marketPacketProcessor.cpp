@@ -1,11 +1,14 @@
 #include "marketPacketProcessor.h"
 
-#include <fstream>
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <assert.h>
 
 namespace marketPacket
 {
-    void marketPacketProcessor_t::initialize()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::initialize()
     {
         // Make sure this only gets called once
         if (m_state != state_t::UNINITIALIZED)
@@ -14,20 +17,127 @@ namespace marketPacket
             return;
         }
 
-        m_tradeLocs.reserve(READ_BUFFER_SIZE / UPDATE_SIZE);
+        m_tradeMask.resize(tradeMaskWords(m_readSize / UPDATE_SIZE));
         m_state = state_t::CHECK_STREAM_VALIDITY;
     }
 
-    const std::optional<failReason_t> &marketPacketProcessor_t::processNextPacket(const std::optional<size_t> &numPacketsToProcess)
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    const std::optional<failReason_t> &basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::processNextPacket(const std::optional<size_t> &numPacketsToProcess)
     {
+        // A follow source only says END_OF_FILE between packets, and more may well have been written since
+        if constexpr (followSource_c<source_t>)
+        {
+            if (m_failReason == END_OF_FILE)
+            {
+                m_failReason.reset();
+                m_state = state_t::CHECK_STREAM_VALIDITY;
+            }
+        }
+
         resetPerRunVariables(numPacketsToProcess);
 
         runStateMachine();
 
+        // Whatever the reason we stopped, everything we've interpreted so far should make it out
+        flushWriteBuffer();
+
         return m_failReason;
     }
 
-    void marketPacketProcessor_t::runStateMachine()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    const std::optional<failReason_t> &basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::decodeBatch(size_t maxPackets)
+        requires stableSource_c<source_t>
+    {
+        m_batchTrades.clear();
+        m_batchTradeSymbolIds.clear();
+        m_batchQuotes.clear();
+        m_batchQuoteSymbolIds.clear();
+        m_batchCarried.clear();
+
+        m_batching = true;
+        processNextPacket(maxPackets);
+        m_batching = false;
+
+        return m_failReason;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    const std::optional<failReason_t> &basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::seekToPacket(const packetIndex_t &index, uint64_t packetNumber)
+        requires seekableSource_c<source_t>
+    {
+        if (m_state == state_t::UNINITIALIZED)
+        {
+            uninitialized();
+            return m_failReason;
+        }
+
+        // Wherever we were is gone, including any half read packet
+        m_failReason.reset();
+        m_tradeLocs.clear();
+        m_quoteLocs.clear();
+        m_state = state_t::CHECK_STREAM_VALIDITY;
+
+        std::optional<indexEntry_t> entry = index.findPacket(packetNumber);
+        if (!entry.has_value())
+        {
+            m_failReason.emplace(SEEK_TARGET_NOT_INDEXED);
+            return m_failReason;
+        }
+
+        if (!m_source.seek(entry->byteOffset))
+        {
+            m_failReason.emplace(SEEK_FAILED);
+            return m_failReason;
+        }
+
+        // The index only knows where every packetsPerEntry'th packet starts, walk the rest of the way
+        skipPackets(packetNumber - entry->packetNumber);
+        return m_failReason;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    const std::optional<failReason_t> &basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::seekToTime(const packetIndex_t &index, uint64_t timeOfDay)
+        requires seekableSource_c<source_t>
+    {
+        std::optional<indexEntry_t> entry = index.findTime(timeOfDay);
+        if (!entry.has_value())
+        {
+            m_failReason.emplace(SEEK_TARGET_NOT_INDEXED);
+            return m_failReason;
+        }
+
+        return seekToPacket(index, entry->packetNumber);
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::skipPackets(uint64_t numPackets)
+    {
+        for (uint64_t packet = 0; packet < numPackets && !m_failReason.has_value(); packet++)
+        {
+            checkStreamValidity();
+            if (m_failReason.has_value())
+            {
+                return;
+            }
+
+            readHeader();
+
+            while (!m_failReason.has_value() && m_bodyBytesInterpreted < m_bodySize)
+            {
+                const size_t toRead = std::min(m_bodySize - m_bodyBytesInterpreted, m_readSize);
+                if (m_source.read(toRead) == nullptr)
+                {
+                    m_failReason.emplace(PACKET_READ_FAILED);
+                    return;
+                }
+
+                m_bodyBytesInterpreted += toRead;
+            }
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::runStateMachine()
     {
         while (!m_failReason.has_value())
         {
@@ -56,24 +166,34 @@ namespace marketPacket
 
             case state_t::READ_HEADER:
             {
+                m_stats.startPacket();
+                const uint64_t start = m_stats.startState();
                 readHeader();
+                m_stats.endState(timedState_e::READ_HEADER, start);
+
                 m_state = state_t::READ_PART_BODY;
                 break;
             }
 
             case state_t::READ_PART_BODY:
             {
+                const uint64_t start = m_stats.startState();
                 readPartBody();
+                m_stats.endState(timedState_e::READ_PART_BODY, start);
+
                 m_state = state_t::WRITE_UPDATES;
                 break;
             }
 
             case state_t::WRITE_UPDATES:
             {
+                const uint64_t start = m_stats.startState();
                 writeUpdates();
+                m_stats.endState(timedState_e::WRITE_UPDATES, start);
 
                 if (doneWithPacket())
                 {
+                    m_stats.endPacket(m_packetHeader.packetLength);
                     m_numPacketsProcessed++;
                     m_state = state_t::CHECK_STREAM_VALIDITY;
                     break;
@@ -94,45 +214,55 @@ namespace marketPacket
         }
     }
 
-    void marketPacketProcessor_t::uninitialized()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::uninitialized()
     {
         m_failReason.emplace(UNINITIALIZED);
         return;
     }
 
-    void marketPacketProcessor_t::checkStreamValidity()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::checkStreamValidity()
     {
+        switch (m_source.status())
+        {
+        case sourceStatus_e::GOOD:
+        {
+            break;
+        }
+
         // Don't process, just return early
-        if (!m_inputStream.is_open())
+        case sourceStatus_e::CLOSED:
         {
             m_failReason.emplace(INPUT_STREAM_CLOSED);
-            return;
+            break;
         }
 
-        // Do a quick peek to set flags if we're at the end of a file
-        m_inputStream.peek();
-        if (!m_inputStream.good())
+        case sourceStatus_e::END_OF_FILE:
         {
-            if (m_inputStream.eof())
-            {
-                m_failReason.emplace(END_OF_FILE);
-            }
-            else
-            {
-                m_failReason.emplace(BAD_STREAM);
-            }
-            return;
+            m_failReason.emplace(END_OF_FILE);
+            break;
+        }
+
+        default:
+        {
+            m_failReason.emplace(BAD_STREAM);
+            break;
+        }
         }
     }
 
-    void marketPacketProcessor_t::readHeader()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::readHeader()
     {
         // Assume it's a packet header
-        if (!(m_inputStream.read(reinterpret_cast<char *>(&m_packetHeader), PACKET_HEADER_SIZE)))
+        const std::byte *headerPtr = m_source.read(PACKET_HEADER_SIZE);
+        if (headerPtr == nullptr)
         {
             m_failReason.emplace(PACKET_HEADER_READ_FAILED);
             return;
         }
+        std::memcpy(&m_packetHeader, headerPtr, PACKET_HEADER_SIZE);
 
         // Probably not a good thing
         if (m_packetHeader.packetLength < PACKET_HEADER_SIZE)
@@ -145,117 +275,436 @@ namespace marketPacket
         resetPerPacketVariables();
     }
 
-    void marketPacketProcessor_t::readPartBody()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::readPartBody()
     {
         // Figure out how much of the buffer we need to use
         size_t bytesLeft = m_bodySize - m_bodyBytesInterpreted;
-        size_t validDataInBuffer = (bytesLeft < READ_BUFFER_SIZE) ? bytesLeft : READ_BUFFER_SIZE;
+        size_t validDataInBuffer = (bytesLeft < m_readSize) ? bytesLeft : m_readSize;
 
         // Read what needs to be read
-        if (!(m_inputStream.read(reinterpret_cast<char *>(m_readBuffer.data()), validDataInBuffer)).good())
+        // Compact bodies all come in at once
+        if (m_compactPacket)
+        {
+            readCompactBody();
+            return;
+        }
+
+        const std::byte *bodyPtr = m_source.read(validDataInBuffer);
+        if (bodyPtr == nullptr)
         {
             m_failReason.emplace(PACKET_READ_FAILED);
             return;
         }
 
-        // Read the buffer until we run out of material
-        // A few tricks here because we know READ_BUFFER_SIZE % UPDATE_SIZE = 0
-        size_t bufferOffset = 0;
-        while (bufferOffset < validDataInBuffer)
+        if (!m_fixedPacket)
         {
-            const std::byte *currBufferPos = m_readBuffer.data() + bufferOffset;
-            const updateHeader_t *uh = reinterpret_cast<const updateHeader_t *>(currBufferPos);
-            if (!isUpdateValid(uh))
+            m_bodyBytesInterpreted += validDataInBuffer;
+            decodeVariableUpdates(bodyPtr, validDataInBuffer);
+
+            // Updates have to exactly fill the body, with exactly as many as the header said
+            if (!m_failReason.has_value() && m_bodyBytesInterpreted == m_bodySize && (m_carryUsed != 0 || m_numUpdatesRead != m_numUpdatesPacket))
             {
                 m_failReason.emplace(UPDATE_POORLY_FORMED);
-                return;
             }
+            return;
+        }
 
-            // Mark down we've 'read' an update of somesort
-            bufferOffset += uh->length;
-            m_bodyBytesInterpreted += uh->length;
-            m_numUpdatesRead++;
+        // Every update is UPDATE_SIZE, so anything left over can't be a whole update
+        if (validDataInBuffer % UPDATE_SIZE != 0)
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return;
+        }
 
-            switch (uh->type)
-            {
-            case updateType_e::TRADE:
+        // Validate the whole buffer in one go and find out where the trades are
+        // A few tricks here because we know m_readSize % UPDATE_SIZE = 0
+        const size_t numUpdatesInBuffer = validDataInBuffer / UPDATE_SIZE;
+        if (!classifyUpdates(bodyPtr, numUpdatesInBuffer, m_tradeMask.data()))
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return;
+        }
+
+        // Mark down we've 'read' all of them
+        m_bodyBytesInterpreted += validDataInBuffer;
+        m_numUpdatesRead += numUpdatesInBuffer;
+
+        recordClassifiedUpdates(bodyPtr, numUpdatesInBuffer);
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::readCompactBody()
+    {
+        const std::byte *bodyPtr = m_source.read(m_bodySize);
+        if (bodyPtr == nullptr)
+        {
+            m_failReason.emplace(PACKET_READ_FAILED);
+            return;
+        }
+
+        // Only grows for packets bigger than a read, so a warmed up processor doesn't allocate here
+        if (m_tradeMask.size() < tradeMaskWords(m_numUpdatesPacket))
+        {
+            m_tradeMask.resize(tradeMaskWords(m_numUpdatesPacket));
+        }
+
+        // A batch holds on to its ptrs past this packet, so it gets its own copy
+        const size_t decodedSize = m_numUpdatesPacket * UPDATE_SIZE;
+        std::byte *decoded = m_batching ? m_batchCarried.emplace_back(decodedSize).data() : m_arena.allocate<std::byte>(decodedSize);
+
+        if (!decodeCompactBody(bodyPtr, m_bodySize, m_numUpdatesPacket, decoded, m_tradeMask.data()))
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return;
+        }
+
+        m_bodyBytesInterpreted = m_bodySize;
+        m_numUpdatesRead = m_numUpdatesPacket;
+
+        recordClassifiedUpdates(decoded, m_numUpdatesPacket);
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::recordClassifiedUpdates(const std::byte *updates, size_t numUpdates)
+    {
+        // Just mark down where the updates are for now
+        for (size_t word = 0; word < tradeMaskWords(numUpdates); word++)
+        {
+            for (uint64_t tradeBits = m_tradeMask[word]; tradeBits != 0; tradeBits &= tradeBits - 1)
             {
-                // Just mark down where the trade update is for now
-                m_tradeLocs.emplace_back(currBufferPos);
-                break;
+                const std::byte *tradePtr = updates + (word * UPDATES_PER_MASK_WORD + std::countr_zero(tradeBits)) * UPDATE_SIZE;
+                m_tradeLocs.emplace_back(decodedUpdate_t{tradePtr, m_symbolTable.intern(reinterpret_cast<const trade_t *>(tradePtr)->symbol)});
             }
 
-            case updateType_e::QUOTE:
+            // Everything valid that isn't a trade is a quote, as long as it's actually in the buffer
+            const size_t updatesInWord = std::min(numUpdates - word * UPDATES_PER_MASK_WORD, UPDATES_PER_MASK_WORD);
+            const uint64_t wordMask = (updatesInWord == UPDATES_PER_MASK_WORD) ? ~uint64_t{0} : (uint64_t{1} << updatesInWord) - 1;
+            for (uint64_t quoteBits = ~m_tradeMask[word] & wordMask; quoteBits != 0; quoteBits &= quoteBits - 1)
             {
-                // Currently, we don't care about quotes. We could though
-                break;
+                const std::byte *quotePtr = updates + (word * UPDATES_PER_MASK_WORD + std::countr_zero(quoteBits)) * UPDATE_SIZE;
+                m_quoteLocs.emplace_back(decodedUpdate_t{quotePtr, m_symbolTable.intern(reinterpret_cast<const quote_t *>(quotePtr)->symbol)});
             }
+        }
+    }
 
-            default:
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::decodeVariableUpdates(const std::byte *bodyPtr, size_t numBytes)
+    {
+        size_t pos = 0;
+        if (m_carryUsed > 0)
+        {
+            pos = finishCarriedUpdate(bodyPtr, numBytes);
+            if (m_failReason.has_value() || m_carryUsed > 0)
             {
-                // You really shouldn't be able to get here
-                assert(false);
-                m_failReason.emplace(UPDATE_POORLY_FORMED);
                 return;
             }
+        }
+
+        // The schema set validates every update and hands it to recordUpdate() for whichever schema it matched
+        recordVisitor_t visitor{*this};
+        const std::optional<size_t> numDecoded = walkSchemas_t::decode(bodyPtr + pos, numBytes - pos, visitor);
+        if (!numDecoded.has_value())
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return;
+        }
+
+        // Every update was fine on its own, but there may have been more of them than the header said
+        if (m_failReason.has_value())
+        {
+            return;
+        }
+
+        pos += numDecoded.value();
+
+        // Whatever's left is the start of an update that carries on in the next read
+        const size_t leftover = numBytes - pos;
+        if (leftover > 0)
+        {
+            reserveCarry(std::max(leftover, UPDATE_SIZE));
+            std::memcpy(m_carry, bodyPtr + pos, leftover);
+        }
+
+        m_carryUsed = leftover;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    size_t basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::finishCarriedUpdate(const std::byte *bodyPtr, size_t numBytes)
+    {
+        size_t pos = 0;
+
+        // The header itself might have been split
+        if (m_carryUsed < sizeof(updateHeader_t))
+        {
+            pos = std::min(sizeof(updateHeader_t) - m_carryUsed, numBytes);
+            std::memcpy(m_carry + m_carryUsed, bodyPtr, pos);
+            m_carryUsed += pos;
+
+            if (m_carryUsed < sizeof(updateHeader_t))
+            {
+                return pos;
             }
         }
+
+        updateHeader_t uh;
+        std::memcpy(&uh, m_carry, sizeof(uh));
+        if (!walkSchemas_t::isValid(uh))
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return pos;
+        }
+
+        reserveCarry(uh.length);
+
+        const size_t toCopy = std::min(uh.length - m_carryUsed, numBytes - pos);
+        std::memcpy(m_carry + m_carryUsed, bodyPtr + pos, toCopy);
+        m_carryUsed += toCopy;
+        pos += toCopy;
+
+        if (m_carryUsed == uh.length)
+        {
+            // The finished update stays put in the arena until the packet's done, the next leftover gets its own space
+            const std::byte *carried = m_carry;
+            m_carry = nullptr;
+            m_carryCapacity = 0;
+            m_carryUsed = 0;
+
+            // A batch holds on to its ptrs past this packet, so it gets its own copy
+            if (m_batching)
+            {
+                m_batchCarried.emplace_back(carried, carried + uh.length);
+                carried = m_batchCarried.back().data();
+            }
+
+            recordVisitor_t visitor{*this};
+            walkSchemas_t::dispatch(carried, visitor);
+        }
+
+        return pos;
     }
 
-    void marketPacketProcessor_t::writeUpdates()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::reserveCarry(size_t numBytes)
     {
+        if (m_carryCapacity >= numBytes)
+        {
+            return;
+        }
+
+        // The arena can't grow an allocation in place, so take a bigger one and bring what we have so far over
+        std::byte *carry = m_arena.allocate<std::byte>(numBytes);
+        if (m_carryUsed > 0)
+        {
+            std::memcpy(carry, m_carry, m_carryUsed);
+        }
+
+        m_carry = carry;
+        m_carryCapacity = numBytes;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    template <typename schema_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::recordUpdate(const std::byte *update)
+    {
+        // There's only room for as many as the header said
+        if (m_numUpdatesRead == m_numUpdatesPacket)
+        {
+            m_failReason.emplace(UPDATE_POORLY_FORMED);
+            return;
+        }
+
+        m_numUpdatesRead++;
+
+        // Trades and quotes are read as trade_t / quote_t from here on, so a set's own take on them has to keep the usual fields
+        if constexpr (schema_t::type == updateType_e::TRADE)
+        {
+            static_assert(schema_t::template has<tradeSymbolField_t> && schema_t::template has<tradeSizeField_t> && schema_t::template has<tradePriceField_t>);
+            m_tradeLocs.emplace_back(decodedUpdate_t{update, m_symbolTable.intern(reinterpret_cast<const trade_t *>(update)->symbol)});
+        }
+        else if constexpr (schema_t::type == updateType_e::QUOTE)
+        {
+            static_assert(schema_t::template has<quoteSymbolField_t> && schema_t::template has<quotePriceLevelField_t> &&
+                          schema_t::template has<quotePriceLevelSizeField_t> && schema_t::template has<quoteTimeOfDayField_t>);
+            m_quoteLocs.emplace_back(decodedUpdate_t{update, m_symbolTable.intern(reinterpret_cast<const quote_t *>(update)->symbol)});
+        }
+        else
+        {
+            static_assert(schemaSink_c<sink_t, schema_t>, "The schema set has an update type the sink can't take");
+            if (!m_sink.writeUpdate(schema_t{}, update))
+            {
+                m_failReason.emplace(SCHEMA_UPDATE_WRITE_FAILED);
+            }
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::writeUpdates()
+    {
+        m_stats.countUpdates(m_tradeLocs.size(), m_quoteLocs.size());
+
+        // Batches just keep the ptrs, whoever asked for them decides what to do with them
+        if (m_batching)
+        {
+            for (const decodedUpdate_t &trade : m_tradeLocs)
+            {
+                m_batchTrades.push_back(reinterpret_cast<const trade_t *>(trade.update));
+                m_batchTradeSymbolIds.push_back(trade.symbolId);
+            }
+
+            for (const decodedUpdate_t &quote : m_quoteLocs)
+            {
+                m_quoteBook.applyQuote(reinterpret_cast<const quote_t *>(quote.update), quote.symbolId);
+                m_batchQuotes.push_back(reinterpret_cast<const quote_t *>(quote.update));
+                m_batchQuoteSymbolIds.push_back(quote.symbolId);
+            }
+
+            m_tradeLocs.clear();
+            m_quoteLocs.clear();
+            return;
+        }
+
         // Take all the ptrs we know about and write the information to the output stream
-        for (const std::byte *tradePtr : m_tradeLocs)
+        for (const decodedUpdate_t &trade : m_tradeLocs)
+        {
+            // Sinks that want raw trades do their own formatting, if any
+            if constexpr (updateSink_c<sink_t>)
+            {
+                if (!m_sink.writeTrade(reinterpret_cast<const trade_t *>(trade.update), trade.symbolId))
+                {
+                    m_failReason.emplace(TRADE_WRITE_FAILED);
+                    break;
+                }
+            }
+            else if constexpr (tradeSink_c<sink_t>)
+            {
+                if (!m_sink.writeTrade(reinterpret_cast<const trade_t *>(trade.update)))
+                {
+                    m_failReason.emplace(TRADE_WRITE_FAILED);
+                    break;
+                }
+            }
+            else
+            {
+                appendTradePtrToBuffer(reinterpret_cast<const trade_t *>(trade.update));
+            }
+        }
+
+        // Sinks that hold on to trades get everything from this read in one go
+        if constexpr (batchingTradeSink_c<sink_t> && !updateSink_c<sink_t>)
         {
-            appendTradePtrToStream(reinterpret_cast<const trade_t *>(tradePtr));
+            if (!m_failReason.has_value() && !m_sink.flushTrades())
+            {
+                m_failReason.emplace(TRADE_WRITE_FAILED);
+            }
         }
 
         m_tradeLocs.clear();
+
+        for (const decodedUpdate_t &quote : m_quoteLocs)
+        {
+            m_quoteBook.applyQuote(reinterpret_cast<const quote_t *>(quote.update), quote.symbolId);
+
+            if constexpr (updateSink_c<sink_t>)
+            {
+                if (!m_failReason.has_value() && !m_sink.writeQuote(reinterpret_cast<const quote_t *>(quote.update), quote.symbolId))
+                {
+                    m_failReason.emplace(QUOTE_WRITE_FAILED);
+                }
+            }
+        }
+
+        m_quoteLocs.clear();
     }
 
-    bool marketPacketProcessor_t::doneWithPacket()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    bool basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::doneWithPacket()
     {
-        return m_numUpdatesRead == m_numUpdatesPacket;
+        return m_numUpdatesRead == m_numUpdatesPacket && m_bodyBytesInterpreted == m_bodySize;
     }
 
-    void marketPacketProcessor_t::resetPerRunVariables(const std::optional<size_t> &numPacketsToProcess)
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::resetPerRunVariables(const std::optional<size_t> &numPacketsToProcess)
     {
         m_numPacketsToProcess = numPacketsToProcess;
         m_numPacketsProcessed = 0;
     }
 
-    void marketPacketProcessor_t::resetPerPacketVariables()
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::resetPerPacketVariables()
     {
-        m_numUpdatesPacket = m_packetHeader.numMarketUpdates;
+        m_compactPacket = (m_packetHeader.numMarketUpdates & COMPACT_PACKET_FLAG) != 0;
+        m_numUpdatesPacket = m_packetHeader.numMarketUpdates & ~COMPACT_PACKET_FLAG;
         m_numUpdatesRead = 0;
 
         m_bodySize = m_packetHeader.packetLength - PACKET_HEADER_SIZE;
         m_bodyBytesInterpreted = 0;
+
+        // Decided per packet, so a feed that's all UPDATE_SIZE never leaves the fast path
+        // Only the default set is known to be all trades and quotes, which is what the classify kernels look for
+        m_fixedPacket = std::is_same_v<schemas_t, defaultSchemaSet_t> && !m_compactPacket && (m_bodySize == m_numUpdatesPacket * UPDATE_SIZE);
+
+        // Nothing from the last packet is needed anymore. Every update in this one could be a trade, or a quote
+        m_arena.reset();
+        m_tradeLocs.reset(m_arena, m_numUpdatesPacket);
+        m_quoteLocs.reset(m_arena, m_numUpdatesPacket);
+        m_carry = nullptr;
+        m_carryCapacity = 0;
+        m_carryUsed = 0;
     }
 
-    bool marketPacketProcessor_t::isUpdateValid(const updateHeader_t * uh)
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::appendTradePtrToBuffer(const trade_t *t)
     {
-        // Is both the length and type something we'd expect?
-        if (uh->length == UPDATE_SIZE && (uh->type == updateType_e::TRADE || uh->type == updateType_e::QUOTE))
+        // Only go to the sink when we can't fit another trade, so it sees big blocks
+        if (WRITE_BUFFER_SIZE - m_writeBufferUsed < MAX_TRADE_STRING_LENGTH)
         {
-            return true;
+            flushWriteBuffer();
         }
 
-        return false;
+        char *writePos = m_writeBuffer.data() + m_writeBufferUsed;
+        m_writeBufferUsed += formatTrade(writePos, t) - writePos;
     }
 
-    /**
-     * std::format (C++20) would do a lot better here if it was available
-     */
-    void marketPacketProcessor_t::appendTradePtrToStream(const trade_t *t)
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t>
+    void basicMarketPacketProcessor_t<source_t, sink_t, schemas_t>::flushWriteBuffer()
     {
-        // We're relying that the outputStream knows how to buffer it's own writes
-        m_outputStream << generateTradeString(t) << '\n';
+        if (m_writeBufferUsed == 0)
+        {
+            return;
+        }
 
         // This is just a weird case
-        if (!m_outputStream.good())
+        if (!m_sink.write(reinterpret_cast<const std::byte *>(m_writeBuffer.data()), m_writeBufferUsed) && !m_failReason.has_value())
         {
             m_failReason.emplace(TRADE_WRITE_FAILED);
         }
+
+        m_writeBufferUsed = 0;
     }
+
+    template class basicMarketPacketProcessor_t<streamSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<streamSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<prefetchSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<prefetchSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<mappedSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<mappedSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<uringSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<uringSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<uringSource_t, uringSink_t>;
+    template class basicMarketPacketProcessor_t<compressedSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<compressedSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<followSource_t, streamSink_t>;
+    template class basicMarketPacketProcessor_t<followSource_t, memorySink_t>;
+    template class basicMarketPacketProcessor_t<mappedSource_t, nullSink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, nullSink_t>;
+    template class basicMarketPacketProcessor_t<streamSource_t, columnarSink_t>;
+    template class basicMarketPacketProcessor_t<mappedSource_t, columnarSink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, columnarSink_t>;
+    template class basicMarketPacketProcessor_t<streamSource_t, tradeRingSink_t>;
+    template class basicMarketPacketProcessor_t<mappedSource_t, tradeRingSink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, tradeRingSink_t>;
+    template class basicMarketPacketProcessor_t<memorySource_t, memorySink_t, variableSchemaSet_t>;
 };
\ No newline at end of file
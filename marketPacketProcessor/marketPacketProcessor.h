@@ -1,41 +1,105 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
-#include <fstream>
-#include <iostream>
-#include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
+#include "marketPacketHelpers/marketPacketArena.h"
+#include "marketPacketHelpers/marketPacketClassify.h"
+#include "marketPacketHelpers/marketPacketCompact.h"
 #include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSchema.h"
+#include "marketPacketHelpers/marketPacketSymbolTable.h"
+#include "marketPacketIO/marketPacketColumnar.h"
+#include "marketPacketIO/marketPacketCompressed.h"
+#include "marketPacketIO/marketPacketFollow.h"
+#include "marketPacketIO/marketPacketIO.h"
+#include "marketPacketIndex.h"
+#include "marketPacketQuoteBook.h"
+#include "marketPacketStats.h"
 
 namespace marketPacket
 {
     /**
-     * Processes input stream one packet at a time and translates to output stream
+     * @brief Where an update is, and the ID its symbol was interned as
      */
-    class marketPacketProcessor_t
+    struct decodedUpdate_t
+    {
+        const std::byte *update; // Ptr to the raw update
+        symbolId_t symbolId;     // Interned symbol, see basicMarketPacketProcessor_t::symbolTable()
+    };
+
+    /**
+     * @brief Everything one decodeBatch() call decoded, as parallel arrays. Nothing is copied or formatted
+     *
+     * Update ptrs point into the source, so they stay good as long as it does. The exception is an update that straddled two
+     * reads of a variable size packet, those are only good until the next call into the processor
+     */
+    struct updateBatch_t
+    {
+        std::span<const trade_t *const> trades;     // Trades in the order they were decoded
+        std::span<const symbolId_t> tradeSymbolIds; // Interned symbol of each trade
+        std::span<const quote_t *const> quotes;     // Quotes in the order they were decoded, already applied to the quote book
+        std::span<const symbolId_t> quoteSymbolIds; // Interned symbol of each quote
+        size_t numPackets;                          // Whole packets the batch covers
+    };
+
+    /**
+     * Processes input source one packet at a time and translates to output sink
+     *
+     * Templated on where bytes come from / go to so the hot path never goes through a virtual call.
+     * Explicit instantiations live at the bottom of marketPacketProcessor.cpp, add new sources / sinks / schema sets there
+     *
+     * schemas_t is every update the feed can send. Only defaultSchemaSet_t gets the fixed size classify fast path, any other
+     * set is walked one update at a time through its own schemas. Trades and quotes go where they always do, and updates of
+     * any other schema go to the sink's writeUpdate(), see schemaSink_c. So a venue's own update types are a schema set and
+     * a sink that takes them, nothing in here changes
+     */
+    template <byteSource_c source_t, byteSink_c sink_t, typename schemas_t = defaultSchemaSet_t>
+    class basicMarketPacketProcessor_t
     {
     public:
         /**
-         * @brief Construct a new marketPacketProcessor_t object
+         * @brief Construct a new basicMarketPacketProcessor_t object
          *
-         * @param iStream   Input stream, where we get our data from
-         * @param oStream   Output stream, where to write the interpreted updates
+         * @param iSource   Input source, where we get our data from
+         * @param oSink     Output sink, where to write the interpreted updates
+         * @param readSize  Most body bytes to ask the source for at once. Rounded down to a whole number of updates. Any size works with any source
          */
-        marketPacketProcessor_t(std::ifstream&& iStream, std::ofstream&& oStream)
-            : m_state(state_t::UNINITIALIZED),
+        basicMarketPacketProcessor_t(source_t&& iSource, sink_t&& oSink, size_t readSize = READ_BUFFER_SIZE)
+            : m_readSize(std::max((readSize / UPDATE_SIZE) * UPDATE_SIZE, UPDATE_SIZE)),
+              m_state(state_t::UNINITIALIZED),
               m_failReason(),
               m_numPacketsToProcess(),
               m_bodySize(),
               m_bodyBytesInterpreted(),
               m_numUpdatesPacket(),
               m_numUpdatesRead(),
+              m_fixedPacket(),
+              m_compactPacket(),
               m_packetHeader(),
-              m_readBuffer(),
+              m_arena(),
+              m_carry(),
+              m_carryCapacity(),
+              m_carryUsed(),
+              m_tradeMask(),
               m_tradeLocs(),
-              m_inputStream(std::move(iStream)),
-              m_outputStream(std::move(oStream)){};
+              m_quoteLocs(),
+              m_symbolTable(),
+              m_quoteBook(),
+              m_writeBuffer(),
+              m_writeBufferUsed(),
+              m_stats(),
+              m_batching(false),
+              m_batchTrades(),
+              m_batchTradeSymbolIds(),
+              m_batchQuotes(),
+              m_batchQuoteSymbolIds(),
+              m_batchCarried(),
+              m_source(std::move(iSource)),
+              m_sink(std::move(oSink)){};
 
         /**
          * @brief Sets up the processor for use. Processor won't work unless this is called
@@ -45,11 +109,88 @@ namespace marketPacket
         /**
          * @brief If available, processes the next packet in the input stream.
          *
+         * With a follow source, END_OF_FILE only means nothing new has shown up yet. Calling this again carries on from there
+         *
          * @return If we didn't do any work, why
          */
         const std::optional<failReason_t> &processNextPacket(const std::optional<size_t> &numPacketsToProcess = std::nullopt);
 
+        /**
+         * @brief Decodes up to maxPackets packets and keeps ptrs to their updates, instead of sending anything to the sink
+         *
+         * Only for sources whose ptrs outlive the next read(), so a batch can cover many reads without copying.
+         * Storage is reused from call to call, so batches of a few packets are as cheap per update as big ones
+         *
+         * @return Same as processNextPacket(). batch() has whatever was decoded either way
+         */
+        const std::optional<failReason_t> &decodeBatch(size_t maxPackets)
+            requires stableSource_c<source_t>;
+
+        /**
+         * @brief What the last decodeBatch() decoded
+         */
+        updateBatch_t batch() const { return updateBatch_t{m_batchTrades, m_batchTradeSymbolIds, m_batchQuotes, m_batchQuoteSymbolIds, m_numPacketsProcessed}; }
+
+        /**
+         * @brief Jumps to the start of packetNumber, so the next processNextPacket() picks up from there. Clears any earlier failure
+         *
+         * Packets skipped over don't reach the sink, the symbol table or the quote book
+         *
+         * @param index        Index of the capture the source is reading
+         * @param packetNumber Packet to land on, counting from 0
+         * @return If we couldn't get there, why
+         */
+        const std::optional<failReason_t> &seekToPacket(const packetIndex_t &index, uint64_t packetNumber)
+            requires seekableSource_c<source_t>;
+
+        /**
+         * @brief Jumps to the first indexed run of packets with a quote at or after timeOfDay. Same rules as seekToPacket()
+         *
+         * Lands on a run boundary, so a few packets before the quote may come out first
+         */
+        const std::optional<failReason_t> &seekToTime(const packetIndex_t &index, uint64_t timeOfDay)
+            requires seekableSource_c<source_t>;
+
+        /**
+         * @brief How many packets the last call to processNextPacket() got through
+         */
+        size_t numPacketsProcessed() const { return m_numPacketsProcessed; }
+
+        /**
+         * @brief Where we've been writing to. Mostly useful for in memory sinks
+         */
+        const sink_t &sink() const { return m_sink; }
+        sink_t &sink() { return m_sink; }
+
+        /**
+         * @brief Where we've been reading from. Mostly useful to stop() a follow source
+         */
+        source_t &source() { return m_source; }
+
+        /**
+         * @brief Every symbol we've seen so far, and the IDs they were interned as
+         */
+        const symbolTable_t &symbolTable() const { return m_symbolTable; }
+
+        /**
+         * @brief Per symbol books built from every quote we've processed so far, indexed by symbol ID
+         */
+        const quoteBook_t &quoteBook() const { return m_quoteBook; }
+
+        /**
+         * @brief Timings and counters since we were created, or since resetStats(). All zeroes unless STATS_ENABLED
+         */
+        processorStats_t stats() const { return m_stats.snapshot(); }
+        void resetStats() { m_stats.reset(); }
+
+        /**
+         * @brief Where per packet scratch comes from. numHeapAllocations() stops moving once we've seen the biggest packet
+         */
+        const packetArena_t &arena() const { return m_arena; }
+
     private:
+        using walkSchemas_t = walkSchemaSet_t<schemas_t>; // What packets that can't take the fast path get walked with
+
         /**
          * @brief Possible states for a processor to be in
          */
@@ -69,25 +210,73 @@ namespace marketPacket
          */
         void runStateMachine();
         void uninitialized();       // Tells user processor isn't initialized
-        void checkStreamValidity(); // Makes sure input stream has data and can be read from
+        void checkStreamValidity(); // Makes sure input source has data and can be read from
         void readHeader();          // Reads in a header to get metadata about body and how to read it
-        void readPartBody();        // Buffered reads packet body
-        void writeUpdates();        // Takes buffered reads and interprets them to output stream as readable updates
+        void readPartBody();        // Buffered reads packet body, fixed size packets straight into the trade mask
+        void writeUpdates();        // Takes buffered reads, interprets trades to output sink as readable updates and quotes into the book
 
         /**
-         * @brief Checks conditions to see if we can move on from the current packet
+         * @brief Walks a read of a packet that isn't all UPDATE_SIZE updates, one header at a time
          *
-         * @return True if we're read the number of updates we expect
+         * An update that runs off the end of the read is copied into the carry buffer and finished off by the next one
          */
-        bool doneWithPacket();
+        void decodeVariableUpdates(const std::byte *bodyPtr, size_t numBytes);
+
+        /**
+         * @brief Reads a compact packet's whole body and decodes it back into UPDATE_SIZE updates
+         *
+         * Compact bodies are a fraction of the raw size, so they're read in one go rather than m_readSize at a time
+         */
+        void readCompactBody();
+
+        /**
+         * @brief Notes down where every update in a run of UPDATE_SIZE ones is, going by m_tradeMask, and interns their symbols
+         */
+        void recordClassifiedUpdates(const std::byte *updates, size_t numUpdates);
+
+        /**
+         * @brief Adds as much of the carried update as is at the start of bodyPtr
+         *
+         * @return How many bytes of bodyPtr went to it
+         */
+        size_t finishCarriedUpdate(const std::byte *bodyPtr, size_t numBytes);
+
+        /**
+         * @brief Makes sure the carry buffer has room for numBytes, keeping whatever's in it
+         */
+        void reserveCarry(size_t numBytes);
+
+        /**
+         * @brief Notes down where an already validated update is, and interns its symbol. Fails if it's one more than the header said
+         *
+         * schema_t is whichever schema the update matched, so where it goes is settled at compile time. Anything that isn't
+         * a trade or a quote goes straight to the sink
+         */
+        template <typename schema_t>
+        void recordUpdate(const std::byte *update);
+
+        /**
+         * @brief What walkSchemas_t dispatches updates to
+         */
+        struct recordVisitor_t
+        {
+            basicMarketPacketProcessor_t &processor;
+
+            template <typename schema_t>
+            void operator()(schema_t, const std::byte *update) { processor.recordUpdate<schema_t>(update); }
+        };
+
+        /**
+         * @brief Reads past numPackets whole packets without interpreting anything in them
+         */
+        void skipPackets(uint64_t numPackets);
 
         /**
-         * @brief Checks if ptr points to something we'd consider a valid update
+         * @brief Checks conditions to see if we can move on from the current packet
          *
-         * @param updatePtr Ptr into read buffer on what we assume is the start to an update
-         * @return If the pointer points to a valid header update
+         * @return True if we're read the number of updates we expect
          */
-        bool isUpdateValid(const updateHeader_t * uh);
+        bool doneWithPacket();
 
         /**
          * @brief Certain variables need to be reset per run and/or per packet
@@ -96,11 +285,18 @@ namespace marketPacket
         void resetPerPacketVariables();
 
         /**
-         * @brief Outputs relevant information about trade to output stream
+         * @brief Formats relevant information about trade into the write buffer, flushing it first if it's full
          *
          * @param t trade ptr
          */
-        void appendTradePtrToStream(const trade_t *t);
+        void appendTradePtrToBuffer(const trade_t *t);
+
+        /**
+         * @brief Hands everything in the write buffer to the output sink
+         */
+        void flushWriteBuffer();
+
+        size_t m_readSize; // Most body bytes we ask the source for at once, always a multiple of UPDATE_SIZE
 
         state_t m_state;                          // Current state of processor
         std::optional<failReason_t> m_failReason; // If processNextPacket() returns false, the reason
@@ -113,11 +309,42 @@ namespace marketPacket
         size_t m_numUpdatesPacket;     // Number of updates in this packet body
         size_t m_numUpdatesRead;       // Number of updates we've read so far
 
-        packetHeader_t m_packetHeader;                        // Packet header we read into
-        std::array<std::byte, READ_BUFFER_SIZE> m_readBuffer; // Where we read parts of the packet body into
-        std::vector<const std::byte *> m_tradeLocs;           // Locations, by ptr, of trades we need to interpret
+        bool m_fixedPacket;                       // If the body is exactly m_numUpdatesPacket UPDATE_SIZE updates of the default set, and can take the fast path
+        bool m_compactPacket;                     // If the body is compact encoded, see marketPacketCompact.h
 
-        std::ifstream m_inputStream;  // Input stream
-        std::ofstream m_outputStream; // Output stream
+        packetHeader_t m_packetHeader;            // Packet header we read into
+        packetArena_t m_arena;                    // Everything below that only lives as long as a packet comes out of here
+        std::byte *m_carry;                       // Start of a variable size update that ran off the end of the last read
+        size_t m_carryCapacity;                   // How big m_carry is
+        size_t m_carryUsed;                       // How much of it we have so far
+        std::vector<uint64_t> m_tradeMask;        // Bit per update in the last read, set if it's a trade
+        arenaList_t<decodedUpdate_t> m_tradeLocs; // Locations, by ptr, of trades we need to interpret
+        arenaList_t<decodedUpdate_t> m_quoteLocs; // Locations, by ptr, of quotes we need to apply
+        symbolTable_t m_symbolTable;              // Symbols of every update we've decoded
+        quoteBook_t m_quoteBook;                  // Books built from quotes
+
+        std::array<char, WRITE_BUFFER_SIZE> m_writeBuffer; // Where formatted trades go before we write them out in one block
+        size_t m_writeBufferUsed;                          // How much of the write buffer is filled
+
+        [[no_unique_address]] statsRecorder_t<STATS_ENABLED> m_stats; // Takes no space, and does nothing, unless STATS_ENABLED
+
+        bool m_batching;                                    // If decoded updates go to the batch instead of the sink
+        std::vector<const trade_t *> m_batchTrades;         // See updateBatch_t
+        std::vector<symbolId_t> m_batchTradeSymbolIds;      // See updateBatch_t
+        std::vector<const quote_t *> m_batchQuotes;         // See updateBatch_t
+        std::vector<symbolId_t> m_batchQuoteSymbolIds;      // See updateBatch_t
+        std::vector<std::vector<std::byte>> m_batchCarried; // Copies of batched updates that straddled reads, and of decoded compact packets
+
+        source_t m_source; // Input source
+        sink_t m_sink;     // Output sink
     };
+
+    using marketPacketProcessor_t = basicMarketPacketProcessor_t<streamSource_t, streamSink_t>;
+    using prefetchMarketPacketProcessor_t = basicMarketPacketProcessor_t<prefetchSource_t, streamSink_t>;
+    using mappedMarketPacketProcessor_t = basicMarketPacketProcessor_t<mappedSource_t, streamSink_t>;
+    using uringMarketPacketProcessor_t = basicMarketPacketProcessor_t<uringSource_t, uringSink_t>;
+    using compressedMarketPacketProcessor_t = basicMarketPacketProcessor_t<compressedSource_t, streamSink_t>;
+    using followMarketPacketProcessor_t = basicMarketPacketProcessor_t<followSource_t, streamSink_t>;
+    using batchMarketPacketProcessor_t = basicMarketPacketProcessor_t<mappedSource_t, nullSink_t>;
+    using columnarMarketPacketProcessor_t = basicMarketPacketProcessor_t<streamSource_t, columnarSink_t>;
 };
\ No newline at end of file
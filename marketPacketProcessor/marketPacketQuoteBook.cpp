@@ -0,0 +1,38 @@
+#include "marketPacketQuoteBook.h"
+
+#include <bit>
+
+namespace marketPacket
+{
+    void quoteBook_t::applyQuote(const quote_t *q, symbolId_t symbolId)
+    {
+        assert(q != nullptr);
+
+        // IDs are dense, so this only grows once per new symbol
+        if (symbolId >= m_books.size())
+        {
+            m_books.resize(static_cast<size_t>(symbolId) + 1);
+        }
+
+        std::vector<priceLevel_t> &levels = m_books[symbolId];
+
+        // Grow in powers of two so deep books don't resize on every new level
+        const uint16_t priceLevel = q->priceLevel;
+        if (priceLevel >= levels.size())
+        {
+            levels.resize(std::bit_ceil(static_cast<size_t>(priceLevel) + 1), priceLevel_t{});
+        }
+
+        levels[priceLevel] = priceLevel_t{q->priceLevelSize, q->timeOfDay};
+    }
+
+    std::optional<priceLevel_t> quoteBook_t::level(symbolId_t symbolId, uint16_t priceLevel) const
+    {
+        if (symbolId >= m_books.size() || priceLevel >= m_books[symbolId].size())
+        {
+            return std::nullopt;
+        }
+
+        return m_books[symbolId][priceLevel];
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketHelpers/marketPacketSymbolTable.h"
+
+namespace marketPacket
+{
+    /**
+     * @brief What we know about one price level of one symbol
+     */
+    struct priceLevel_t
+    {
+        uint64_t size;      // Size at this level, 0 if the level is empty
+        uint64_t timeOfDay; // When this level was last touched
+    };
+
+    /**
+     * Per symbol price level books, built up from quotes
+     *
+     * Books are indexed by interned symbol ID and every book is one contiguous array indexed directly by price level,
+     * so applying a quote is two array lookups and a single store. No hashing or node based maps on the hot path
+     */
+    class quoteBook_t
+    {
+    public:
+        quoteBook_t()
+            : m_books(){};
+
+        /**
+         * @brief Updates the price level the quote is for. A priceLevelSize of 0 empties the level
+         *
+         *  NOTE: This function does NOT error check the ptr. Assumes a correctly formed quote is behind that ptr
+         *
+         * @param q        quote ptr
+         * @param symbolId ID the quote's symbol was interned as
+         */
+        void applyQuote(const quote_t *q, symbolId_t symbolId);
+
+        /**
+         * @brief Looks up a single level of a symbol's book
+         *
+         * @param symbolId   Interned symbol to look up
+         * @param priceLevel Level to look up
+         * @return The level, nothing if we've never seen a quote for this symbol at or above this level
+         */
+        std::optional<priceLevel_t> level(symbolId_t symbolId, uint16_t priceLevel) const;
+
+        /**
+         * @brief One past the biggest symbol ID we might have a book for
+         */
+        size_t numBooks() const { return m_books.size(); }
+
+    private:
+        std::vector<std::vector<priceLevel_t>> m_books; // Indexed by symbol ID, then by price level
+    };
+};
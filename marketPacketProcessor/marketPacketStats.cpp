@@ -0,0 +1,83 @@
+#include "marketPacketStats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace marketPacket
+{
+    size_t latencyHistogram_t::bucketIndex(uint64_t value)
+    {
+        if (value < EXACT_BUCKETS)
+        {
+            return value;
+        }
+
+        // Which power of two, then the SUB_BUCKET_BITS right under the leading 1
+        const size_t exponent = std::bit_width(value) - 1;
+        const size_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return EXACT_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + subBucket;
+    }
+
+    uint64_t latencyHistogram_t::bucketUpperBound(size_t bucket)
+    {
+        if (bucket < EXACT_BUCKETS)
+        {
+            return bucket;
+        }
+
+        const size_t exponent = (bucket - EXACT_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+        const uint64_t subBucket = (bucket - EXACT_BUCKETS) % SUB_BUCKETS;
+        const uint64_t width = uint64_t{1} << (exponent - SUB_BUCKET_BITS);
+
+        // The top bucket's bound doesn't fit, it just ends at the top
+        const uint64_t lowerBound = (SUB_BUCKETS + subBucket) << (exponent - SUB_BUCKET_BITS);
+        return (lowerBound > UINT64_MAX - (width - 1)) ? UINT64_MAX : lowerBound + (width - 1);
+    }
+
+    void latencyHistogram_t::record(uint64_t value)
+    {
+        m_buckets[bucketIndex(value)]++;
+        m_count++;
+        m_sum += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void latencyHistogram_t::merge(const latencyHistogram_t &other)
+    {
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            m_buckets[bucket] += other.m_buckets[bucket];
+        }
+
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t latencyHistogram_t::percentile(double percentile) const
+    {
+        if (m_count == 0)
+        {
+            return 0;
+        }
+
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(clamped / 100.0 * m_count)), 1);
+
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            seen += m_buckets[bucket];
+            if (seen >= target)
+            {
+                // Nothing we recorded is past the max, so don't report anything that is
+                return std::clamp(bucketUpperBound(bucket), min(), m_max);
+            }
+        }
+
+        return m_max;
+    }
+};
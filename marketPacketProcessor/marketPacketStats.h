@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace marketPacket
+{
+    /**
+     * Processor instrumentation is compiled in with -DMARKET_PACKET_STATS (bazel build --config=stats), and compiled out
+     * otherwise. It has to be the same for every translation unit, it changes the processor's layout
+     */
+#ifdef MARKET_PACKET_STATS
+    constexpr const bool STATS_ENABLED = true;
+#else
+    constexpr const bool STATS_ENABLED = false;
+#endif
+
+    /**
+     * @brief Cheapest timestamp we can get. TSC cycles on x86, steady_clock nanoseconds anywhere else
+     */
+    inline uint64_t readCycles()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    /**
+     * HDR style histogram of uint64_t values
+     *
+     * Values below 2^(SUB_BUCKET_BITS + 1) get a bucket each, after that every power of two is split into 2^SUB_BUCKET_BITS
+     * buckets, so anything it reports is within 1 / 2^SUB_BUCKET_BITS of the real value. Fixed size, recording never allocates
+     */
+    class latencyHistogram_t
+    {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 4;
+        static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+        static constexpr size_t EXACT_BUCKETS = 2 * SUB_BUCKETS;
+        static constexpr size_t NUM_BUCKETS = EXACT_BUCKETS + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+        latencyHistogram_t()
+            : m_buckets(),
+              m_count(),
+              m_sum(),
+              m_min(UINT64_MAX),
+              m_max(){};
+
+        void record(uint64_t value);
+        void merge(const latencyHistogram_t &other);
+        void reset() { *this = latencyHistogram_t(); }
+
+        uint64_t count() const { return m_count; }
+        uint64_t min() const { return (m_count == 0) ? 0 : m_min; }
+        uint64_t max() const { return m_max; }
+        double mean() const { return (m_count == 0) ? 0.0 : static_cast<double>(m_sum) / m_count; }
+
+        /**
+         * @brief Smallest value that at least percentile % of recorded values are at or below, to within a bucket
+         *
+         * @param percentile 0 to 100
+         * @return 0 if nothing's been recorded
+         */
+        uint64_t percentile(double percentile) const;
+
+        /**
+         * @brief Which bucket value goes in, and the biggest value that bucket holds. Only exposed for testing
+         */
+        static size_t bucketIndex(uint64_t value);
+        static uint64_t bucketUpperBound(size_t bucket);
+
+    private:
+        std::array<uint64_t, NUM_BUCKETS> m_buckets; // Values recorded per bucket
+        uint64_t m_count;                            // Values recorded
+        uint64_t m_sum;                              // Sum of every value recorded, for the mean
+        uint64_t m_min;                              // Smallest value recorded
+        uint64_t m_max;                              // Biggest value recorded
+    };
+
+    /**
+     * @brief Parts of the state machine we time
+     */
+    enum class timedState_e : uint8_t
+    {
+        READ_HEADER = 0,
+        READ_PART_BODY,
+        WRITE_UPDATES,
+
+        NUM_TIMED_STATES
+    };
+
+    constexpr const size_t NUM_TIMED_STATES = static_cast<size_t>(timedState_e::NUM_TIMED_STATES);
+
+    /**
+     * @brief Snapshot of what a processor has done since it was created (or since its stats were reset)
+     */
+    struct processorStats_t
+    {
+        std::array<uint64_t, NUM_TIMED_STATES> stateCycles{}; // readCycles() spent in each timed state, indexed by timedState_e
+        std::array<uint64_t, NUM_TIMED_STATES> stateVisits{}; // Times each timed state ran
+        uint64_t bytes{};                                     // Bytes of whole packets processed, headers included
+        uint64_t packets{};                                   // Whole packets processed
+        uint64_t trades{};                                    // Trades decoded
+        uint64_t quotes{};                                    // Quotes decoded
+        latencyHistogram_t packetCycles;                      // readCycles() from starting a packet's header to finishing its last update
+    };
+
+    /**
+     * @brief What the processor calls to record stats. Everything in the disabled one is empty, and compiles away
+     */
+    template <bool ENABLED>
+    class statsRecorder_t
+    {
+    public:
+        uint64_t startState() { return readCycles(); }
+        void endState(timedState_e state, uint64_t start)
+        {
+            m_stats.stateCycles[static_cast<size_t>(state)] += readCycles() - start;
+            m_stats.stateVisits[static_cast<size_t>(state)]++;
+        }
+
+        void startPacket() { m_packetStart = readCycles(); }
+        void endPacket(size_t packetBytes)
+        {
+            m_stats.packetCycles.record(readCycles() - m_packetStart);
+            m_stats.bytes += packetBytes;
+            m_stats.packets++;
+        }
+
+        void countUpdates(size_t numTrades, size_t numQuotes)
+        {
+            m_stats.trades += numTrades;
+            m_stats.quotes += numQuotes;
+        }
+
+        processorStats_t snapshot() const { return m_stats; }
+        void reset() { m_stats = processorStats_t{}; }
+
+    private:
+        processorStats_t m_stats; // Everything so far
+        uint64_t m_packetStart{}; // When the packet we're on started
+    };
+
+    template <>
+    class statsRecorder_t<false>
+    {
+    public:
+        uint64_t startState() { return 0; }
+        void endState(timedState_e, uint64_t) {}
+        void startPacket() {}
+        void endPacket(size_t) {}
+        void countUpdates(size_t, size_t) {}
+        processorStats_t snapshot() const { return processorStats_t{}; }
+        void reset() {}
+    };
+};
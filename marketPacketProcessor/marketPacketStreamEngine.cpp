@@ -0,0 +1,207 @@
+#include "marketPacketStreamEngine.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace marketPacket
+{
+    template <byteSource_c source_t, byteSink_c sink_t>
+    marketPacketStreamEngine_t<source_t, sink_t>::marketPacketStreamEngine_t(size_t numThreads, size_t packetsPerSlice)
+        : m_numThreads(numThreads == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : numThreads),
+          m_packetsPerSlice(std::max<size_t>(packetsPerSlice, 1)),
+          m_streams(),
+          m_queues(m_numThreads),
+          m_numStreamsRunning(),
+          m_numStreamsQueued(),
+          m_numIdleWorkers(),
+          m_idleMutex(),
+          m_idleCondition()
+    {
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    size_t marketPacketStreamEngine_t<source_t, sink_t>::addStream(source_t &&iSource, sink_t &&oSink)
+    {
+        std::unique_ptr<stream_t> &stream = m_streams.emplace_back(std::make_unique<stream_t>(std::move(iSource), std::move(oSink)));
+        stream->processor.initialize();
+
+        return m_streams.size() - 1;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketStreamEngine_t<source_t, sink_t>::run()
+    {
+        // Deal the streams out round robin, stealing evens things out from there
+        size_t numStreamsRunning = 0;
+        for (std::unique_ptr<stream_t> &stream : m_streams)
+        {
+            if (stream->stats.failReason.has_value())
+            {
+                continue;
+            }
+
+            m_queues[numStreamsRunning % m_numThreads].streams.push_back(stream.get());
+            numStreamsRunning++;
+        }
+
+        if (numStreamsRunning == 0)
+        {
+            return;
+        }
+
+        m_numStreamsRunning.store(numStreamsRunning);
+        m_numStreamsQueued.store(numStreamsRunning);
+
+        // No point in more workers than streams
+        std::vector<std::thread> workers;
+        workers.reserve(std::min(m_numThreads, numStreamsRunning));
+        for (size_t worker = 0; worker < workers.capacity(); worker++)
+        {
+            workers.emplace_back(&marketPacketStreamEngine_t::workerLoop, this, worker);
+        }
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    typename marketPacketStreamEngine_t<source_t, sink_t>::stream_t *marketPacketStreamEngine_t<source_t, sink_t>::takeStream(size_t worker, bool &isStolen)
+    {
+        {
+            workerQueue_t &own = m_queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.streams.empty())
+            {
+                stream_t *stream = own.streams.front();
+                own.streams.pop_front();
+                m_numStreamsQueued.fetch_sub(1);
+                isStolen = false;
+                return stream;
+            }
+        }
+
+        // Start with our neighbour so thieves don't all pile onto worker 0
+        for (size_t i = 1; i < m_queues.size(); i++)
+        {
+            workerQueue_t &victim = m_queues[(worker + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.streams.empty())
+            {
+                stream_t *stream = victim.streams.back();
+                victim.streams.pop_back();
+                m_numStreamsQueued.fetch_sub(1);
+                isStolen = true;
+                return stream;
+            }
+        }
+
+        return nullptr;
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketStreamEngine_t<source_t, sink_t>::workerLoop(size_t worker)
+    {
+        while (m_numStreamsRunning.load(std::memory_order_acquire) > 0)
+        {
+            bool isStolen = false;
+            stream_t *stream = takeStream(worker, isStolen);
+
+            // Everything left is mid slice on other workers
+            if (stream == nullptr)
+            {
+                waitForStream();
+                continue;
+            }
+
+            stream->stats.numSteals += isStolen;
+
+            if (runSlice(*stream))
+            {
+                // Whoever's asleep has nothing left to wait for
+                if (m_numStreamsRunning.fetch_sub(1) == 1)
+                {
+                    wakeIdleWorkers(true);
+                }
+                continue;
+            }
+
+            // Back of the line, behind every other stream this worker has
+            {
+                workerQueue_t &own = m_queues[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                m_numStreamsQueued.fetch_add(1);
+                own.streams.push_back(stream);
+            }
+
+            wakeIdleWorkers(false);
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketStreamEngine_t<source_t, sink_t>::waitForStream()
+    {
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+
+        // Counted before checking, so anyone who queues a stream after we've looked knows to wake us
+        m_numIdleWorkers.fetch_add(1);
+        m_idleCondition.wait(lock, [this]
+                             { return m_numStreamsQueued.load() > 0 || m_numStreamsRunning.load() == 0; });
+        m_numIdleWorkers.fetch_sub(1);
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    void marketPacketStreamEngine_t<source_t, sink_t>::wakeIdleWorkers(bool wakeAll)
+    {
+        // Most of the time nobody's waiting, and then this is just the one load
+        if (m_numIdleWorkers.load() == 0)
+        {
+            return;
+        }
+
+        // Taking the lock means a worker that's checked and is about to wait has got as far as waiting
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+        }
+
+        if (wakeAll)
+        {
+            m_idleCondition.notify_all();
+        }
+        else
+        {
+            m_idleCondition.notify_one();
+        }
+    }
+
+    template <byteSource_c source_t, byteSink_c sink_t>
+    bool marketPacketStreamEngine_t<source_t, sink_t>::runSlice(stream_t &stream)
+    {
+        const clock_t::time_point sliceStart = clock_t::now();
+        if (stream.stats.numSlices == 0)
+        {
+            stream.firstSliceStart = sliceStart;
+        }
+
+        const std::optional<failReason_t> &failReason = stream.processor.processNextPacket(m_packetsPerSlice);
+
+        const clock_t::time_point sliceEnd = clock_t::now();
+        stream.stats.numPackets += stream.processor.numPacketsProcessed();
+        stream.stats.numSlices++;
+        stream.stats.busyTime += sliceEnd - sliceStart;
+        stream.stats.wallTime = sliceEnd - stream.firstSliceStart;
+
+        if (!failReason.has_value())
+        {
+            return false;
+        }
+
+        stream.stats.failReason.emplace(failReason.value());
+        return true;
+    }
+
+    template class marketPacketStreamEngine_t<streamSource_t, streamSink_t>;
+    template class marketPacketStreamEngine_t<mappedSource_t, streamSink_t>;
+    template class marketPacketStreamEngine_t<memorySource_t, memorySink_t>;
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketIO/marketPacketIO.h"
+#include "marketPacketProcessor.h"
+
+namespace marketPacket
+{
+    constexpr const size_t DEFAULT_PACKETS_PER_SLICE = 64;
+
+    /**
+     * @brief How one stream did over an engine run
+     */
+    struct streamStats_t
+    {
+        size_t numPackets;                      // Packets processed
+        size_t numSlices;                       // How many times a worker picked the stream up
+        size_t numSteals;                       // How many of those were a worker stealing it from another worker
+        std::chrono::nanoseconds busyTime;      // Time spent actually processing, summed across slices
+        std::chrono::nanoseconds wallTime;      // From the first slice starting to the last slice finishing
+        std::optional<failReason_t> failReason; // Why the stream stopped. END_OF_FILE if it got through everything
+
+        /**
+         * @brief Throughput while the stream was being worked on
+         */
+        double packetsPerSecond() const
+        {
+            return busyTime.count() == 0 ? 0.0 : numPackets / std::chrono::duration<double>(busyTime).count();
+        }
+    };
+
+    /**
+     * Runs many independent streams, each with its own processor, across a fixed pool of worker threads
+     *
+     * Streams get processed a slice (a handful of packets) at a time. Every worker has its own queue of streams ready to go,
+     * a stream that isn't finished after its slice goes to the back of its worker's queue, and a worker that runs dry steals
+     * the newest stream from the back of someone else's. A hot stream only ever holds a worker for one slice, so it can't starve the rest.
+     * A worker with nothing to steal sleeps until a stream is put back in a queue, or the last one finishes.
+     *
+     * A stream is only ever in one queue or one worker at a time, so its packets are processed (and written) strictly in order.
+     *
+     * Explicit instantiations live at the bottom of marketPacketStreamEngine.cpp, add new sources / sinks there
+     */
+    template <byteSource_c source_t, byteSink_c sink_t>
+    class marketPacketStreamEngine_t
+    {
+    public:
+        using processor_t = basicMarketPacketProcessor_t<source_t, sink_t>;
+
+        /**
+         * @brief Construct a new marketPacketStreamEngine_t object
+         *
+         * @param numThreads      How many workers to run streams on. 0 means one per core
+         * @param packetsPerSlice How many packets a worker processes from a stream before moving on to another
+         */
+        explicit marketPacketStreamEngine_t(size_t numThreads = 0, size_t packetsPerSlice = DEFAULT_PACKETS_PER_SLICE);
+
+        marketPacketStreamEngine_t(const marketPacketStreamEngine_t &) = delete;
+        marketPacketStreamEngine_t &operator=(const marketPacketStreamEngine_t &) = delete;
+
+        /**
+         * @brief Adds a stream to be processed on the next run()
+         *
+         * @return ID of the stream, for stats() and processor()
+         */
+        size_t addStream(source_t &&iSource, sink_t &&oSink);
+
+        /**
+         * @brief Processes every stream until each one hits the end of its input or fails. Blocks until they're all done
+         *
+         * Only streams that haven't already finished get run, so streams can be added and run() called again
+         */
+        void run();
+
+        size_t numStreams() const { return m_streams.size(); }
+
+        /**
+         * @brief How a stream did. Only meaningful once run() has returned
+         */
+        const streamStats_t &stats(size_t streamId) const { return m_streams[streamId]->stats; }
+
+        /**
+         * @brief The processor behind a stream, for its sink, books, etc.
+         */
+        const processor_t &processor(size_t streamId) const { return m_streams[streamId]->processor; }
+        processor_t &processor(size_t streamId) { return m_streams[streamId]->processor; }
+
+    private:
+        using clock_t = std::chrono::steady_clock;
+
+        /**
+         * @brief A processor and its bookkeeping
+         */
+        struct stream_t
+        {
+            stream_t(source_t &&iSource, sink_t &&oSink)
+                : processor(std::move(iSource), std::move(oSink)),
+                  stats(),
+                  firstSliceStart(){};
+
+            processor_t processor;               // Owns the source and sink
+            streamStats_t stats;                 // What we report back
+            clock_t::time_point firstSliceStart; // For wallTime
+        };
+
+        /**
+         * @brief A worker's ready streams. Its own padded line so workers don't fight over neighbours' locks
+         */
+        struct alignas(64) workerQueue_t
+        {
+            std::mutex mutex;               // Guards streams
+            std::deque<stream_t *> streams; // Streams waiting on this worker, oldest first
+        };
+
+        /**
+         * @brief Takes the oldest stream off a worker's own queue, or failing that, steals one from another worker
+         *
+         * @param isStolen Set if the stream came from another worker
+         * @return A stream to work on, nullptr if every queue is empty right now
+         */
+        stream_t *takeStream(size_t worker, bool &isStolen);
+
+        void workerLoop(size_t worker);     // What every worker runs until every stream is done
+        bool runSlice(stream_t &stream);    // Processes one slice of a stream. Returns if the stream is finished
+        void waitForStream();               // Blocks until a stream is queued or every stream is done
+        void wakeIdleWorkers(bool wakeAll); // Wakes one waitForStream() for a newly queued stream, or all of them once we're done
+
+        size_t m_numThreads;      // Size of the pool
+        size_t m_packetsPerSlice; // Packets per slice
+
+        std::vector<std::unique_ptr<stream_t>> m_streams; // Every stream we've been given, indexed by ID
+        std::vector<workerQueue_t> m_queues;              // One per worker
+        std::atomic<size_t> m_numStreamsRunning;          // Streams that haven't finished yet this run
+
+        std::atomic<size_t> m_numStreamsQueued;  // Streams sitting in a queue, rather than mid slice on a worker
+        std::atomic<size_t> m_numIdleWorkers;    // Workers in waitForStream(), so putting a stream back only notifies if someone's waiting
+        std::mutex m_idleMutex;                  // Goes with m_idleCondition
+        std::condition_variable m_idleCondition; // What idle workers sleep on
+    };
+};
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketProcessor/marketPacketParallelProcessor.h"
+#include "marketPacketProcessor/marketPacketProcessor.h"
+
+namespace test
+{
+  // Ideally, all these go into a config file
+  const std::string INPUT_PATH = "./parallel_input_test.dat";
+  const std::string OUTPUT_PATH = "./parallel_output_test.dat";
+
+  using parallelProcessor_t = marketPacket::marketPacketParallelProcessor_t<marketPacket::memorySink_t>;
+
+  /**
+   * @brief Generates packets to INPUT_PATH and returns what a single processor makes of them
+   */
+  std::string generateAndProcessSerially(size_t numPackets)
+  {
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH});
+      mpg.initialize();
+
+      EXPECT_FALSE(mpg.generatePackets(numPackets, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    {
+      marketPacket::marketPacketProcessor_t mpp(std::ifstream{INPUT_PATH}, std::ofstream{OUTPUT_PATH});
+      mpp.initialize();
+
+      EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    std::stringstream ss;
+    ss << std::ifstream(OUTPUT_PATH).rdbuf();
+    return ss.str();
+  }
+
+  std::string toString(const std::vector<std::byte> &bytes)
+  {
+    return std::string(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  }
+
+  TEST(marketPacketParallelProcessorTest, missingFile)
+  {
+    parallelProcessor_t mpp(marketPacket::mappedInputFile_t{"./this_file_does_not_exist.dat"}, marketPacket::memorySink_t{}, 2);
+    EXPECT_EQ(mpp.processAll().value(), marketPacket::INPUT_STREAM_CLOSED);
+  }
+
+  TEST(marketPacketParallelProcessorTest, emptyFile)
+  {
+    std::ofstream{INPUT_PATH};
+
+    parallelProcessor_t mpp(marketPacket::mappedInputFile_t{INPUT_PATH}, marketPacket::memorySink_t{}, 2);
+    EXPECT_EQ(mpp.processAll().value(), marketPacket::END_OF_FILE);
+    EXPECT_TRUE(mpp.sink().bytes().empty());
+  }
+
+  /**
+   * Small chunks force plenty of chunks per worker, so any ordering mistake shows up
+   */
+  TEST(marketPacketParallelProcessorTest, matchesSerial)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 2000;
+    const std::string expected = generateAndProcessSerially(NUM_PACKETS_TO_GENERATE);
+
+    for (size_t numThreads : {1, 2, 4, 7})
+    {
+      parallelProcessor_t mpp(marketPacket::mappedInputFile_t{INPUT_PATH}, marketPacket::memorySink_t{}, numThreads, 64 * 1024);
+      EXPECT_EQ(mpp.processAll().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(expected, toString(mpp.sink().bytes())) << numThreads << " threads";
+    }
+  }
+
+  TEST(marketPacketParallelProcessorTest, truncatedTail)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 200;
+    const std::string expected = generateAndProcessSerially(NUM_PACKETS_TO_GENERATE);
+
+    // Half a packet header at the end, everything before it should still come out
+    marketPacket::packetHeader_t ph{sizeof(marketPacket::packetHeader_t) + sizeof(marketPacket::trade_t), 1};
+    ASSERT_TRUE(std::ofstream(INPUT_PATH, std::ofstream::app).write(reinterpret_cast<char *>(&ph), sizeof(ph) - 1));
+
+    parallelProcessor_t mpp(marketPacket::mappedInputFile_t{INPUT_PATH}, marketPacket::memorySink_t{}, 4, 16 * 1024);
+    EXPECT_EQ(mpp.processAll().value(), marketPacket::PACKET_HEADER_READ_FAILED);
+    EXPECT_EQ(expected, toString(mpp.sink().bytes()));
+  }
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketProcessor/marketPacketPipelinedProcessor.h"
+#include "marketPacketProcessor/marketPacketProcessor.h"
+
+namespace test
+{
+  using memoryGenerator_t = marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t>;
+  using memoryProcessor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+  using pipelinedProcessor_t = marketPacket::marketPacketPipelinedProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+
+  std::vector<std::byte> generateCapture(size_t numPackets)
+  {
+    memoryGenerator_t mpg(marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.poolSize = 4096, .seed = 5});
+    mpg.initialize();
+
+    EXPECT_FALSE(mpg.generatePackets(numPackets, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    return mpg.sink().bytes();
+  }
+
+  /**
+   * Tiny rings make the decoder wait on the formatter constantly, big ones barely ever
+   */
+  TEST(marketPacketPipelinedProcessorTest, matchesSerial)
+  {
+    const std::vector<std::byte> capture = generateCapture(1000);
+
+    memoryProcessor_t serial(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{});
+    serial.initialize();
+    EXPECT_EQ(serial.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    for (size_t ringCapacity : {2, 64, 16384})
+    {
+      pipelinedProcessor_t mpp(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{}, ringCapacity);
+      mpp.initialize();
+
+      EXPECT_EQ(mpp.processAll().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(mpp.sink().bytes(), serial.sink().bytes()) << ringCapacity;
+      EXPECT_EQ(mpp.symbolTable().size(), serial.symbolTable().size());
+    }
+  }
+
+  TEST(marketPacketPipelinedProcessorTest, truncatedTail)
+  {
+    std::vector<std::byte> capture = generateCapture(100);
+    capture.resize(capture.size() - 1);
+
+    memoryProcessor_t serial(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{});
+    serial.initialize();
+    const marketPacket::failReason_t expectedFailReason = serial.processNextPacket().value();
+    EXPECT_NE(expectedFailReason, marketPacket::END_OF_FILE);
+
+    // Everything decoded before the bad packet still gets formatted
+    pipelinedProcessor_t mpp(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{}, 64);
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processAll().value(), expectedFailReason);
+    EXPECT_EQ(mpp.sink().bytes(), serial.sink().bytes());
+  }
+
+  TEST(marketPacketPipelinedProcessorTest, writeFailureStopsDecoder)
+  {
+    const std::vector<std::byte> capture = generateCapture(1000);
+
+    // Never opened, every write fails
+    marketPacket::marketPacketPipelinedProcessor_t<marketPacket::memorySource_t, marketPacket::streamSink_t> mpp(
+        marketPacket::memorySource_t{capture}, marketPacket::streamSink_t{std::ofstream{}}, 16);
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processAll().value(), marketPacket::TRADE_WRITE_FAILED);
+  }
+}
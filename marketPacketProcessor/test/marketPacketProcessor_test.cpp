@@ -1,15 +1,51 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <new>
+#include <sstream>
+#include <thread>
 
 #include "marketPacketGenerator/marketPacketGenerator.h"
 #include "marketPacketHelpers/marketPacketHelpers.h"
+#include "marketPacketIO/marketPacketMappedFile.h"
 #include "marketPacketProcessor/marketPacketProcessor.h"
 
+namespace
+{
+  // Every global allocation in this binary goes through the operator new below, so a test can check a stretch of code made none
+  std::atomic<size_t> numGlobalAllocations{0};
+}
+
+void *operator new(size_t size)
+{
+  numGlobalAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(std::max<size_t>(size, 1)))
+  {
+    return ptr;
+  }
+
+  throw std::bad_alloc();
+}
+
+// Kept out of line, otherwise GCC sees free() on something operator new returned and warns about it
+__attribute__((noinline)) void operator delete(void *ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
 namespace test
 {
   // Ideally, all these go into a config file
   const std::string INPUT_PATH = "./input_test.dat";
   const std::string OUTPUT_PATH = "./output_test.dat";
+  const std::string MAPPED_OUTPUT_PATH = "./mapped_output_test.dat";
+  const std::string URING_INPUT_PATH = "./uring_input_test.dat";
+  const std::string URING_OUTPUT_PATH = "./uring_output_test.dat";
+  const std::string COLUMNAR_OUTPUT_PATH = "./columnar_output_test.dat";
+  const std::string INDEX_PATH = "./index_test.dat";
+  const std::string FOLLOW_INPUT_PATH = "./follow_input_test.dat";
+  const std::string COMPRESSED_INPUT_PATH = "./compressed_input_test.dat";
+  const std::string COMPACT_INPUT_PATH = "./compact_input_test.dat";
 
   /**
    * @brief Create a Default Processor
@@ -19,6 +55,57 @@ namespace test
     return marketPacket::marketPacketProcessor_t(std::ifstream{INPUT_PATH}, std::ofstream{OUTPUT_PATH});
   }
 
+  /**
+   * @brief Create a Processor that reads through a memory mapping
+   */
+  marketPacket::mappedMarketPacketProcessor_t createMappedProcessor()
+  {
+    return marketPacket::mappedMarketPacketProcessor_t(marketPacket::mappedInputFile_t{INPUT_PATH}, std::ofstream{MAPPED_OUTPUT_PATH});
+  }
+
+  /**
+   * @brief Copies a capture of UPDATE_SIZE updates, padding every update out to a random length between UPDATE_SIZE and 4 * UPDATE_SIZE
+   */
+  std::vector<std::byte> padUpdates(const std::vector<std::byte> &fixed, uint64_t seed)
+  {
+    std::vector<std::byte> variable;
+    marketPacket::xoshiro256ss_t rng(seed);
+    for (size_t offset = 0; offset < fixed.size();)
+    {
+      marketPacket::packetHeader_t ph;
+      std::memcpy(&ph, fixed.data() + offset, sizeof(ph));
+      const size_t headerPos = variable.size();
+      variable.resize(variable.size() + sizeof(ph));
+
+      for (size_t update = 0; update < ph.numMarketUpdates; update++)
+      {
+        const std::byte *src = fixed.data() + offset + sizeof(ph) + update * marketPacket::UPDATE_SIZE;
+        const uint16_t length = static_cast<uint16_t>(marketPacket::UPDATE_SIZE + rng.below(3 * marketPacket::UPDATE_SIZE));
+
+        const size_t updatePos = variable.size();
+        variable.insert(variable.end(), src, src + marketPacket::UPDATE_SIZE);
+        variable.resize(updatePos + length, std::byte{0xAB});
+        std::memcpy(variable.data() + updatePos, &length, sizeof(length));
+      }
+
+      marketPacket::packetHeader_t variableHeader{static_cast<uint16_t>(variable.size() - headerPos), ph.numMarketUpdates};
+      std::memcpy(variable.data() + headerPos, &variableHeader, sizeof(variableHeader));
+      offset += ph.packetLength;
+    }
+
+    return variable;
+  }
+
+  /**
+   * @brief Reads a whole file into a string
+   */
+  std::string readFile(const std::string &path)
+  {
+    std::stringstream ss;
+    ss << std::ifstream(path).rdbuf();
+    return ss.str();
+  }
+
   TEST(marketPacketProcessorTest, noInit)
   {
     marketPacket::marketPacketProcessor_t mpp = createDefaultProcessor();
@@ -148,7 +235,11 @@ namespace test
     marketPacket::packetHeader_t ph{sizeof(marketPacket::packetHeader_t) + sizeof(marketPacket::quote_t), 1};
     marketPacket::quote_t quote{
         .updateHeader = {sizeof(marketPacket::quote_t), marketPacket::updateType_e::QUOTE},
+        .priceLevel = 3,
+        .priceLevelSize = 100,
+        .timeOfDay = 12345,
     };
+    std::memcpy(quote.symbol, "ABCDE", marketPacket::SYMBOL_LENGTH);
 
     {
       std::shared_ptr<std::ofstream> genStream = std::make_shared<std::ofstream>(INPUT_PATH);
@@ -162,13 +253,22 @@ namespace test
 
       ASSERT_FALSE(mpp.processNextPacket(1).has_value());
       ASSERT_EQ(mpp.processNextPacket(1).value(), marketPacket::END_OF_FILE);
+
+      // Quotes go into the book instead
+      std::optional<marketPacket::symbolId_t> symbolId = mpp.symbolTable().find("ABCDE");
+      ASSERT_TRUE(symbolId.has_value());
+
+      std::optional<marketPacket::priceLevel_t> level = mpp.quoteBook().level(symbolId.value(), 3);
+      ASSERT_TRUE(level.has_value());
+      EXPECT_EQ(level->size, 100);
+      EXPECT_EQ(level->timeOfDay, 12345);
     }
 
     {
       char tradeLine[1];
       std::shared_ptr<std::ifstream> readStream = std::make_shared<std::ifstream>(OUTPUT_PATH);
 
-      // The file should be empty because we don't process quotes
+      // The file should be empty because quotes don't get written out
       EXPECT_FALSE(readStream->read(tradeLine, 1));
     }
   }
@@ -250,4 +350,866 @@ namespace test
       ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
     }
   }
-}
\ No newline at end of file
+
+  TEST(marketPacketProcessorTest, mappedMissingFile)
+  {
+    std::remove(INPUT_PATH.c_str());
+
+    marketPacket::mappedMarketPacketProcessor_t mpp = createMappedProcessor();
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::INPUT_STREAM_CLOSED);
+  }
+
+  TEST(marketPacketProcessorTest, mappedTruncatedPacket)
+  {
+    marketPacket::packetHeader_t ph{sizeof(marketPacket::packetHeader_t) + sizeof(marketPacket::trade_t), 1};
+    marketPacket::trade_t trade{
+        .updateHeader = {marketPacket::UPDATE_SIZE, marketPacket::updateType_e::TRADE}};
+
+    {
+      std::ofstream genStream(INPUT_PATH);
+      ASSERT_TRUE(genStream.write(reinterpret_cast<char *>(&ph), sizeof(ph)));
+      ASSERT_TRUE(genStream.write(reinterpret_cast<char *>(&trade), sizeof(trade) / 2));
+    }
+
+    marketPacket::mappedMarketPacketProcessor_t mpp = createMappedProcessor();
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::PACKET_READ_FAILED);
+  }
+
+  /**
+   * Reading through the mapping should produce exactly what reading through the stream does
+   */
+  TEST(marketPacketProcessorTest, mappedMatchesStream)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 1000;
+
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH});
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    {
+      marketPacket::marketPacketProcessor_t mpp = createDefaultProcessor();
+      mpp.initialize();
+
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    {
+      marketPacket::mappedMarketPacketProcessor_t mpp = createMappedProcessor();
+      mpp.initialize();
+
+      ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    std::string streamOutput = readFile(OUTPUT_PATH);
+    EXPECT_FALSE(streamOutput.empty());
+    EXPECT_EQ(streamOutput, readFile(MAPPED_OUTPUT_PATH));
+  }
+
+  /**
+   * Nothing about the state machines should care where bytes come from or go to
+   */
+  TEST(marketPacketProcessorTest, memorySourceMatchesStream)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 1000;
+
+    marketPacket::memorySink_t generated;
+    {
+      marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}};
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+      ASSERT_TRUE(std::ofstream(INPUT_PATH).write(reinterpret_cast<const char *>(mpg.sink().bytes().data()), mpg.sink().bytes().size()));
+      generated = mpg.sink();
+    }
+
+    {
+      marketPacket::marketPacketProcessor_t mpp = createDefaultProcessor();
+      mpp.initialize();
+
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::memorySource_t{generated.bytes()}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+
+    ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    const std::vector<std::byte> &processed = mpp.sink().bytes();
+    EXPECT_EQ(readFile(OUTPUT_PATH), std::string(reinterpret_cast<const char *>(processed.data()), processed.size()));
+  }
+
+  TEST(marketPacketProcessorTest, uringMissingFile)
+  {
+    std::remove(URING_INPUT_PATH.c_str());
+
+    marketPacket::uringMarketPacketProcessor_t mpp(marketPacket::uringSource_t{URING_INPUT_PATH}, marketPacket::uringSink_t{URING_OUTPUT_PATH});
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::INPUT_STREAM_CLOSED);
+  }
+
+  /**
+   * Runs both backends, with chunks small enough that packets straddle them all the time
+   * Whichever one this machine actually supports, the bytes in and out should match the plain streams
+   */
+  TEST(marketPacketProcessorTest, uringMatchesStream)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 1000;
+    constexpr const uint64_t SEED = 13;
+
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH}, marketPacket::generatorConfig_t{.seed = SEED});
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    {
+      marketPacket::marketPacketProcessor_t mpp = createDefaultProcessor();
+      mpp.initialize();
+
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    const std::string streamInput = readFile(INPUT_PATH);
+    const std::string streamOutput = readFile(OUTPUT_PATH);
+
+    for (marketPacket::ioBackend_e backend : {marketPacket::ioBackend_e::BLOCKING, marketPacket::ioBackend_e::URING})
+    {
+      const marketPacket::ioConfig_t config{.backend = backend, .chunkSize = marketPacket::READ_BUFFER_SIZE, .queueDepth = 3};
+
+      {
+        marketPacket::uringMarketPacketGenerator_t mpg(marketPacket::uringSink_t{URING_INPUT_PATH, config}, marketPacket::generatorConfig_t{.seed = SEED});
+        mpg.initialize();
+
+        ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+        ASSERT_TRUE(mpg.sink().flush());
+      }
+
+      {
+        marketPacket::uringMarketPacketProcessor_t mpp(marketPacket::uringSource_t{URING_INPUT_PATH, config}, marketPacket::uringSink_t{URING_OUTPUT_PATH, config});
+        mpp.initialize();
+
+        ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+        ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+        ASSERT_TRUE(mpp.sink().flush());
+      }
+
+      EXPECT_EQ(streamInput, readFile(URING_INPUT_PATH));
+      EXPECT_EQ(streamOutput, readFile(URING_OUTPUT_PATH));
+    }
+  }
+
+  /**
+   * Read sizes that don't line up with the source's buffers / chunks, or with packet bodies
+   */
+  TEST(marketPacketProcessorTest, prefetchMatchesStream)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 1000;
+
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH});
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    {
+      marketPacket::marketPacketProcessor_t mpp = createDefaultProcessor();
+      mpp.initialize();
+
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    }
+
+    const std::string streamOutput = readFile(OUTPUT_PATH);
+
+    for (size_t readSize : {size_t{100}, marketPacket::READ_BUFFER_SIZE, size_t{200000}})
+    {
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::prefetchSource_t, marketPacket::memorySink_t> mpp(
+          marketPacket::prefetchSource_t{std::ifstream{INPUT_PATH}, marketPacket::readConfig_t{.bufferSize = 65536, .numBuffers = 3}},
+          marketPacket::memorySink_t{},
+          readSize);
+      mpp.initialize();
+
+      ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+      const std::vector<std::byte> &processed = mpp.sink().bytes();
+      EXPECT_EQ(streamOutput, std::string(reinterpret_cast<const char *>(processed.data()), processed.size())) << readSize;
+
+      // Same again through the smallest chunks uring will take, so the bigger reads span several of them
+      for (marketPacket::ioBackend_e backend : {marketPacket::ioBackend_e::BLOCKING, marketPacket::ioBackend_e::URING})
+      {
+        const marketPacket::ioConfig_t config{.backend = backend, .chunkSize = marketPacket::READ_BUFFER_SIZE, .queueDepth = 3};
+        marketPacket::basicMarketPacketProcessor_t<marketPacket::uringSource_t, marketPacket::memorySink_t> uringRun(
+            marketPacket::uringSource_t{INPUT_PATH, config}, marketPacket::memorySink_t{}, readSize);
+        uringRun.initialize();
+
+        ASSERT_FALSE(uringRun.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+        ASSERT_EQ(uringRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+        const std::vector<std::byte> &uringProcessed = uringRun.sink().bytes();
+        EXPECT_EQ(streamOutput, std::string(reinterpret_cast<const char *>(uringProcessed.data()), uringProcessed.size())) << readSize;
+      }
+    }
+  }
+
+  /**
+   * Generating straight to a compressed capture and reading it back should be the same as the plain capture, for every codec
+   */
+  TEST(marketPacketProcessorTest, compressedMatchesStream)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 1000;
+    const marketPacket::generatorConfig_t config{.poolSize = 4096, .numSymbols = 64, .seed = 7};
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> plain(marketPacket::memorySink_t{}, config);
+    plain.initialize();
+    ASSERT_FALSE(plain.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> plainRun{
+        marketPacket::memorySource_t{plain.sink().bytes()}, marketPacket::memorySink_t{}};
+    plainRun.initialize();
+    ASSERT_EQ(plainRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    for (marketPacket::compressionCodec_e codec : {marketPacket::compressionCodec_e::LZ4, marketPacket::compressionCodec_e::ZSTD})
+    {
+      {
+        marketPacket::compressedMarketPacketGenerator_t mpg(
+            marketPacket::compressedSink_t{std::ofstream{COMPRESSED_INPUT_PATH}, marketPacket::compressionConfig_t{.codec = codec, .blockSize = 65536}}, config);
+        mpg.initialize();
+
+        ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+      }
+
+      EXPECT_LT(readFile(COMPRESSED_INPUT_PATH).size(), plain.sink().bytes().size()) << static_cast<int>(codec);
+
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::compressedSource_t, marketPacket::memorySink_t> mpp(
+          marketPacket::compressedSource_t{std::ifstream{COMPRESSED_INPUT_PATH}}, marketPacket::memorySink_t{});
+      mpp.initialize();
+
+      ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(mpp.sink().bytes(), plainRun.sink().bytes()) << static_cast<int>(codec);
+    }
+  }
+
+  /**
+   * Rebuilding the text output from the columns should give back exactly what the text sink wrote
+   */
+  TEST(marketPacketProcessorTest, columnarMatchesText)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 200;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.poolSize = 4096, .seed = 3}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    const std::vector<std::byte> &generated = mpg.sink().bytes();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> textProcessor{
+        marketPacket::memorySource_t{generated}, marketPacket::memorySink_t{}};
+    textProcessor.initialize();
+    ASSERT_EQ(textProcessor.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    const std::vector<std::byte> &textBytes = textProcessor.sink().bytes();
+    const std::string expectedText(reinterpret_cast<const char *>(textBytes.data()), textBytes.size());
+
+    size_t numQuotes = 0;
+    {
+      // Small blocks, so we get plenty of full ones and a partial one at the end
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::columnarSink_t> mpp{
+          marketPacket::memorySource_t{generated}, marketPacket::columnarSink_t{std::ofstream{COLUMNAR_OUTPUT_PATH}, 1000}};
+      mpp.initialize();
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+      for (marketPacket::symbolId_t symbolId = 0; symbolId < mpp.symbolTable().size(); symbolId++)
+      {
+        for (uint16_t priceLevel = 0; priceLevel < marketPacket::DEFAULT_MAX_PRICE_LEVEL; priceLevel++)
+        {
+          numQuotes += mpp.quoteBook().level(symbolId, priceLevel).has_value();
+        }
+      }
+    }
+
+    marketPacket::columnarFile_t columnar(COLUMNAR_OUTPUT_PATH);
+    ASSERT_TRUE(columnar.isValid());
+    EXPECT_EQ(columnar.rowsPerBlock(), 1000);
+
+    std::string rebuiltText;
+    size_t numQuoteRows = 0;
+    for (const marketPacket::columnarFile_t::block_t &block : columnar.blocks())
+    {
+      if (block.table == marketPacket::columnTable_e::QUOTES)
+      {
+        for (marketPacket::symbolId_t symbolId : marketPacket::columnarFile_t::column<marketPacket::symbolId_t>(block, marketPacket::QUOTE_SYMBOL_ID))
+        {
+          EXPECT_FALSE(columnar.symbol(symbolId).empty());
+        }
+
+        numQuoteRows += block.numRows;
+        continue;
+      }
+
+      if (block.table != marketPacket::columnTable_e::TRADES)
+      {
+        continue;
+      }
+
+      std::span<const marketPacket::symbolId_t> symbolIds = marketPacket::columnarFile_t::column<marketPacket::symbolId_t>(block, marketPacket::TRADE_SYMBOL_ID);
+      std::span<const uint16_t> sizes = marketPacket::columnarFile_t::column<uint16_t>(block, marketPacket::TRADE_SIZE);
+      std::span<const uint64_t> prices = marketPacket::columnarFile_t::column<uint64_t>(block, marketPacket::TRADE_PRICE);
+
+      for (size_t row = 0; row < block.numRows; row++)
+      {
+        marketPacket::trade_t trade{.tradeSize = sizes[row], .tradePrice = prices[row]};
+        std::memcpy(trade.symbol, columnar.symbol(symbolIds[row]).data(), marketPacket::SYMBOL_LENGTH);
+
+        char line[marketPacket::MAX_TRADE_STRING_LENGTH];
+        rebuiltText.append(line, marketPacket::formatTrade(line, &trade));
+      }
+    }
+
+    EXPECT_FALSE(expectedText.empty());
+    EXPECT_EQ(rebuiltText, expectedText);
+
+    // Every quote gets a row, the book only keeps the latest per level
+    EXPECT_GE(numQuoteRows, numQuotes);
+    EXPECT_GT(numQuotes, 0);
+  }
+
+  TEST(marketPacketProcessorTest, indexRoundTrip)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 100;
+    constexpr const size_t PACKETS_PER_ENTRY = 16;
+
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH});
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    // Half a header on the end shouldn't get indexed
+    std::ofstream(INPUT_PATH, std::ios::app).write("\x01", 1);
+
+    std::optional<marketPacket::packetIndex_t> built = marketPacket::packetIndex_t::build(INPUT_PATH, PACKETS_PER_ENTRY);
+    ASSERT_TRUE(built.has_value());
+    EXPECT_EQ(built->numPackets(), NUM_PACKETS_TO_GENERATE);
+    EXPECT_EQ(built->captureSize(), readFile(INPUT_PATH).size() - 1);
+    ASSERT_EQ(built->entries().size(), (NUM_PACKETS_TO_GENERATE + PACKETS_PER_ENTRY - 1) / PACKETS_PER_ENTRY);
+    EXPECT_EQ(built->entries()[0].byteOffset, 0);
+
+    ASSERT_TRUE(built->save(INDEX_PATH));
+    std::optional<marketPacket::packetIndex_t> loaded = marketPacket::packetIndex_t::load(INDEX_PATH);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->packetsPerEntry(), PACKETS_PER_ENTRY);
+    EXPECT_EQ(loaded->numPackets(), built->numPackets());
+    EXPECT_EQ(loaded->captureSize(), built->captureSize());
+    ASSERT_EQ(loaded->entries().size(), built->entries().size());
+    for (size_t entry = 0; entry < built->entries().size(); entry++)
+    {
+      EXPECT_EQ(std::memcmp(&loaded->entries()[entry], &built->entries()[entry], sizeof(marketPacket::indexEntry_t)), 0);
+    }
+
+    EXPECT_EQ(loaded->findPacket(PACKETS_PER_ENTRY + 3)->packetNumber, PACKETS_PER_ENTRY);
+    EXPECT_FALSE(loaded->findPacket(NUM_PACKETS_TO_GENERATE).has_value());
+
+    // Not an index at all
+    EXPECT_FALSE(marketPacket::packetIndex_t::load(INPUT_PATH).has_value());
+
+    // Entries missing off the end
+    std::string savedIndex = readFile(INDEX_PATH);
+    ASSERT_TRUE(std::ofstream(INDEX_PATH, std::ios::trunc | std::ios::binary).write(savedIndex.data(), savedIndex.size() - 1));
+    EXPECT_FALSE(marketPacket::packetIndex_t::load(INDEX_PATH).has_value());
+
+    // A header that agrees with itself but claims far more entries than the file has. numPackets and numEntries sit
+    // 16 and 32 bytes into it
+    const uint64_t hugeNumEntries = uint64_t{1} << 40;
+    const uint64_t hugeNumPackets = hugeNumEntries * PACKETS_PER_ENTRY;
+    std::memcpy(savedIndex.data() + 16, &hugeNumPackets, sizeof(hugeNumPackets));
+    std::memcpy(savedIndex.data() + 32, &hugeNumEntries, sizeof(hugeNumEntries));
+    ASSERT_TRUE(std::ofstream(INDEX_PATH, std::ios::trunc | std::ios::binary).write(savedIndex.data(), savedIndex.size()));
+    EXPECT_FALSE(marketPacket::packetIndex_t::load(INDEX_PATH).has_value());
+
+    // More packets per entry than the file's header can hold come back as the most it can
+    std::optional<marketPacket::packetIndex_t> sparse = marketPacket::packetIndex_t::build(INPUT_PATH, uint64_t{1} << 40);
+    ASSERT_TRUE(sparse.has_value());
+    EXPECT_EQ(sparse->packetsPerEntry(), std::numeric_limits<uint32_t>::max());
+    ASSERT_TRUE(sparse->save(INDEX_PATH));
+    EXPECT_EQ(marketPacket::packetIndex_t::load(INDEX_PATH)->packetsPerEntry(), sparse->packetsPerEntry());
+  }
+
+  /**
+   * Landing on a packet through the index should give exactly what replaying up to it would have
+   */
+  TEST(marketPacketProcessorTest, seekMatchesReplay)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 300;
+    constexpr const size_t PACKETS_PER_ENTRY = 32;
+
+    {
+      marketPacket::marketPacketGenerator_t mpg(std::ofstream{INPUT_PATH}, marketPacket::generatorConfig_t{.poolSize = 4096, .seed = 5});
+      mpg.initialize();
+
+      ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    }
+
+    std::optional<marketPacket::packetIndex_t> index = marketPacket::packetIndex_t::build(INPUT_PATH, PACKETS_PER_ENTRY);
+    ASSERT_TRUE(index.has_value());
+
+    // Output of every packet from packetNumber on, by replaying everything
+    auto replayFrom = [](uint64_t packetNumber)
+    {
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::streamSource_t, marketPacket::memorySink_t> mpp{
+          marketPacket::streamSource_t{std::ifstream{INPUT_PATH}}, marketPacket::memorySink_t{}};
+      mpp.initialize();
+      mpp.processNextPacket(packetNumber);
+      const size_t skipped = mpp.sink().bytes().size();
+      mpp.processNextPacket();
+
+      const std::vector<std::byte> &bytes = mpp.sink().bytes();
+      return std::string(reinterpret_cast<const char *>(bytes.data()) + skipped, bytes.size() - skipped);
+    };
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::streamSource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::streamSource_t{std::ifstream{INPUT_PATH}}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+
+    // Run off the end first, seeking should clear that
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    for (uint64_t packetNumber : {uint64_t{0}, uint64_t{PACKETS_PER_ENTRY}, uint64_t{PACKETS_PER_ENTRY * 3 + 7}, uint64_t{NUM_PACKETS_TO_GENERATE - 1}})
+    {
+      ASSERT_FALSE(mpp.seekToPacket(*index, packetNumber).has_value()) << packetNumber;
+
+      const size_t before = mpp.sink().bytes().size();
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(mpp.numPacketsProcessed(), NUM_PACKETS_TO_GENERATE - packetNumber);
+
+      const std::vector<std::byte> &bytes = mpp.sink().bytes();
+      EXPECT_EQ(std::string(reinterpret_cast<const char *>(bytes.data()) + before, bytes.size() - before), replayFrom(packetNumber)) << packetNumber;
+    }
+
+    EXPECT_EQ(mpp.seekToPacket(*index, NUM_PACKETS_TO_GENERATE).value(), marketPacket::SEEK_TARGET_NOT_INDEXED);
+
+    // Late enough that it has to skip some runs
+    const marketPacket::indexEntry_t &last = index->entries().back();
+    ASSERT_TRUE(last.hasQuotes());
+    ASSERT_FALSE(mpp.seekToTime(*index, last.maxTimeOfDay).has_value());
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(mpp.numPacketsProcessed(), NUM_PACKETS_TO_GENERATE - index->findTime(last.maxTimeOfDay)->packetNumber);
+
+    EXPECT_EQ(mpp.seekToTime(*index, marketPacket::indexEntry_t::NO_TIME_OF_DAY - 1).value(), marketPacket::SEEK_TARGET_NOT_INDEXED);
+  }
+
+  /**
+   * Processes a capture while it's being written, with packets split across writes
+   */
+  TEST(marketPacketProcessorTest, followMatchesFullRun)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 200;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    const std::vector<std::byte> &generated = mpg.sink().bytes();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> fullRun{
+        marketPacket::memorySource_t{generated}, marketPacket::memorySink_t{}};
+    fullRun.initialize();
+    ASSERT_EQ(fullRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    std::ofstream(FOLLOW_INPUT_PATH, std::ios::trunc);
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::followSource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::followSource_t{FOLLOW_INPUT_PATH, marketPacket::followConfig_t{.idleTimeout = std::chrono::milliseconds(10)}}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+
+    // Nothing written yet isn't fatal
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(mpp.numPacketsProcessed(), 0);
+
+    std::thread writer([&generated]()
+                       {
+                         std::ofstream oStream(FOLLOW_INPUT_PATH, std::ios::app | std::ios::binary);
+                         for (size_t offset = 0; offset < generated.size(); offset += 777)
+                         {
+                           oStream.write(reinterpret_cast<const char *>(generated.data() + offset), std::min<size_t>(777, generated.size() - offset));
+                           oStream.flush();
+                           std::this_thread::sleep_for(std::chrono::microseconds(100));
+                         } });
+
+    size_t numPacketsProcessed = 0;
+    while (numPacketsProcessed < NUM_PACKETS_TO_GENERATE)
+    {
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+      numPacketsProcessed += mpp.numPacketsProcessed();
+    }
+
+    writer.join();
+    EXPECT_EQ(numPacketsProcessed, NUM_PACKETS_TO_GENERATE);
+
+    const std::vector<std::byte> &expected = fullRun.sink().bytes();
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(mpp.sink().bytes(), expected);
+
+    // Once stopped, it just gives up like any other source
+    mpp.source().stop();
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(mpp.numPacketsProcessed(), 0);
+  }
+
+  TEST(marketPacketProcessorTest, followStopMidPacket)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 3;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    const std::vector<std::byte> &generated = mpg.sink().bytes();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> fullRun{
+        marketPacket::memorySource_t{generated}, marketPacket::memorySink_t{}};
+    fullRun.initialize();
+    ASSERT_EQ(fullRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    marketPacket::packetHeader_t firstHeader;
+    std::memcpy(&firstHeader, generated.data(), marketPacket::PACKET_HEADER_SIZE);
+    const size_t halfPacket = firstHeader.packetLength / 2;
+    ASSERT_GT(halfPacket, marketPacket::PACKET_HEADER_SIZE);
+
+    std::ofstream oStream(FOLLOW_INPUT_PATH, std::ios::trunc | std::ios::binary);
+    oStream.write(reinterpret_cast<const char *>(generated.data()), halfPacket);
+    oStream.flush();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::followSource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::followSource_t{FOLLOW_INPUT_PATH, marketPacket::followConfig_t{.idleTimeout = std::chrono::milliseconds(10)}}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+
+    // Stopped with the header written but not the rest, that's not a broken packet, it's one that isn't finished yet
+    mpp.source().stop();
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(mpp.numPacketsProcessed(), 0);
+
+    oStream.write(reinterpret_cast<const char *>(generated.data() + halfPacket), generated.size() - halfPacket);
+    oStream.flush();
+    mpp.source().resume();
+
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(mpp.numPacketsProcessed(), NUM_PACKETS_TO_GENERATE);
+    EXPECT_EQ(mpp.sink().bytes(), fullRun.sink().bytes());
+  }
+
+  /**
+   * Same updates, once at UPDATE_SIZE and once padded out to random lengths. Reads are small, so padded updates
+   * (and their headers) get split across reads all the time
+   */
+  TEST(marketPacketProcessorTest, variableMatchesFixed)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 50;
+    constexpr const size_t READ_SIZE = 2 * marketPacket::UPDATE_SIZE;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.seed = 9}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, 20).has_value());
+    const std::vector<std::byte> &fixed = mpg.sink().bytes();
+
+    const std::vector<std::byte> variable = padUpdates(fixed, 9);
+
+    using processor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+
+    processor_t fixedRun{marketPacket::memorySource_t{fixed}, marketPacket::memorySink_t{}, READ_SIZE};
+    fixedRun.initialize();
+    ASSERT_EQ(fixedRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    processor_t variableRun{marketPacket::memorySource_t{variable}, marketPacket::memorySink_t{}, READ_SIZE};
+    variableRun.initialize();
+    ASSERT_FALSE(variableRun.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+    ASSERT_EQ(variableRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    EXPECT_FALSE(fixedRun.sink().bytes().empty());
+    EXPECT_EQ(variableRun.sink().bytes(), fixedRun.sink().bytes());
+
+    ASSERT_EQ(variableRun.symbolTable().size(), fixedRun.symbolTable().size());
+    for (marketPacket::symbolId_t symbolId = 0; symbolId < fixedRun.symbolTable().size(); symbolId++)
+    {
+      for (uint16_t priceLevel = 0; priceLevel < marketPacket::DEFAULT_MAX_PRICE_LEVEL; priceLevel++)
+      {
+        std::optional<marketPacket::priceLevel_t> expected = fixedRun.quoteBook().level(symbolId, priceLevel);
+        std::optional<marketPacket::priceLevel_t> actual = variableRun.quoteBook().level(symbolId, priceLevel);
+        ASSERT_EQ(actual.has_value(), expected.has_value());
+        if (expected.has_value())
+        {
+          EXPECT_EQ(actual->size, expected->size);
+          EXPECT_EQ(actual->timeOfDay, expected->timeOfDay);
+        }
+      }
+    }
+
+    // The index has to be able to walk them too
+    ASSERT_TRUE(std::ofstream(INPUT_PATH).write(reinterpret_cast<const char *>(variable.data()), variable.size()));
+    std::optional<marketPacket::packetIndex_t> index = marketPacket::packetIndex_t::build(INPUT_PATH, 8);
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->numPackets(), NUM_PACKETS_TO_GENERATE);
+
+    // A set other than the default never takes the fixed size fast path, so fixed packets are walked update by update
+    using walkingProcessor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t, marketPacket::variableSchemaSet_t>;
+    for (const std::vector<std::byte> *input : {&fixed, &variable})
+    {
+      walkingProcessor_t walkingRun{marketPacket::memorySource_t{*input}, marketPacket::memorySink_t{}, READ_SIZE};
+      walkingRun.initialize();
+      ASSERT_EQ(walkingRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(walkingRun.sink().bytes(), fixedRun.sink().bytes());
+    }
+
+    ASSERT_TRUE(std::ofstream(INPUT_PATH).write(reinterpret_cast<const char *>(fixed.data()), fixed.size()));
+    std::optional<marketPacket::packetIndex_t> walkedIndex = marketPacket::packetIndex_t::build<marketPacket::variableSchemaSet_t>(INPUT_PATH, 8);
+    ASSERT_TRUE(walkedIndex.has_value());
+    EXPECT_EQ(walkedIndex->numPackets(), NUM_PACKETS_TO_GENERATE);
+  }
+
+  /**
+   * A variable size packet whose updates don't add up to what the header says
+   */
+  TEST(marketPacketProcessorTest, variableUpdateCountMismatch)
+  {
+    std::vector<std::byte> bytes(sizeof(marketPacket::packetHeader_t) + 40);
+    marketPacket::packetHeader_t ph{static_cast<uint16_t>(bytes.size()), 2};
+    marketPacket::trade_t trade{.updateHeader = {40, marketPacket::updateType_e::TRADE}, .symbol = {'A', 'B', 'C', 'D', 'E'}};
+    std::memcpy(bytes.data(), &ph, sizeof(ph));
+    std::memcpy(bytes.data() + sizeof(ph), &trade, sizeof(trade));
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::memorySource_t{bytes}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::UPDATE_POORLY_FORMED);
+  }
+
+  /**
+   * Batches should hold exactly what the text output was made from, fixed size, variable size and compact alike
+   */
+  TEST(marketPacketProcessorTest, batchMatchesText)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 120;
+    constexpr const size_t PACKETS_PER_BATCH = 16;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.seed = 11}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, 30).has_value());
+    const std::vector<std::byte> fixed = mpg.sink().bytes();
+    const std::vector<std::byte> variable = padUpdates(fixed, 11);
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> compactMpg{
+        marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.seed = 11, .wireFormat = marketPacket::wireFormat_e::COMPACT}};
+    compactMpg.initialize();
+    ASSERT_FALSE(compactMpg.generatePackets(NUM_PACKETS_TO_GENERATE, 30).has_value());
+    const std::vector<std::byte> compact = compactMpg.sink().bytes();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> textRun{
+        marketPacket::memorySource_t{fixed}, marketPacket::memorySink_t{}};
+    textRun.initialize();
+    ASSERT_EQ(textRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+    const std::string expectedText(reinterpret_cast<const char *>(textRun.sink().bytes().data()), textRun.sink().bytes().size());
+
+    for (const std::vector<std::byte> *capture : {&fixed, &variable, &compact})
+    {
+      // Small reads so variable updates straddle them
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::nullSink_t> mpp{
+          marketPacket::memorySource_t{*capture}, marketPacket::nullSink_t{}, 2 * marketPacket::UPDATE_SIZE};
+      mpp.initialize();
+
+      std::string batchedText;
+      size_t numPackets = 0;
+      size_t numQuotes = 0;
+      bool lastBatch = false;
+      while (!lastBatch)
+      {
+        // Only the last batch comes up short, and that's when we hit the end
+        const std::optional<marketPacket::failReason_t> &failReason = mpp.decodeBatch(PACKETS_PER_BATCH);
+        lastBatch = failReason.has_value();
+        EXPECT_EQ(failReason.value_or(marketPacket::END_OF_FILE), marketPacket::END_OF_FILE);
+        EXPECT_EQ(mpp.batch().numPackets == PACKETS_PER_BATCH, !lastBatch);
+
+        const marketPacket::updateBatch_t batch = mpp.batch();
+        ASSERT_EQ(batch.trades.size(), batch.tradeSymbolIds.size());
+        ASSERT_EQ(batch.quotes.size(), batch.quoteSymbolIds.size());
+
+        for (size_t trade = 0; trade < batch.trades.size(); trade++)
+        {
+          EXPECT_EQ(std::memcmp(mpp.symbolTable().symbol(batch.tradeSymbolIds[trade]).data(), batch.trades[trade]->symbol, marketPacket::SYMBOL_LENGTH), 0);
+
+          char line[marketPacket::MAX_TRADE_STRING_LENGTH];
+          batchedText.append(line, marketPacket::formatTrade(line, batch.trades[trade]));
+        }
+
+        numPackets += batch.numPackets;
+        numQuotes += batch.quotes.size();
+      }
+
+      EXPECT_EQ(numPackets, NUM_PACKETS_TO_GENERATE);
+      EXPECT_GT(numQuotes, 0);
+      EXPECT_EQ(batchedText, expectedText);
+    }
+  }
+
+  /**
+   * Same seed compact and raw should be the same updates, a lot smaller, and process and index exactly the same
+   */
+  TEST(marketPacketProcessorTest, compactMatchesRaw)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 500;
+    constexpr const size_t NUM_MAX_UPDATES = 200;
+
+    marketPacket::generatorConfig_t config{.poolSize = 8192, .numSymbols = 500, .seed = 11};
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> raw(marketPacket::memorySink_t{}, config);
+    raw.initialize();
+    ASSERT_FALSE(raw.generatePackets(NUM_PACKETS_TO_GENERATE, NUM_MAX_UPDATES).has_value());
+
+    config.wireFormat = marketPacket::wireFormat_e::COMPACT;
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> compact(marketPacket::memorySink_t{}, config);
+    compact.initialize();
+    ASSERT_FALSE(compact.generatePackets(NUM_PACKETS_TO_GENERATE, NUM_MAX_UPDATES).has_value());
+
+    EXPECT_LT(3 * compact.sink().bytes().size(), raw.sink().bytes().size());
+
+    // Small reads, so a compact body is always bigger than what a raw packet would ask for at once
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> rawRun{
+        marketPacket::memorySource_t{raw.sink().bytes()}, marketPacket::memorySink_t{}, 256};
+    rawRun.initialize();
+    ASSERT_EQ(rawRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> compactRun{
+        marketPacket::memorySource_t{compact.sink().bytes()}, marketPacket::memorySink_t{}, 256};
+    compactRun.initialize();
+    ASSERT_FALSE(compactRun.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+    ASSERT_EQ(compactRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    EXPECT_FALSE(rawRun.sink().bytes().empty());
+    EXPECT_EQ(compactRun.sink().bytes(), rawRun.sink().bytes());
+    EXPECT_EQ(compactRun.symbolTable().size(), rawRun.symbolTable().size());
+
+    // Every packet, and the time range of each entry, has to be found through the compact bodies too
+    ASSERT_TRUE(std::ofstream(INPUT_PATH).write(reinterpret_cast<const char *>(raw.sink().bytes().data()), raw.sink().bytes().size()));
+    ASSERT_TRUE(std::ofstream(COMPACT_INPUT_PATH).write(reinterpret_cast<const char *>(compact.sink().bytes().data()), compact.sink().bytes().size()));
+
+    std::optional<marketPacket::packetIndex_t> rawIndex = marketPacket::packetIndex_t::build(INPUT_PATH, 16);
+    std::optional<marketPacket::packetIndex_t> compactIndex = marketPacket::packetIndex_t::build(COMPACT_INPUT_PATH, 16);
+    ASSERT_TRUE(rawIndex.has_value() && compactIndex.has_value());
+    EXPECT_EQ(compactIndex->numPackets(), NUM_PACKETS_TO_GENERATE);
+    ASSERT_EQ(compactIndex->entries().size(), rawIndex->entries().size());
+
+    for (size_t entry = 0; entry < rawIndex->entries().size(); entry++)
+    {
+      EXPECT_EQ(compactIndex->entries()[entry].minTimeOfDay, rawIndex->entries()[entry].minTimeOfDay);
+      EXPECT_EQ(compactIndex->entries()[entry].maxTimeOfDay, rawIndex->entries()[entry].maxTimeOfDay);
+    }
+  }
+
+  /**
+   * Compact bodies are read in one go, and with thousands of symbols they come out bigger than a uring chunk
+   */
+  TEST(marketPacketProcessorTest, compactThroughUring)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 100;
+
+    marketPacket::generatorConfig_t config{.poolSize = 65536, .numSymbols = 2000, .zipfExponent = 0, .seed = 17, .wireFormat = marketPacket::wireFormat_e::COMPACT};
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg(marketPacket::memorySink_t{}, config);
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    const std::vector<std::byte> &compact = mpg.sink().bytes();
+
+    // Make sure there's actually a packet that doesn't fit in a chunk
+    size_t biggestPacket = 0;
+    for (size_t offset = 0; offset < compact.size();)
+    {
+      marketPacket::packetHeader_t ph;
+      std::memcpy(&ph, compact.data() + offset, sizeof(ph));
+      biggestPacket = std::max<size_t>(biggestPacket, ph.packetLength);
+      offset += ph.packetLength;
+    }
+    ASSERT_GT(biggestPacket, marketPacket::READ_BUFFER_SIZE);
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> memoryRun{
+        marketPacket::memorySource_t{compact}, marketPacket::memorySink_t{}};
+    memoryRun.initialize();
+    ASSERT_EQ(memoryRun.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    ASSERT_TRUE(std::ofstream(COMPACT_INPUT_PATH).write(reinterpret_cast<const char *>(compact.data()), compact.size()));
+
+    for (marketPacket::ioBackend_e backend : {marketPacket::ioBackend_e::BLOCKING, marketPacket::ioBackend_e::URING})
+    {
+      const marketPacket::ioConfig_t ioConfig{.backend = backend, .chunkSize = marketPacket::READ_BUFFER_SIZE, .queueDepth = 3};
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::uringSource_t, marketPacket::memorySink_t> mpp(
+          marketPacket::uringSource_t{COMPACT_INPUT_PATH, ioConfig}, marketPacket::memorySink_t{});
+      mpp.initialize();
+
+      ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+      ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+      EXPECT_EQ(mpp.sink().bytes(), memoryRun.sink().bytes());
+    }
+  }
+
+  /**
+   * Once a processor has seen every packet size and symbol it's going to, processing doesn't touch the heap at all.
+   * Each capture is played twice over, the first time through warms everything up
+   */
+  TEST(marketPacketProcessorTest, steadyStateDoesNotAllocate)
+  {
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 200;
+
+    const marketPacket::generatorConfig_t config{.poolSize = 1024, .numSymbols = 100, .seed = 13};
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}, config};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, 300).has_value());
+    const std::vector<std::byte> fixed = mpg.sink().bytes();
+    const std::vector<std::byte> variable = padUpdates(fixed, 13);
+
+    marketPacket::generatorConfig_t compactConfig = config;
+    compactConfig.wireFormat = marketPacket::wireFormat_e::COMPACT;
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> compactMpg{marketPacket::memorySink_t{}, compactConfig};
+    compactMpg.initialize();
+    ASSERT_FALSE(compactMpg.generatePackets(NUM_PACKETS_TO_GENERATE, 300).has_value());
+    const std::vector<std::byte> compact = compactMpg.sink().bytes();
+
+    for (const std::vector<std::byte> *capture : {&fixed, &variable, &compact})
+    {
+      std::vector<std::byte> twice(*capture);
+      twice.insert(twice.end(), capture->begin(), capture->end());
+
+      // Small reads so variable updates straddle them
+      marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::nullSink_t> mpp{
+          marketPacket::memorySource_t{twice}, marketPacket::nullSink_t{}, 4 * marketPacket::UPDATE_SIZE};
+      mpp.initialize();
+      ASSERT_FALSE(mpp.processNextPacket(NUM_PACKETS_TO_GENERATE).has_value());
+
+      const size_t arenaAllocations = mpp.arena().numHeapAllocations();
+      const size_t allocationsBefore = numGlobalAllocations.load(std::memory_order_relaxed);
+      const std::optional<marketPacket::failReason_t> failReason = mpp.processNextPacket();
+      const size_t allocationsAfter = numGlobalAllocations.load(std::memory_order_relaxed);
+
+      EXPECT_EQ(failReason.value_or(marketPacket::INVALID_STATE), marketPacket::END_OF_FILE);
+      EXPECT_EQ(mpp.numPacketsProcessed(), NUM_PACKETS_TO_GENERATE);
+      EXPECT_EQ(mpp.arena().numHeapAllocations(), arenaAllocations);
+      EXPECT_EQ(allocationsAfter, allocationsBefore);
+    }
+
+    // The generator's scratch is the same story
+    const size_t allocationsBefore = numGlobalAllocations.load(std::memory_order_relaxed);
+    const std::optional<marketPacket::failReason_t> failReason = compactMpg.generatePackets(1, 300);
+    const size_t allocationsAfter = numGlobalAllocations.load(std::memory_order_relaxed);
+    ASSERT_FALSE(failReason.has_value());
+
+    // Bar the bytes written going into the memory sink
+    EXPECT_LE(allocationsAfter - allocationsBefore, 1);
+  }
+}
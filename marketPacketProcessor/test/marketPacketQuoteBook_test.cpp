@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "marketPacketProcessor/marketPacketQuoteBook.h"
+
+namespace test
+{
+  /**
+   * @brief Create a quote with the fields the book cares about
+   */
+  marketPacket::quote_t createQuote(uint16_t priceLevel, uint64_t priceLevelSize, uint64_t timeOfDay)
+  {
+    return marketPacket::quote_t{
+        .updateHeader = {marketPacket::UPDATE_SIZE, marketPacket::updateType_e::QUOTE},
+        .priceLevel = priceLevel,
+        .priceLevelSize = priceLevelSize,
+        .timeOfDay = timeOfDay};
+  }
+
+  TEST(marketPacketQuoteBookTest, emptyBook)
+  {
+    marketPacket::quoteBook_t book;
+
+    EXPECT_EQ(book.numBooks(), 0);
+    EXPECT_FALSE(book.level(0, 0).has_value());
+  }
+
+  TEST(marketPacketQuoteBookTest, levelsAreIndependent)
+  {
+    marketPacket::quoteBook_t book;
+
+    marketPacket::quote_t low = createQuote(1, 10, 100);
+    marketPacket::quote_t high = createQuote(1000, 20, 200);
+    book.applyQuote(&low, 0);
+    book.applyQuote(&high, 0);
+
+    EXPECT_EQ(book.numBooks(), 1);
+    EXPECT_EQ(book.level(0, 1)->size, 10);
+    EXPECT_EQ(book.level(0, 1000)->size, 20);
+    EXPECT_EQ(book.level(0, 1000)->timeOfDay, 200);
+
+    // Levels in between exist, they just haven't been quoted
+    EXPECT_EQ(book.level(0, 500)->size, 0);
+    EXPECT_FALSE(book.level(0, std::numeric_limits<uint16_t>::max()).has_value());
+  }
+
+  TEST(marketPacketQuoteBookTest, symbolsAreIndependent)
+  {
+    marketPacket::quoteBook_t book;
+
+    for (uint64_t i = 1; i <= 3; i++)
+    {
+      marketPacket::quote_t first = createQuote(7, i, i);
+      marketPacket::quote_t second = createQuote(7, 10 * i, i);
+      book.applyQuote(&first, 0);
+      book.applyQuote(&second, 2);
+    }
+
+    EXPECT_EQ(book.numBooks(), 3);
+    EXPECT_EQ(book.level(0, 7)->size, 3);
+    EXPECT_EQ(book.level(2, 7)->size, 30);
+    EXPECT_FALSE(book.level(1, 7).has_value());
+  }
+
+  TEST(marketPacketQuoteBookTest, zeroSizeClearsLevel)
+  {
+    marketPacket::quoteBook_t book;
+
+    marketPacket::quote_t add = createQuote(4, 50, 1);
+    marketPacket::quote_t remove = createQuote(4, 0, 2);
+    book.applyQuote(&add, 0);
+    book.applyQuote(&remove, 0);
+
+    EXPECT_EQ(book.level(0, 4)->size, 0);
+    EXPECT_EQ(book.level(0, 4)->timeOfDay, 2);
+  }
+}
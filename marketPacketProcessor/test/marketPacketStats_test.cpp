@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <type_traits>
+
+#include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketProcessor/marketPacketProcessor.h"
+#include "marketPacketProcessor/marketPacketStats.h"
+
+namespace test
+{
+  TEST(marketPacketStatsTest, bucketsCoverEverything)
+  {
+    using histogram_t = marketPacket::latencyHistogram_t;
+
+    // Small values are exact
+    for (uint64_t value = 0; value < histogram_t::EXACT_BUCKETS; value++)
+    {
+      EXPECT_EQ(histogram_t::bucketIndex(value), value);
+      EXPECT_EQ(histogram_t::bucketUpperBound(value), value);
+    }
+
+    // Everything else lands in a bucket that holds it, and isn't too wide
+    for (uint64_t value : {uint64_t{32}, uint64_t{33}, uint64_t{1000}, uint64_t{123456789}, uint64_t{1} << 40, UINT64_MAX})
+    {
+      const size_t bucket = histogram_t::bucketIndex(value);
+      ASSERT_LT(bucket, histogram_t::NUM_BUCKETS);
+      EXPECT_GE(histogram_t::bucketUpperBound(bucket), value);
+      EXPECT_LT(histogram_t::bucketUpperBound(bucket - 1), value);
+      EXPECT_LE(histogram_t::bucketUpperBound(bucket) - value, value / histogram_t::SUB_BUCKETS) << value;
+    }
+
+    EXPECT_EQ(histogram_t::bucketIndex(UINT64_MAX), histogram_t::NUM_BUCKETS - 1);
+  }
+
+  TEST(marketPacketStatsTest, percentiles)
+  {
+    marketPacket::latencyHistogram_t histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+
+    for (uint64_t value = 1; value <= 10000; value++)
+    {
+      histogram.record(value);
+    }
+
+    EXPECT_EQ(histogram.count(), 10000);
+    EXPECT_EQ(histogram.min(), 1);
+    EXPECT_EQ(histogram.max(), 10000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5000.5);
+
+    // Within a bucket of the real answer
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(50)), 5000, 5000 / marketPacket::latencyHistogram_t::SUB_BUCKETS);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(99)), 9900, 9900 / marketPacket::latencyHistogram_t::SUB_BUCKETS);
+    EXPECT_EQ(histogram.percentile(100), 10000);
+    EXPECT_EQ(histogram.percentile(0), 1);
+
+    marketPacket::latencyHistogram_t other;
+    other.record(1000000);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.count(), 10001);
+    EXPECT_EQ(histogram.max(), 1000000);
+    EXPECT_EQ(histogram.percentile(100), 1000000);
+  }
+
+  /**
+   * Counts only show up when the stats are compiled in, and cost nothing when they aren't
+   */
+  TEST(marketPacketStatsTest, processorStats)
+  {
+    static_assert(std::is_empty_v<marketPacket::statsRecorder_t<false>>);
+
+    constexpr const size_t NUM_PACKETS_TO_GENERATE = 100;
+
+    marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t> mpg{marketPacket::memorySink_t{}};
+    mpg.initialize();
+    ASSERT_FALSE(mpg.generatePackets(NUM_PACKETS_TO_GENERATE, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    const std::vector<std::byte> &generated = mpg.sink().bytes();
+
+    marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t> mpp{
+        marketPacket::memorySource_t{generated}, marketPacket::memorySink_t{}};
+    mpp.initialize();
+    ASSERT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+
+    const marketPacket::processorStats_t stats = mpp.stats();
+    if constexpr (marketPacket::STATS_ENABLED)
+    {
+      EXPECT_EQ(stats.packets, NUM_PACKETS_TO_GENERATE);
+      EXPECT_EQ(stats.bytes, generated.size());
+      EXPECT_EQ(stats.packetCycles.count(), NUM_PACKETS_TO_GENERATE);
+      EXPECT_GT(stats.trades, 0);
+      EXPECT_GT(stats.quotes, 0);
+      EXPECT_EQ(stats.stateVisits[static_cast<size_t>(marketPacket::timedState_e::READ_HEADER)], NUM_PACKETS_TO_GENERATE);
+      EXPECT_GE(stats.stateVisits[static_cast<size_t>(marketPacket::timedState_e::WRITE_UPDATES)], NUM_PACKETS_TO_GENERATE);
+
+      mpp.resetStats();
+      EXPECT_EQ(mpp.stats().packets, 0);
+    }
+    else
+    {
+      EXPECT_EQ(stats.packets, 0);
+      EXPECT_EQ(stats.bytes, 0);
+      EXPECT_EQ(stats.packetCycles.count(), 0);
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "marketPacketGenerator/marketPacketGenerator.h"
+#include "marketPacketProcessor/marketPacketProcessor.h"
+#include "marketPacketProcessor/marketPacketStreamEngine.h"
+
+namespace test
+{
+  using memoryGenerator_t = marketPacket::basicMarketPacketGenerator_t<marketPacket::memorySink_t>;
+  using memoryProcessor_t = marketPacket::basicMarketPacketProcessor_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+  using memoryEngine_t = marketPacket::marketPacketStreamEngine_t<marketPacket::memorySource_t, marketPacket::memorySink_t>;
+
+  std::vector<std::byte> generateCapture(size_t numPackets, uint64_t seed)
+  {
+    memoryGenerator_t mpg(marketPacket::memorySink_t{}, marketPacket::generatorConfig_t{.poolSize = 4096, .seed = seed});
+    mpg.initialize();
+
+    EXPECT_FALSE(mpg.generatePackets(numPackets, marketPacket::MAX_UPDATES_ALLOWED_IN_PACKET).has_value());
+    return mpg.sink().bytes();
+  }
+
+  std::vector<std::byte> processSerially(const std::vector<std::byte> &capture)
+  {
+    memoryProcessor_t mpp(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{});
+    mpp.initialize();
+
+    EXPECT_EQ(mpp.processNextPacket().value(), marketPacket::END_OF_FILE);
+    return mpp.sink().bytes();
+  }
+
+  TEST(marketPacketStreamEngineTest, noStreams)
+  {
+    memoryEngine_t engine(4);
+    engine.run();
+
+    EXPECT_EQ(engine.numStreams(), 0);
+  }
+
+  /**
+   * One hot stream and plenty of small ones, with tiny slices so streams bounce between workers a lot
+   */
+  TEST(marketPacketStreamEngineTest, matchesSerial)
+  {
+    constexpr const size_t NUM_STREAMS = 12;
+
+    std::vector<std::vector<std::byte>> captures;
+    std::vector<size_t> numPackets;
+    for (size_t i = 0; i < NUM_STREAMS; i++)
+    {
+      numPackets.push_back(i == 0 ? 2000 : 50 + 10 * i);
+      captures.push_back(generateCapture(numPackets.back(), i));
+    }
+
+    for (size_t numThreads : {1, 3, 8})
+    {
+      memoryEngine_t engine(numThreads, 4);
+      for (const std::vector<std::byte> &capture : captures)
+      {
+        engine.addStream(marketPacket::memorySource_t{capture}, marketPacket::memorySink_t{});
+      }
+
+      engine.run();
+
+      for (size_t i = 0; i < NUM_STREAMS; i++)
+      {
+        const marketPacket::streamStats_t &stats = engine.stats(i);
+        EXPECT_EQ(stats.failReason.value(), marketPacket::END_OF_FILE);
+        EXPECT_EQ(stats.numPackets, numPackets[i]);
+        EXPECT_GE(stats.numSlices, numPackets[i] / 4);
+        EXPECT_GT(stats.packetsPerSecond(), 0);
+        EXPECT_EQ(engine.processor(i).sink().bytes(), processSerially(captures[i])) << numThreads << " threads, stream " << i;
+      }
+    }
+  }
+
+  TEST(marketPacketStreamEngineTest, badStreamDoesntStopOthers)
+  {
+    const std::vector<std::byte> good = generateCapture(100, 1);
+
+    // Chop the last packet in half
+    std::vector<std::byte> truncated = generateCapture(100, 2);
+    truncated.resize(truncated.size() - marketPacket::UPDATE_SIZE / 2);
+
+    memoryEngine_t engine(2, 8);
+    const size_t goodId = engine.addStream(marketPacket::memorySource_t{good}, marketPacket::memorySink_t{});
+    const size_t truncatedId = engine.addStream(marketPacket::memorySource_t{truncated}, marketPacket::memorySink_t{});
+    engine.run();
+
+    EXPECT_EQ(engine.stats(goodId).failReason.value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(engine.stats(goodId).numPackets, 100);
+
+    EXPECT_NE(engine.stats(truncatedId).failReason.value(), marketPacket::END_OF_FILE);
+    EXPECT_EQ(engine.stats(truncatedId).numPackets, 99);
+
+    // Finished streams are left alone on later runs
+    const size_t lateId = engine.addStream(marketPacket::memorySource_t{good}, marketPacket::memorySink_t{});
+    engine.run();
+
+    EXPECT_EQ(engine.stats(goodId).numPackets, 100);
+    EXPECT_EQ(engine.stats(lateId).numPackets, 100);
+    EXPECT_EQ(engine.processor(lateId).sink().bytes(), engine.processor(goodId).sink().bytes());
+  }
+}